@@ -10,5 +10,6 @@ namespace org.critterai.nav.rcn {
         public IntPtr mTris;
         public int mTriCount;
         public int mMaxTrisPerChunk;
+        public IntPtr mMapping;
     }
 }
@@ -54,6 +54,17 @@ namespace org.critterai.nav
         /// <summary>
         /// The agent is traversing an off-mesh connection.
         /// </summary>
-        OffMesh
+        OffMesh,
+
+        /// <summary>
+        /// The agent was removed from the crowd.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Not a crowd state.  Only reported by the <see cref="CrowdManager"/> update that 
+        /// reports the agents that changed.
+        /// </para>
+        /// </remarks>
+        Inactive = 0xff
     }
 }
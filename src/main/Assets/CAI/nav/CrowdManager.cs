@@ -101,6 +101,7 @@ namespace org.critterai.nav
 
         private float mMaxAgentRadius;
         private Navmesh mNavmesh;
+        private IntPtr mJobs = IntPtr.Zero;
         
         internal CrowdAgent[] mAgents;
         // Needs to be a separate array since it is used as an argument
@@ -252,6 +253,12 @@ namespace org.critterai.nav
                     mAgents[i] = null;
                 }
 
+                if (mJobs != IntPtr.Zero)
+                {
+                    CrowdManagerEx.dtcJobSystemFree(mJobs);
+                    mJobs = IntPtr.Zero;
+                }
+
                 CrowdManagerEx.dtcDetourCrowdFree(root);
                 root = IntPtr.Zero;
             }
@@ -367,6 +374,34 @@ namespace org.critterai.nav
             }
         }
 
+        /// <summary>
+        /// Sets the number of threads used by <see cref="Update"/>.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The per-agent work of the update is spread over the threads.  Path requests are
+        /// still processed on the calling thread.  The result is the same as a single threaded
+        /// update.
+        /// </para>
+        /// </remarks>
+        /// <param name="threadCount">
+        /// The number of threads, including the calling thread. (One per core if &lt;= 0.)
+        /// </param>
+        public void SetThreadCount(int threadCount)
+        {
+            if (IsDisposed)
+                return;
+
+            if (mJobs != IntPtr.Zero)
+            {
+                CrowdManagerEx.dtcJobSystemFree(mJobs);
+                mJobs = IntPtr.Zero;
+            }
+
+            if (threadCount != 1)
+                mJobs = CrowdManagerEx.dtcJobSystemAlloc(threadCount);
+        }
+
         /// <summary>
         /// Updates the steering and positions for all agents.
         /// </summary>
@@ -376,7 +411,57 @@ namespace org.critterai.nav
             if (IsDisposed)
                 return;
 
-            CrowdManagerEx.dtcUpdate(root, deltaTime, agentStates);
+            if (mJobs == IntPtr.Zero)
+                CrowdManagerEx.dtcUpdate(root, deltaTime, agentStates);
+            else
+                CrowdManagerEx.dtcUpdateParallel(root, deltaTime, agentStates, mJobs);
+        }
+
+        /// <summary>
+        /// Updates the steering and positions for all agents, reporting only the agents that
+        /// changed.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The arrays are indexed by agent index (<see cref="CrowdAgent"/> order in the manager)
+        /// and must be reused between calls, since changes are detected against their current
+        /// content.  Only the entries of active agents that moved or changed state are written,
+        /// so idle agents cost nothing to marshal.
+        /// </para>
+        /// <para>
+        /// An agent removed since the last call is reported once, with the state 
+        /// <see cref="CrowdAgentState.Inactive"/>.  Its position and velocity are not written.
+        /// </para>
+        /// <para>
+        /// The per-agent core data (e.g. <see cref="CrowdAgent.Position"/>) is not refreshed by
+        /// this method.
+        /// </para>
+        /// </remarks>
+        /// <param name="deltaTime">The time in seconds to update the simulation.</param>
+        /// <param name="positions">The agent positions. [Length: >= <see cref="MaxAgents"/>]</param>
+        /// <param name="velocities">The agent velocities. [Length: >= <see cref="MaxAgents"/>]</param>
+        /// <param name="states">The agent states. [Length: >= <see cref="MaxAgents"/>]</param>
+        /// <param name="dirtyAgents">
+        /// The indices of the agents that changed. [Length: >= <see cref="MaxAgents"/>]
+        /// </param>
+        /// <returns>The number of agents that changed, or -1 on error.</returns>
+        public int Update(float deltaTime
+            , Vector3[] positions
+            , Vector3[] velocities
+            , CrowdAgentState[] states
+            , int[] dirtyAgents)
+        {
+            if (IsDisposed
+                || positions == null || positions.Length < MaxAgents
+                || velocities == null || velocities.Length < MaxAgents
+                || states == null || states.Length < MaxAgents
+                || dirtyAgents == null || dirtyAgents.Length < MaxAgents)
+            {
+                return -1;
+            }
+
+            return CrowdManagerEx.dtcUpdateAgentStates(root
+                , deltaTime, mJobs, positions, velocities, states, dirtyAgents);
         }
 
         /// <summary>
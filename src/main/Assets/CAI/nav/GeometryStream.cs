@@ -0,0 +1,89 @@
+using System;
+using org.critterai.nav.rcn;
+
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+
+namespace org.critterai.nav {
+    /// <summary>
+    /// Chunked input geometry read from disk as a tile cache build needs it.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Only the chunk table is held in memory.  Use with <see cref="TileCache.CreateStreamed"/>
+    /// to build worlds whose geometry does not fit in memory.  Files are written with
+    /// <see cref="GeometryStreamWriter"/>.
+    /// </para>
+    /// </remarks>
+    public sealed class GeometryStream {
+        internal IntPtr root;
+
+        private GeometryStream(IntPtr root) {
+            this.root = root;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~GeometryStream() {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed {
+            get { return root == IntPtr.Zero; }
+        }
+
+        /// <summary>
+        /// Closes the file.
+        /// </summary>
+        public void RequestDisposal() {
+            if (root != IntPtr.Zero) {
+                GeometryStreamEx.dtgsFree(root);
+                root = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// The number of chunks in the file.
+        /// </summary>
+        public int ChunkCount {
+            get { return IsDisposed ? 0 : GeometryStreamEx.dtgsGetChunkCount(root); }
+        }
+
+        /// <summary>
+        /// Gets the bounds of all of the geometry in the file.
+        /// </summary>
+        /// <param name="bmin">The minimum bounds.</param>
+        /// <param name="bmax">The maximum bounds.</param>
+        public void GetBounds(out Vector3 bmin, out Vector3 bmax) {
+            bmin = new Vector3();
+            bmax = new Vector3();
+            if (!IsDisposed)
+                GeometryStreamEx.dtgsGetBounds(root, ref bmin, ref bmax);
+        }
+
+        /// <summary>
+        /// Opens a geometry file.
+        /// </summary>
+        /// <param name="path">The path of the file.</param>
+        /// <param name="stream">The open file. (Null on failure.)</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus Open(string path, out GeometryStream stream) {
+            stream = null;
+            if (path == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr root = IntPtr.Zero;
+            NavStatus status = GeometryStreamEx.dtgsOpen(path, ref root);
+            if ((status & NavStatus.Sucess) != 0)
+                stream = new GeometryStream(root);
+            return status;
+        }
+    }
+}
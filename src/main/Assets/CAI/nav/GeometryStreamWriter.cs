@@ -0,0 +1,101 @@
+using System;
+using org.critterai.geom;
+using org.critterai.nav.rcn;
+
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+
+namespace org.critterai.nav {
+    /// <summary>
+    /// Writes input geometry to a <see cref="GeometryStream"/> file one chunk at a time.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Chunks should be spatially compact, for example one per scene cell.  A streamed build
+    /// loads a chunk for the first tile that overlaps it and frees it after the last, so large
+    /// chunks keep more geometry in memory and are scanned by more tiles.
+    /// </para>
+    /// <para>
+    /// The file is not valid until <see cref="Close"/> is called.
+    /// </para>
+    /// </remarks>
+    public sealed class GeometryStreamWriter {
+        private IntPtr root;
+
+        private GeometryStreamWriter(IntPtr root) {
+            this.root = root;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~GeometryStreamWriter() {
+            if (!IsClosed)
+                Close();
+        }
+
+        /// <summary>
+        /// True if the writer has been closed.
+        /// </summary>
+        public bool IsClosed {
+            get { return root == IntPtr.Zero; }
+        }
+
+        /// <summary>
+        /// Creates a geometry file, replacing any existing file.
+        /// </summary>
+        /// <param name="path">The path of the file.</param>
+        /// <returns>The writer, or null if the file could not be created.</returns>
+        public static GeometryStreamWriter Create(string path) {
+            if (path == null)
+                return null;
+            IntPtr root = GeometryStreamEx.dtgsCreateWriter(path);
+            return root == IntPtr.Zero ? null : new GeometryStreamWriter(root);
+        }
+
+        /// <summary>
+        /// Appends a chunk.
+        /// </summary>
+        /// <param name="mesh">The chunk geometry.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus WriteChunk(TriangleMesh mesh) {
+            if (mesh == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return WriteChunk(mesh.verts, mesh.vertCount, mesh.tris, mesh.triCount);
+        }
+
+        /// <summary>
+        /// Appends a chunk.
+        /// </summary>
+        /// <param name="verts">The chunk vertices. [Length: &gt;= vertCount]</param>
+        /// <param name="vertCount">The number of vertices.</param>
+        /// <param name="tris">
+        /// The chunk triangles, indexing <paramref name="verts"/>. [Length: &gt;= triCount * 3]
+        /// </param>
+        /// <param name="triCount">The number of triangles.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus WriteChunk(Vector3[] verts, int vertCount, int[] tris, int triCount) {
+            if (IsClosed || verts == null || tris == null
+                || vertCount <= 0 || verts.Length < vertCount
+                || triCount <= 0 || tris.Length < triCount * 3) {
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            }
+            return GeometryStreamEx.dtgsWriteChunk(root, verts, vertCount, tris, triCount);
+        }
+
+        /// <summary>
+        /// Finishes and closes the file.
+        /// </summary>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Close() {
+            if (IsClosed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            NavStatus status = GeometryStreamEx.dtgsCloseWriter(root);
+            root = IntPtr.Zero;
+            return status;
+        }
+    }
+}
@@ -0,0 +1,175 @@
+﻿using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// A tile level graph of a navigation mesh that speeds up long distance path finding.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The graph links the entrances between neighbouring tiles and stores the cost of 
+    /// crossing each tile.  <see cref="FindPath"/> searches the graph first, then refines the 
+    /// result a few tiles at a time, so the query's node pool only has to hold a few tiles' 
+    /// worth of nodes however long the path is.  The path is close to, but not always as short 
+    /// as, the one <see cref="NavmeshQuery.FindPath(NavmeshPoint, NavmeshPoint, NavmeshQueryFilter, uint[], out int)"/> 
+    /// finds.
+    /// </para>
+    /// <para>
+    /// The graph does not track the navigation mesh.  Call <see cref="Update"/> after adding or 
+    /// removing tiles, or changing polygon flags or areas.  Paths through tiles that changed 
+    /// since the last update are found without the graph.
+    /// </para>
+    /// <para>
+    /// <see cref="FindPath"/> may be called from several threads at once, each with its own 
+    /// query.  <see cref="Update"/> must not overlap with any other use of the object.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class NavmeshHierarchy
+        : ManagedObject
+    {
+        internal IntPtr root;
+
+        private NavmeshHierarchy(IntPtr hierarchy)
+            : base(AllocType.External)
+        {
+            root = hierarchy;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~NavmeshHierarchy()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        public override void RequestDisposal()
+        {
+            if (root != IntPtr.Zero)
+            {
+                NavmeshQueryEx.dtnhFree(root);
+                root = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public override bool IsDisposed
+        {
+            get { return (root == IntPtr.Zero); }
+        }
+
+        /// <summary>
+        /// The number of entrances in the graph.
+        /// </summary>
+        public int NodeCount
+        {
+            get { return (IsDisposed ? 0 : NavmeshQueryEx.dtnhGetNodeCount(root)); }
+        }
+
+        /// <summary>
+        /// Rebuilds the graph for the tiles added, removed, or with polygon flags or areas changed 
+        /// since the last update, and for their neighbours.
+        /// </summary>
+        /// <param name="rebuiltCount">The number of tiles rebuilt.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Update(out int rebuiltCount)
+        {
+            rebuiltCount = 0;
+
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            return NavmeshQueryEx.dtnhUpdate(root, ref rebuiltCount);
+        }
+
+        /// <summary>
+        /// Finds the polygon path from the start to the end polygon.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Behaves like 
+        /// <see cref="NavmeshQuery.FindPath(NavmeshPoint, NavmeshPoint, NavmeshQueryFilter, uint[], out int)"/>, 
+        /// which is used directly when the start and end are on the same or neighbouring 
+        /// tiles.
+        /// </para>
+        /// <para>
+        /// The filter decides which polygons the path may use.  The graph costs come from the 
+        /// filter the hierarchy was created with.
+        /// </para>
+        /// </remarks>
+        /// <param name="query">The query to refine the path with.</param>
+        /// <param name="start">A point within the start polygon.</param>
+        /// <param name="end">A point within the end polygon.</param>
+        /// <param name="filter">The filter to apply to the query.</param>
+        /// <param name="resultPath">
+        /// An ordered list of polygon references in the path. (Start to end.) (Out) 
+        /// [(polyRef) * pathCount]
+        /// </param>
+        /// <param name="pathCount">The number of polygons in the path.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
+        public NavStatus FindPath(NavmeshQuery query
+            , NavmeshPoint start, NavmeshPoint end
+            , NavmeshQueryFilter filter
+            , uint[] resultPath, out int pathCount)
+        {
+            pathCount = 0;
+
+            if (IsDisposed
+                || query == null || query.IsDisposed
+                || filter == null
+                || resultPath == null)
+            {
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            }
+
+            return NavmeshQueryEx.dtnhFindPath(root
+                , query.root
+                , start
+                , end
+                , filter.root
+                , resultPath
+                , ref pathCount
+                , resultPath.Length);
+        }
+
+        /// <summary>
+        /// Builds the hierarchy for every tile in a navigation mesh.
+        /// </summary>
+        /// <param name="navmesh">The navigation mesh.</param>
+        /// <param name="filter">
+        /// The filter that decides which polygons the graph uses and sets its costs.  (Copied.)
+        /// </param>
+        /// <param name="resultHierarchy">The hierarchy, or null on failure.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus Create(Navmesh navmesh
+            , NavmeshQueryFilter filter
+            , out NavmeshHierarchy resultHierarchy)
+        {
+            resultHierarchy = null;
+
+            if (navmesh == null || navmesh.IsDisposed || filter == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr hierarchy = IntPtr.Zero;
+
+            NavStatus status = NavmeshQueryEx.dtnhAlloc(navmesh.root
+                , filter.root
+                , ref hierarchy);
+
+            if (NavUtil.Succeeded(status))
+                resultHierarchy = new NavmeshHierarchy(hierarchy);
+
+            return status;
+        }
+    }
+}
@@ -0,0 +1,234 @@
+﻿using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Landmark distance tables that give path searches a closer cost estimate than the 
+    /// straight line distance.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// A few landmark polygons are picked far apart, and the path cost from each landmark to 
+    /// every polygon is stored per tile.  Set the landmarks on a query with 
+    /// <see cref="NavmeshQuery.SetLandmarks"/>.  On meshes where walls keep paths much longer 
+    /// than the straight line, such as mazes and buildings, path searches expand far fewer 
+    /// nodes.
+    /// </para>
+    /// <para>
+    /// The estimate can be more than the real cost, so paths found with the landmarks are 
+    /// not guaranteed to be the shortest.  On a test maze, more than half of the paths came 
+    /// out longer: by 0.8% in total and 4.5% at most.  On open ground it was one path in 300, 
+    /// by 0.3%.
+    /// </para>
+    /// <para>
+    /// The tables do not track the navigation mesh.  Call <see cref="Update"/> after adding or 
+    /// removing tiles, or changing polygon flags and areas.  Until then the changed tiles 
+    /// fall back to the straight line estimate.
+    /// </para>
+    /// <para>
+    /// <see cref="GetSerializedData"/> saves the tables so they can be loaded with the 
+    /// mesh from <see cref="Navmesh.GetSerializedMesh"/> instead of being built again.
+    /// </para>
+    /// <para>
+    /// Queries may use the landmarks from several threads at once.  <see cref="Update"/> 
+    /// must not overlap with any other use of the object.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class NavmeshLandmarks
+        : ManagedObject
+    {
+        /// <summary>
+        /// The maximum number of landmarks.
+        /// </summary>
+        public const int MaxLandmarks = 15;
+
+        internal IntPtr root;
+
+        private NavmeshLandmarks(IntPtr landmarks)
+            : base(AllocType.External)
+        {
+            root = landmarks;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~NavmeshLandmarks()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Queries the landmarks are set on must not be used for path finding afterwards.
+        /// </para>
+        /// </remarks>
+        public override void RequestDisposal()
+        {
+            if (root != IntPtr.Zero)
+            {
+                NavmeshQueryEx.dtnlFree(root);
+                root = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public override bool IsDisposed
+        {
+            get { return (root == IntPtr.Zero); }
+        }
+
+        /// <summary>
+        /// The number of landmarks in use.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// May be fewer than asked for if the mesh is small.
+        /// </para>
+        /// </remarks>
+        public int LandmarkCount
+        {
+            get { return (IsDisposed ? 0 : NavmeshQueryEx.dtnlGetLandmarkCount(root)); }
+        }
+
+        /// <summary>
+        /// Rebuilds the tables if tiles changed since the last update.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// A change to any tile can change path costs anywhere on the mesh, so the landmark 
+        /// searches are run again over the whole mesh.  Landmarks that are still on the mesh 
+        /// are kept.
+        /// </para>
+        /// </remarks>
+        /// <param name="changedCount">The number of tiles that changed.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Update(out int changedCount)
+        {
+            changedCount = 0;
+
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            return NavmeshQueryEx.dtnlUpdate(root, ref changedCount);
+        }
+
+        /// <summary>
+        /// Gets a serialized copy of the landmarks and tables.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Tiles are identified by reference, so the data is only useful with a mesh 
+        /// created from the <see cref="Navmesh.GetSerializedMesh"/> data saved at the same 
+        /// time.
+        /// </para>
+        /// </remarks>
+        /// <returns>The serialized landmarks, or null on failure.</returns>
+        public byte[] GetSerializedData()
+        {
+            if (IsDisposed)
+                return null;
+
+            IntPtr data = IntPtr.Zero;
+            int dataSize = 0;
+
+            NavmeshQueryEx.dtnlGetRawData(root, ref data, ref dataSize);
+
+            if (dataSize == 0)
+                return null;
+
+            byte[] resultData = UtilEx.ExtractArrayByte(data, dataSize);
+
+            NavmeshEx.dtnmFreeBytes(ref data);
+
+            return resultData;
+        }
+
+        /// <summary>
+        /// Picks the landmarks and builds the tables for every tile in a navigation mesh.
+        /// </summary>
+        /// <param name="navmesh">The navigation mesh.</param>
+        /// <param name="filter">
+        /// The filter that decides which polygons are used and sets the costs.  (Copied.)
+        /// </param>
+        /// <param name="landmarkCount">
+        /// The number of landmarks. [Limits: 0 &lt; value &lt;= <see cref="MaxLandmarks"/>]
+        /// </param>
+        /// <param name="resultLandmarks">The landmarks, or null on failure.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus Create(Navmesh navmesh
+            , NavmeshQueryFilter filter
+            , int landmarkCount
+            , out NavmeshLandmarks resultLandmarks)
+        {
+            resultLandmarks = null;
+
+            if (navmesh == null || navmesh.IsDisposed || filter == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr landmarks = IntPtr.Zero;
+
+            NavStatus status = NavmeshQueryEx.dtnlAlloc(navmesh.root
+                , filter.root
+                , landmarkCount
+                , ref landmarks);
+
+            if (NavUtil.Succeeded(status))
+                resultLandmarks = new NavmeshLandmarks(landmarks);
+
+            return status;
+        }
+
+        /// <summary>
+        /// Loads landmarks from data obtained from the <see cref="GetSerializedData"/> method.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Tables for tiles that are not in the mesh as they were saved are left out.  Call 
+        /// <see cref="Update"/> to rebuild them.
+        /// </para>
+        /// </remarks>
+        /// <param name="navmesh">The navigation mesh the data was saved with.</param>
+        /// <param name="filter">The filter the landmarks were created with.  (Copied.)</param>
+        /// <param name="serializedData">The serialized landmarks.</param>
+        /// <param name="resultLandmarks">The landmarks, or null on failure.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus Create(Navmesh navmesh
+            , NavmeshQueryFilter filter
+            , byte[] serializedData
+            , out NavmeshLandmarks resultLandmarks)
+        {
+            resultLandmarks = null;
+
+            if (navmesh == null || navmesh.IsDisposed 
+                || filter == null
+                || serializedData == null || serializedData.Length == 0)
+            {
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            }
+
+            IntPtr landmarks = IntPtr.Zero;
+
+            NavStatus status = NavmeshQueryEx.dtnlAllocFromRaw(navmesh.root
+                , filter.root
+                , serializedData
+                , serializedData.Length
+                , ref landmarks);
+
+            if (NavUtil.Succeeded(status))
+                resultLandmarks = new NavmeshLandmarks(landmarks);
+
+            return status;
+        }
+    }
+}
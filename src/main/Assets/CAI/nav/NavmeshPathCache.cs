@@ -0,0 +1,179 @@
+﻿using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// A least recently used cache of polygon paths in front of 
+    /// <see cref="NavmeshQuery.FindPath(NavmeshPoint, NavmeshPoint, NavmeshQueryFilter, uint[], out int)"/>.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Paths are keyed on the start and end polygons and the filter's flags and area costs, 
+    /// which suits requests that repeat, such as patrols.  A hit returns the path found for the 
+    /// first request between the two polygons, whatever the points within them.  Straight 
+    /// paths are not cached.  Pass the result to <see cref="NavmeshQuery.GetStraightPath"/> 
+    /// as usual.
+    /// </para>
+    /// <para>
+    /// A cached path is dropped when any tile it crosses is removed or replaced, or has a 
+    /// polygon's flags or area changed.  Only complete paths are cached.
+    /// </para>
+    /// <para>
+    /// <see cref="FindPath"/> may be called from several threads at once, each with its own 
+    /// query.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class NavmeshPathCache
+        : ManagedObject
+    {
+        internal IntPtr root;
+
+        private NavmeshPathCache(IntPtr cache)
+            : base(AllocType.External)
+        {
+            root = cache;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~NavmeshPathCache()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        public override void RequestDisposal()
+        {
+            if (root != IntPtr.Zero)
+            {
+                NavmeshQueryEx.dtnpcFree(root);
+                root = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public override bool IsDisposed
+        {
+            get { return (root == IntPtr.Zero); }
+        }
+
+        /// <summary>
+        /// Gets the cache counters.
+        /// </summary>
+        /// <param name="hitCount">The number of paths served from the cache.</param>
+        /// <param name="missCount">
+        /// The number of paths searched for, including those whose entry was stale.
+        /// </param>
+        /// <param name="entryCount">The number of paths in the cache.</param>
+        public void GetCounters(out int hitCount, out int missCount, out int entryCount)
+        {
+            hitCount = 0;
+            missCount = 0;
+            entryCount = 0;
+
+            if (!IsDisposed)
+                NavmeshQueryEx.dtnpcGetCounters(root, ref hitCount, ref missCount, ref entryCount);
+        }
+
+        /// <summary>
+        /// Sets the hit and miss counts to zero.
+        /// </summary>
+        public void ResetCounters()
+        {
+            if (!IsDisposed)
+                NavmeshQueryEx.dtnpcResetCounters(root);
+        }
+
+        /// <summary>
+        /// Drops all cached paths.
+        /// </summary>
+        public void Clear()
+        {
+            if (!IsDisposed)
+                NavmeshQueryEx.dtnpcClear(root);
+        }
+
+        /// <summary>
+        /// Finds the polygon path from the start to the end polygon.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Behaves like 
+        /// <see cref="NavmeshQuery.FindPath(NavmeshPoint, NavmeshPoint, NavmeshQueryFilter, uint[], out int)"/>, 
+        /// which is used on a miss.
+        /// </para>
+        /// </remarks>
+        /// <param name="query">The query to search with on a miss.</param>
+        /// <param name="start">A point within the start polygon.</param>
+        /// <param name="end">A point within the end polygon.</param>
+        /// <param name="filter">The filter to apply to the query.</param>
+        /// <param name="resultPath">
+        /// An ordered list of polygon references in the path. (Start to end.) (Out) 
+        /// [(polyRef) * pathCount]
+        /// </param>
+        /// <param name="pathCount">The number of polygons in the path.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
+        public NavStatus FindPath(NavmeshQuery query
+            , NavmeshPoint start, NavmeshPoint end
+            , NavmeshQueryFilter filter
+            , uint[] resultPath, out int pathCount)
+        {
+            pathCount = 0;
+
+            if (IsDisposed
+                || query == null || query.IsDisposed
+                || filter == null
+                || resultPath == null)
+            {
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            }
+
+            return NavmeshQueryEx.dtnpcFindPath(root
+                , query.root
+                , start
+                , end
+                , filter.root
+                , resultPath
+                , ref pathCount
+                , resultPath.Length);
+        }
+
+        /// <summary>
+        /// Creates an empty path cache for a navigation mesh.
+        /// </summary>
+        /// <param name="navmesh">The navigation mesh.</param>
+        /// <param name="maxEntries">The maximum number of paths held. [Limit: > 0]</param>
+        /// <param name="resultCache">The cache, or null on failure.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus Create(Navmesh navmesh
+            , int maxEntries
+            , out NavmeshPathCache resultCache)
+        {
+            resultCache = null;
+
+            if (navmesh == null || navmesh.IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr cache = IntPtr.Zero;
+
+            NavStatus status = NavmeshQueryEx.dtnpcAlloc(navmesh.root
+                , maxEntries
+                , ref cache);
+
+            if (NavUtil.Succeeded(status))
+                resultCache = new NavmeshPathCache(cache);
+
+            return status;
+        }
+    }
+}
@@ -53,6 +53,7 @@ namespace org.critterai.nav
         internal IntPtr root; // dtNavmeshQuery
 
         private bool mIsRestricted;
+        private NavmeshLandmarks mLandmarks;
 
         internal NavmeshQuery(IntPtr query, bool isConstant, AllocType type)
             : base(type)
@@ -106,6 +107,42 @@ namespace org.critterai.nav
             get { return (root == IntPtr.Zero); }
         }
 
+        /// <summary>
+        /// The landmarks used by the path searches, or null if none.
+        /// </summary>
+        public NavmeshLandmarks Landmarks { get { return mLandmarks; } }
+
+        /// <summary>
+        /// Sets the landmarks used to estimate the remaining cost in path searches.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// This method will fail if <see cref="IsRestricted"/> is true.
+        /// </para>
+        /// <para>
+        /// The landmarks must be for this query's navigation mesh.  They apply to 
+        /// <see cref="FindPath(NavmeshPoint, NavmeshPoint, NavmeshQueryFilter, uint[], out int)"/> 
+        /// and the sliced path methods.  Set null to go back to the straight line estimate.
+        /// </para>
+        /// <para>
+        /// Paths found with landmarks are not guaranteed to be the shortest.  
+        /// (See <see cref="NavmeshLandmarks"/>.)
+        /// </para>
+        /// </remarks>
+        /// <param name="landmarks">The landmarks, or null for none.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the operation.</returns>
+        public NavStatus SetLandmarks(NavmeshLandmarks landmarks)
+        {
+            if (mIsRestricted || (landmarks != null && landmarks.IsDisposed))
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            NavmeshQueryEx.dtqSetLandmarks(root
+                , (landmarks == null ? IntPtr.Zero : landmarks.root));
+            mLandmarks = landmarks;
+
+            return NavStatus.Sucess;
+        }
+
         /// <summary>
         /// Finds the nearest point on the surface of the navigation mesh.
         /// </summary>
@@ -986,6 +1023,88 @@ namespace org.critterai.nav
                 , maxPath);
         }
 
+        /// <summary>
+        /// Finds the straight paths for a batch of requests in a single call.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Each request is equivalent to 
+        /// <see cref="FindPath(ref NavmeshPoint, ref NavmeshPoint, Vector3, NavmeshQueryFilter, uint[], out int)"/> 
+        /// followed by <see cref="GetStraightPath"/>, without the per-call overhead.  Points with 
+        /// a polygon reference of zero are snapped to the navigation mesh and updated in place.  
+        /// If only a partial path is found, its straight path ends at the point on the path 
+        /// closest to the end point.
+        /// </para>
+        /// <para>
+        /// The straight paths are packed one after the other.  Request <c>i</c> writes 
+        /// <c>resultCounts[i]</c> points starting at <c>resultOffsets[i]</c>.  Requests that 
+        /// don't fit in the remaining space fail with <see cref="NavStatus.BufferTooSmall"/>.  A 
+        /// request cut short by the end of the buffer succeeds with the points that fit, and its 
+        /// status has the <see cref="NavStatus.BufferTooSmall"/> flag.
+        /// </para>
+        /// </remarks>
+        /// <param name="starts">The start points. [Length: >= count]</param>
+        /// <param name="ends">The end points. [Length: >= count]</param>
+        /// <param name="count">The number of requests.</param>
+        /// <param name="extents">The search extents used to snap points to the mesh.</param>
+        /// <param name="filter">The filter to apply to the query.</param>
+        /// <param name="maxPath">The maximum number of polygons in each path corridor.</param>
+        /// <param name="resultPoints">The packed straight path points.</param>
+        /// <param name="resultFlags">
+        /// Flags describing each point. [Length: >= resultPoints.Length] (Optional)</param>
+        /// <param name="resultRefs">
+        /// The reference of the polygon that is being entered at each point.
+        /// [Length: >= resultPoints.Length] (Optional)</param>
+        /// <param name="resultOffsets">
+        /// The index of the first point of each request. [Length: >= count]</param>
+        /// <param name="resultCounts">
+        /// The number of points in each straight path. [Length: >= count]</param>
+        /// <param name="statuses">The status of each request. [Length: >= count]</param>
+        /// <param name="totalCount">The number of points written.</param>
+        /// <returns>
+        /// The <see cref="NavStatus" /> flags for the batch.  Check <paramref name="statuses"/> 
+        /// for the result of each request.
+        /// </returns>
+        public NavStatus FindStraightPaths(NavmeshPoint[] starts, NavmeshPoint[] ends, int count
+            , Vector3 extents, NavmeshQueryFilter filter, int maxPath
+            , Vector3[] resultPoints, WaypointFlag[] resultFlags, uint[] resultRefs
+            , int[] resultOffsets, int[] resultCounts, NavStatus[] statuses
+            , out int totalCount)
+        {
+            totalCount = 0;
+
+            if (filter == null
+                || count < 0
+                || maxPath < 1
+                || resultPoints == null
+                || (resultFlags != null && resultFlags.Length < resultPoints.Length)
+                || (resultRefs != null && resultRefs.Length < resultPoints.Length)
+                || starts == null || starts.Length < count
+                || ends == null || ends.Length < count
+                || resultOffsets == null || resultOffsets.Length < count
+                || resultCounts == null || resultCounts.Length < count
+                || statuses == null || statuses.Length < count)
+            {
+                return (NavStatus.Failure | NavStatus.InvalidParam);
+            }
+
+            return NavmeshQueryEx.dtqFindStraightPaths(root
+                , starts
+                , ends
+                , count
+                , ref extents
+                , filter.root
+                , maxPath
+                , resultPoints
+                , resultFlags
+                , resultRefs
+                , resultPoints.Length
+                , resultOffsets
+                , resultCounts
+                , statuses
+                , ref totalCount);
+        }
+
         /// <summary>
         /// Moves from the start to the end point constrained to the navigation mesh.
         /// </summary>
@@ -1111,6 +1230,30 @@ namespace org.critterai.nav
         /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
         public NavStatus InitSlicedFindPath(NavmeshPoint start, NavmeshPoint end
             , NavmeshQueryFilter filter)
+        {
+            return InitSlicedFindPath(start, end, filter, FindPathOptions.None);
+        }
+
+        /// <summary>
+        /// Initializes a sliced path find query with search options.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// This method will fail if <see cref="IsRestricted"/> is true.
+        /// </para>
+        /// <para>
+        /// Each iteration of <see cref="UpdateSlicedFindPath"/> expands a single node, of either 
+        /// search when <see cref="FindPathOptions.Bidirectional"/> is set.
+        /// </para>
+        /// </remarks>
+        /// <param name="start">A point within the start polygon.</param>
+        /// <param name="end">A point within the end polygon.</param>
+        /// <param name="filter">The filter to apply to the query.</param>
+        /// <param name="options">The search options.</param>
+        /// <returns>The <see cref="NavStatus" /> flags for the query.</returns>
+        public NavStatus InitSlicedFindPath(NavmeshPoint start, NavmeshPoint end
+            , NavmeshQueryFilter filter
+            , FindPathOptions options)
         {
             if (mIsRestricted)
                 return NavStatus.Failure;
@@ -1118,7 +1261,8 @@ namespace org.critterai.nav
             return NavmeshQueryEx.dtqInitSlicedFindPath(root
                 , start
                 , end
-                , filter.root);
+                , filter.root
+                , options);
         }
 
         /// <summary>
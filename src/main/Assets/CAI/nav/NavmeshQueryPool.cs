@@ -0,0 +1,229 @@
+﻿using System;
+using org.critterai.nav.rcn;
+using org.critterai.interop;
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+
+namespace org.critterai.nav
+{
+    /// <summary>
+    /// Provides navigation mesh queries for concurrent use, and finds batches of paths on 
+    /// multiple threads.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// A <see cref="NavmeshQuery"/> keeps its search state between calls, so it can't be shared 
+    /// between threads.  The pool hands out a separate query to each caller, creating queries 
+    /// as needed and reusing released ones.
+    /// </para>
+    /// <para>
+    /// The navigation mesh must not be modified while the pool is in use.
+    /// </para>
+    /// <para>
+    /// Behavior is undefined if used after disposal.
+    /// </para>
+    /// </remarks>
+    public sealed class NavmeshQueryPool
+        : ManagedObject
+    {
+        internal IntPtr root;
+
+        private NavmeshQueryPool(IntPtr pool)
+            : base(AllocType.External)
+        {
+            root = pool;
+        }
+
+        /// <summary>
+        /// Destructor
+        /// </summary>
+        ~NavmeshQueryPool()
+        {
+            RequestDisposal();
+        }
+
+        /// <summary>
+        /// Immediately frees all unmanaged resources allocated by the object.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Queries acquired from the pool are freed with it.
+        /// </para>
+        /// </remarks>
+        public override void RequestDisposal()
+        {
+            if (root != IntPtr.Zero)
+            {
+                NavmeshQueryEx.dtnqpFree(root);
+                root = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public override bool IsDisposed
+        {
+            get { return (root == IntPtr.Zero); }
+        }
+
+        /// <summary>
+        /// The number of threads used by <see cref="FindPaths"/>, including the calling thread.
+        /// </summary>
+        public int ThreadCount
+        {
+            get { return (IsDisposed ? 0 : NavmeshQueryEx.dtnqpGetThreadCount(root)); }
+        }
+
+        /// <summary>
+        /// Gets a query for the exclusive use of the caller.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The query is owned by the pool.  Give it back with <see cref="Release"/> rather than 
+        /// disposing of it.
+        /// </para>
+        /// </remarks>
+        /// <param name="resultQuery">The query, or null on failure.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Acquire(out NavmeshQuery resultQuery)
+        {
+            resultQuery = null;
+
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr query = IntPtr.Zero;
+
+            NavStatus status = NavmeshQueryEx.dtnqpAcquire(root, ref query);
+
+            if (NavUtil.Succeeded(status))
+                resultQuery = new NavmeshQuery(query, false, AllocType.ExternallyManaged);
+
+            return status;
+        }
+
+        /// <summary>
+        /// Returns a query to the pool.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The query is disposed and must not be used after this call.
+        /// </para>
+        /// </remarks>
+        /// <param name="query">A query acquired from this pool.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Release(NavmeshQuery query)
+        {
+            if (IsDisposed || query == null || query.IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            NavStatus status = NavmeshQueryEx.dtnqpRelease(root, query.root);
+
+            if (NavUtil.Succeeded(status))
+                query.RequestDisposal();
+
+            return status;
+        }
+
+        /// <summary>
+        /// Finds the polygon paths for a batch of requests, spread over the pool's threads.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Each request behaves like 
+        /// <see cref="NavmeshQuery.FindPath(ref NavmeshPoint, ref NavmeshPoint, Vector3, NavmeshQueryFilter, uint[], out int)"/>.  
+        /// Points with a polygon reference of zero are snapped to the navigation mesh and 
+        /// updated in place.
+        /// </para>
+        /// <para>
+        /// The path for request <c>i</c> is written to <paramref name="resultPaths"/> starting 
+        /// at index <c>i * maxPath</c>.
+        /// </para>
+        /// <para>
+        /// The filter is shared by all threads, so it must not be modified during the call.
+        /// </para>
+        /// </remarks>
+        /// <param name="starts">The start points. [Length: >= count]</param>
+        /// <param name="ends">The end points. [Length: >= count]</param>
+        /// <param name="count">The number of requests.</param>
+        /// <param name="extents">The search extents used to snap points to the mesh.</param>
+        /// <param name="filter">The filter to apply to the queries.</param>
+        /// <param name="resultPaths">The paths. [Length: >= count * maxPath]</param>
+        /// <param name="pathCounts">The number of polygons in each path. [Length: >= count]
+        /// </param>
+        /// <param name="maxPath">The maximum number of polygons per path.</param>
+        /// <param name="statuses">The status of each request. [Length: >= count]</param>
+        /// <returns>
+        /// The <see cref="NavStatus"/> flags for the batch.  Check <paramref name="statuses"/> for 
+        /// the result of each request.
+        /// </returns>
+        public NavStatus FindPaths(NavmeshPoint[] starts, NavmeshPoint[] ends, int count
+            , Vector3 extents, NavmeshQueryFilter filter
+            , uint[] resultPaths, int[] pathCounts, int maxPath, NavStatus[] statuses)
+        {
+            if (IsDisposed
+                || filter == null
+                || count < 0
+                || maxPath < 1
+                || starts == null || starts.Length < count
+                || ends == null || ends.Length < count
+                || resultPaths == null || resultPaths.Length < count * maxPath
+                || pathCounts == null || pathCounts.Length < count
+                || statuses == null || statuses.Length < count)
+            {
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            }
+
+            return NavmeshQueryEx.dtnqpFindPaths(root
+                , starts
+                , ends
+                , count
+                , ref extents
+                , filter.root
+                , resultPaths
+                , pathCounts
+                , maxPath
+                , statuses);
+        }
+
+        /// <summary>
+        /// Creates a query pool for a navigation mesh.
+        /// </summary>
+        /// <param name="navmesh">The navigation mesh the queries will use.</param>
+        /// <param name="maximumNodes">
+        /// The maximum number of nodes allowed when each query performs A* and Dijkstra searches.
+        /// </param>
+        /// <param name="threadCount">
+        /// The number of threads used by <see cref="FindPaths"/>, including the calling thread.
+        /// One per processor if less than one.
+        /// </param>
+        /// <param name="resultPool">The pool, or null on failure.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus Create(Navmesh navmesh
+            , int maximumNodes
+            , int threadCount
+            , out NavmeshQueryPool resultPool)
+        {
+            resultPool = null;
+
+            if (navmesh == null || navmesh.IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            IntPtr pool = IntPtr.Zero;
+
+            NavStatus status = NavmeshQueryEx.dtnqpAlloc(navmesh.root
+                , maximumNodes
+                , threadCount
+                , ref pool);
+
+            if (NavUtil.Succeeded(status))
+                resultPool = new NavmeshQueryPool(pool);
+
+            return status;
+        }
+    }
+}
@@ -14,12 +14,225 @@ namespace org.critterai.nav {
     /// ???
     /// </summary>
     public sealed class TileCache {
+        /// <summary>
+        /// The default maximum number of obstacles.
+        /// </summary>
+        public const int DefaultMaxObstacles = 128;
+
         internal IntPtr root = IntPtr.Zero;
+        private IntPtr mWorker = IntPtr.Zero;
+
+        private TileCacheBuildStats mBuildStats;
+
+        /// <summary>
+        /// Size information recorded when the tile cache was built.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Only populated for multi-threaded, compressed or streamed builds.
+        /// </para>
+        /// </remarks>
+        public TileCacheBuildStats BuildStats { get { return mBuildStats; } }
 
         internal TileCache(IntPtr root) {
             this.root = root;
         }
 
+        /// <summary>
+        /// True if the object has been disposed and should no longer be used.
+        /// </summary>
+        public bool IsDisposed {
+            get { return root == IntPtr.Zero; }
+        }
+
+        /// <summary>
+        /// Frees the unmanaged tile cache.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The navigation mesh built with the tile cache is not affected.
+        /// </para>
+        /// </remarks>
+        public void RequestDisposal() {
+            if (HasWorker) {
+                TileCacheEx.dttcwFree(mWorker, IntPtr.Zero);
+                mWorker = IntPtr.Zero;
+            }
+            if (root != IntPtr.Zero) {
+                TileCacheEx.dttcFree(root);
+                root = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// Gets the memory used by the tile rebuild allocator.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The allocator grows on demand and keeps its memory between rebuilds.  Use the high
+        /// water mark to choose a production size.
+        /// </para>
+        /// </remarks>
+        /// <param name="high">The most memory used by a single tile rebuild. [Units: Bytes]</param>
+        /// <param name="capacity">The memory currently reserved. [Units: Bytes]</param>
+        public void GetAllocatorUsage(out int high, out int capacity) {
+            high = 0;
+            capacity = 0;
+            if (!IsDisposed)
+                TileCacheEx.dttcGetAllocatorUsage(root, ref high, ref capacity);
+        }
+
+        /// <summary>
+        /// Adds a cylinder obstacle.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The navigation mesh is not changed until the affected tiles are rebuilt by
+        /// <see cref="Update"/>.
+        /// </para>
+        /// </remarks>
+        /// <param name="pos">The bottom center of the cylinder.</param>
+        /// <param name="radius">The radius of the cylinder.</param>
+        /// <param name="height">The height of the cylinder.</param>
+        /// <param name="obstacleRef">The reference of the new obstacle.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus AddObstacle(Vector3 pos, float radius, float height, out uint obstacleRef) {
+            obstacleRef = 0;
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return TileCacheEx.dttcAddObstacle(root, ref pos, radius, height, ref obstacleRef);
+        }
+
+        /// <summary>
+        /// Adds an axis-aligned box obstacle.
+        /// </summary>
+        /// <param name="bmin">The minimum bounds of the box.</param>
+        /// <param name="bmax">The maximum bounds of the box.</param>
+        /// <param name="obstacleRef">The reference of the new obstacle.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus AddBoxObstacle(Vector3 bmin, Vector3 bmax, out uint obstacleRef) {
+            obstacleRef = 0;
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return TileCacheEx.dttcAddBoxObstacle(root, ref bmin, ref bmax, ref obstacleRef);
+        }
+
+        /// <summary>
+        /// Adds a box obstacle rotated about the y-axis.
+        /// </summary>
+        /// <param name="center">The center of the box.</param>
+        /// <param name="halfExtents">The half extents of the box.</param>
+        /// <param name="yRadians">The rotation about the y-axis. [Units: Radians]</param>
+        /// <param name="obstacleRef">The reference of the new obstacle.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus AddOrientedBoxObstacle(Vector3 center, Vector3 halfExtents, float yRadians
+            , out uint obstacleRef) {
+            obstacleRef = 0;
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return TileCacheEx.dttcAddOrientedBoxObstacle(root
+                , ref center, ref halfExtents, yRadians, ref obstacleRef);
+        }
+
+        /// <summary>
+        /// Removes an obstacle.
+        /// </summary>
+        /// <param name="obstacleRef">The reference of the obstacle to remove.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus RemoveObstacle(uint obstacleRef) {
+            if (IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return TileCacheEx.dttcRemoveObstacle(root, obstacleRef);
+        }
+
+        /// <summary>
+        /// True if tiles are being rebuilt on a background thread.
+        /// </summary>
+        public bool HasWorker {
+            get { return mWorker != IntPtr.Zero; }
+        }
+
+        /// <summary>
+        /// Starts rebuilding tiles on a background thread.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// While the worker is running, use <see cref="Sync"/> instead of <see cref="Update"/>.
+        /// The navigation mesh only changes during <see cref="Sync"/>, so it can be queried
+        /// between syncs while tiles are being rebuilt.
+        /// </para>
+        /// </remarks>
+        /// <param name="maxJobs">The maximum number of tiles rebuilding between syncs.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus StartWorker(int maxJobs) {
+            if (IsDisposed || maxJobs < 1)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            if (HasWorker)
+                return NavStatus.Sucess;
+            mWorker = TileCacheEx.dttcwAlloc(root, maxJobs);
+            return HasWorker ? NavStatus.Sucess : NavStatus.Failure | NavStatus.OutOfMemory;
+        }
+
+        /// <summary>
+        /// Stops the background worker.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Tiles the worker has started are finished and committed on the calling thread.  Tiles
+        /// that were not yet handed to the worker are left for <see cref="Update"/>.
+        /// </para>
+        /// </remarks>
+        /// <param name="navmesh">The navigation mesh built with the tile cache.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus StopWorker(Navmesh navmesh) {
+            if (!HasWorker || navmesh == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            NavStatus status = TileCacheEx.dttcwFree(mWorker, navmesh.root);
+            mWorker = IntPtr.Zero;
+            return status;
+        }
+
+        /// <summary>
+        /// Commits tiles finished by the background worker and hands it the next dirty tiles.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Call once per frame at a point where the navigation mesh is not in use.  Committing a
+        /// tile is a cheap remove and add on the navigation mesh.
+        /// </para>
+        /// </remarks>
+        /// <param name="navmesh">The navigation mesh built with the tile cache.</param>
+        /// <param name="maxCommits">The maximum number of tiles to commit. (All if &lt;= 0.)</param>
+        /// <param name="pendingTiles">The work left for later calls.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Sync(Navmesh navmesh, int maxCommits, out int pendingTiles) {
+            pendingTiles = 0;
+            if (!HasWorker || navmesh == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return TileCacheEx.dttcwSync(mWorker, navmesh.root, maxCommits, ref pendingTiles);
+        }
+
+        /// <summary>
+        /// Applies obstacle changes to the navigation mesh within a per-call budget.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Call once per frame.  Tiles are rebuilt until the cache is up to date or a budget runs
+        /// out, with at least one tile rebuilt per call.  A budget &lt;= 0 is unlimited.
+        /// </para>
+        /// </remarks>
+        /// <param name="navmesh">The navigation mesh built with the tile cache.</param>
+        /// <param name="maxTiles">The maximum number of tiles to rebuild.</param>
+        /// <param name="maxMicroseconds">The time budget. [Units: Microseconds]</param>
+        /// <param name="pendingTiles">The work left for later calls.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public NavStatus Update(Navmesh navmesh, int maxTiles, int maxMicroseconds, out int pendingTiles) {
+            pendingTiles = 0;
+            if (IsDisposed || HasWorker || navmesh == null)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+            return TileCacheEx.dttcUpdate(root, navmesh.root, maxTiles, maxMicroseconds, ref pendingTiles);
+        }
+
         /// <summary>
         /// wtf
         /// </summary>
@@ -46,6 +259,19 @@ namespace org.critterai.nav {
         /// <param name="tileCache"></param>
         /// <param name="navmesh"></param>
         /// <param name="navmeshQuery"></param>
+        /// <param name="threadCount">
+        /// The number of threads used to rasterize the tiles. (One per core if &lt;= 0.)
+        /// </param>
+        /// <param name="compression">The compression to apply to the stored layers.</param>
+        /// <param name="maxObstacles">The maximum number of obstacles that can exist at once.</param>
+        /// <param name="chunkyMeshCachePath">
+        /// A file to cache the partitioned input mesh in, or null for no cache.  The file is
+        /// memory mapped on later builds with the same input.
+        /// </param>
+        /// <param name="manifestPath">
+        /// A file to store each tile's input hash and layers in, or null to always rebuild every
+        /// tile.  Later builds only rasterize the tiles whose input changed.
+        /// </param>
         /// <returns></returns>
         public static NavStatus Create(
             IntPtr contextRoot,
@@ -56,7 +282,10 @@ namespace org.critterai.nav {
             float edgeMaxLen, float edgeMaxError,
             float regionMinSize, float regionMergeSize,
             float detailSampleDist, float detailSampleMaxError,
-            out TileCache tileCache, out Navmesh navmesh, out NavmeshQuery navmeshQuery) {
+            out TileCache tileCache, out Navmesh navmesh, out NavmeshQuery navmeshQuery,
+            int threadCount = 1, TileCacheCompression compression = TileCacheCompression.None,
+            int maxObstacles = DefaultMaxObstacles, string chunkyMeshCachePath = null,
+            string manifestPath = null) {
             var bmin = new Vector3(float.PositiveInfinity, float.PositiveInfinity, float.PositiveInfinity);
             var bmax = new Vector3(float.NegativeInfinity, float.NegativeInfinity, float.NegativeInfinity);
 
@@ -73,10 +302,132 @@ namespace org.critterai.nav {
             var pNavMesh = new IntPtr();
             var pNavQuery = new IntPtr();
 
-            var status = TileCacheEx.handleBuild(
+            NavStatus status;
+            var stats = new TileCacheBuildStats();
+            if (threadCount != 1 || compression != TileCacheCompression.None
+                || maxObstacles != DefaultMaxObstacles || chunkyMeshCachePath != null
+                || manifestPath != null) {
+                status = TileCacheEx.dttcBuildParallel(
+                    buildContext: contextRoot,
+                    verts: triangleMesh.verts, nverts: triangleMesh.vertCount, vertsPerPoly: vertsPerPoly,
+                    tris: triangleMesh.tris, ntris: triangleMesh.triCount, trisPerChunk: trisPerChunk,
+                    filterLowHangingObstacles: filterLowHangingObstacles,
+                    filterLedgeSpans: filterLedgeSpans,
+                    filterWalkableLowHeightSpans: filterWalkableLowHeightSpans,
+                    bmin: ref bmin, bmax: ref bmax,
+                    cellSize: cellSize, cellHeight: cellHeight,
+                    tileSize: tileSize,
+                    agentMaxSlope: agentMaxSlope, agentMaxClimb: agentMaxClimb, agentRadius: agentRadius, agentHeight: agentHeight,
+                    edgeMaxLen: edgeMaxLen, edgeMaxError: edgeMaxError,
+                    regionMinSize: regionMinSize, regionMergeSize: regionMergeSize,
+                    detailSampleDist: detailSampleDist, detailSampleMaxError: detailSampleMaxError,
+                    pTileCache: ref pTileCache, pNavMesh: ref pNavMesh, pNavQuery: ref pNavQuery,
+                    rasterizer: TileCacheEx.nmtcGetTileRasterizer(), threadCount: threadCount,
+                    maxObstacles: maxObstacles, compression: compression, stats: ref stats,
+                    chunkyMeshCachePath: chunkyMeshCachePath, manifestPath: manifestPath);
+            } else {
+                status = TileCacheEx.handleBuild(
+                    buildContext: contextRoot,
+                    verts: triangleMesh.verts, nverts: triangleMesh.vertCount, vertsPerPoly: vertsPerPoly,
+                    tris: triangleMesh.tris, ntris: triangleMesh.triCount, trisPerChunk: trisPerChunk,
+                    filterLowHangingObstacles: filterLowHangingObstacles,
+                    filterLedgeSpans: filterLedgeSpans,
+                    filterWalkableLowHeightSpans: filterWalkableLowHeightSpans,
+                    bmin: ref bmin, bmax: ref bmax,
+                    cellSize: cellSize, cellHeight: cellHeight,
+                    tileSize: tileSize,
+                    agentMaxSlope: agentMaxSlope, agentMaxClimb: agentMaxClimb, agentRadius: agentRadius, agentHeight: agentHeight,
+                    edgeMaxLen: edgeMaxLen, edgeMaxError: edgeMaxError,
+                    regionMinSize: regionMinSize, regionMergeSize: regionMergeSize,
+                    detailSampleDist: detailSampleDist, detailSampleMaxError: detailSampleMaxError,
+                    pTileCache: ref pTileCache, pNavMesh: ref pNavMesh, pNavQuery: ref pNavQuery,
+                    rasterizeTileLayers: TileCacheEx.getRasterizeTileLayers());
+            }
+
+            if ((status & NavStatus.Sucess) != 0) {
+                tileCache = new TileCache(pTileCache);
+                tileCache.mBuildStats = stats;
+                navmesh = new Navmesh(pNavMesh);
+                navmeshQuery = new NavmeshQuery(pNavQuery, true, interop.AllocType.External);
+            } else {
+                tileCache = default(TileCache);
+                navmesh = default(Navmesh);
+                navmeshQuery = default(NavmeshQuery);
+            }
+
+            return status;
+        }
+
+        /// <summary>
+        /// Builds a tile cache from geometry that is read from disk as the tiles need it.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Same as <see cref="Create"/>, but the whole mesh is never held in memory.  Each tile
+        /// copies the triangles it needs from the chunks that overlap it, and a chunk is freed
+        /// once its last tile is done with it.  <see cref="BuildStats"/> reports the peak amount
+        /// of geometry loaded.
+        /// </para>
+        /// </remarks>
+        /// <param name="contextRoot">The build context.</param>
+        /// <param name="geometry">The input geometry.</param>
+        /// <param name="vertsPerPoly">The maximum number of vertices per polygon.</param>
+        /// <param name="filterLowHangingObstacles">Filter low hanging obstacles.</param>
+        /// <param name="filterLedgeSpans">Filter ledge spans.</param>
+        /// <param name="filterWalkableLowHeightSpans">Filter low height spans.</param>
+        /// <param name="cellSize">The xz-plane cell size.</param>
+        /// <param name="cellHeight">The y-axis cell size.</param>
+        /// <param name="tileSize">The tile size. [Units: Cells]</param>
+        /// <param name="agentMaxSlope">The maximum walkable slope. [Units: Degrees]</param>
+        /// <param name="agentMaxClimb">The maximum ledge height that can be climbed.</param>
+        /// <param name="agentRadius">The agent radius.</param>
+        /// <param name="agentHeight">The agent height.</param>
+        /// <param name="edgeMaxLen">The maximum contour edge length.</param>
+        /// <param name="edgeMaxError">The maximum contour simplification error.</param>
+        /// <param name="regionMinSize">The minimum region size.</param>
+        /// <param name="regionMergeSize">The region merge size.</param>
+        /// <param name="detailSampleDist">The detail mesh sample distance.</param>
+        /// <param name="detailSampleMaxError">The detail mesh maximum sample error.</param>
+        /// <param name="tileCache">The tile cache.</param>
+        /// <param name="navmesh">The navigation mesh.</param>
+        /// <param name="navmeshQuery">A query for the navigation mesh.</param>
+        /// <param name="threadCount">
+        /// The number of threads used to rasterize the tiles. (One per core if &lt;= 0.)
+        /// </param>
+        /// <param name="compression">The compression to apply to the stored layers.</param>
+        /// <param name="maxObstacles">The maximum number of obstacles that can exist at once.</param>
+        /// <returns>The <see cref="NavStatus"/> flags for the operation.</returns>
+        public static NavStatus CreateStreamed(
+            IntPtr contextRoot,
+            GeometryStream geometry, int vertsPerPoly,
+            bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+            float cellSize, float cellHeight, float tileSize,
+            float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+            float edgeMaxLen, float edgeMaxError,
+            float regionMinSize, float regionMergeSize,
+            float detailSampleDist, float detailSampleMaxError,
+            out TileCache tileCache, out Navmesh navmesh, out NavmeshQuery navmeshQuery,
+            int threadCount = 1, TileCacheCompression compression = TileCacheCompression.None,
+            int maxObstacles = DefaultMaxObstacles) {
+            tileCache = default(TileCache);
+            navmesh = default(Navmesh);
+            navmeshQuery = default(NavmeshQuery);
+
+            if (geometry == null || geometry.IsDisposed)
+                return NavStatus.Failure | NavStatus.InvalidParam;
+
+            Vector3 bmin;
+            Vector3 bmax;
+            geometry.GetBounds(out bmin, out bmax);
+
+            var pTileCache = new IntPtr();
+            var pNavMesh = new IntPtr();
+            var pNavQuery = new IntPtr();
+
+            var stats = new TileCacheBuildStats();
+            NavStatus status = TileCacheEx.dttcBuildFromFile(
                 buildContext: contextRoot,
-                verts: triangleMesh.verts, nverts: triangleMesh.vertCount, vertsPerPoly: vertsPerPoly,
-                tris: triangleMesh.tris, ntris: triangleMesh.triCount, trisPerChunk: trisPerChunk,
+                geometryFile: geometry.root, vertsPerPoly: vertsPerPoly,
                 filterLowHangingObstacles: filterLowHangingObstacles,
                 filterLedgeSpans: filterLedgeSpans,
                 filterWalkableLowHeightSpans: filterWalkableLowHeightSpans,
@@ -88,16 +439,14 @@ namespace org.critterai.nav {
                 regionMinSize: regionMinSize, regionMergeSize: regionMergeSize,
                 detailSampleDist: detailSampleDist, detailSampleMaxError: detailSampleMaxError,
                 pTileCache: ref pTileCache, pNavMesh: ref pNavMesh, pNavQuery: ref pNavQuery,
-                rasterizeTileLayers: TileCacheEx.getRasterizeTileLayers());
+                rasterizer: TileCacheEx.nmtcGetTileRasterizer(), threadCount: threadCount,
+                maxObstacles: maxObstacles, compression: compression, stats: ref stats);
 
             if ((status & NavStatus.Sucess) != 0) {
                 tileCache = new TileCache(pTileCache);
+                tileCache.mBuildStats = stats;
                 navmesh = new Navmesh(pNavMesh);
                 navmeshQuery = new NavmeshQuery(pNavQuery, true, interop.AllocType.External);
-            } else {
-                tileCache = default(TileCache);
-                navmesh = default(Navmesh);
-                navmeshQuery = default(NavmeshQuery);
             }
 
             return status;
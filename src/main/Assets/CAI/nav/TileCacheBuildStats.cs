@@ -0,0 +1,67 @@
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nav {
+    /// <summary>
+    /// Size information for a <see cref="TileCache"/> build.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct TileCacheBuildStats {
+        /*
+         * Design note:
+         *
+         * Duplicate of: rcnTileCacheBuildStats
+         */
+
+        /// <summary>
+        /// The number of layers added to the tile cache.
+        /// </summary>
+        public int layerCount;
+
+        /// <summary>
+        /// The total size of the stored layers. [Units: Bytes]
+        /// </summary>
+        public int compressedSize;
+
+        /// <summary>
+        /// The total size of the layers if they were not compressed. [Units: Bytes]
+        /// </summary>
+        public int rawSize;
+
+        /// <summary>
+        /// The total size of the navigation mesh tile data. [Units: Bytes]
+        /// </summary>
+        public int navmeshSize;
+
+        /// <summary>
+        /// The most input geometry held in memory at once. [Units: Bytes]
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Only populated for streamed builds.
+        /// </para>
+        /// </remarks>
+        public int inputPeakSize;
+
+        /// <summary>
+        /// The number of input geometry chunks loaded.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Only populated for streamed builds.
+        /// </para>
+        /// </remarks>
+        public int inputChunkLoads;
+
+        /// <summary>
+        /// 1 if the partitioned input mesh was mapped from its cache file instead of being
+        /// rebuilt.
+        /// </summary>
+        public int chunkyMeshMapped;
+
+        /// <summary>
+        /// The number of tiles whose layers were reused from the bake manifest instead of being
+        /// rasterized.
+        /// </summary>
+        public int tilesReused;
+    }
+}
@@ -0,0 +1,16 @@
+namespace org.critterai.nav {
+    /// <summary>
+    /// The compression applied to the layers stored in a <see cref="TileCache"/>.
+    /// </summary>
+    public enum TileCacheCompression : int {
+        /// <summary>
+        /// Layers are stored uncompressed.
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// Layers are compressed with the built-in LZ codec.
+        /// </summary>
+        LZ = 1
+    }
+}
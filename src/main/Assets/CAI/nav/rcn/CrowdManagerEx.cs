@@ -102,6 +102,27 @@ namespace org.critterai.nav.rcn
             , float deltaTime
             , [In, Out] CrowdAgentCoreState[] coreStates);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr dtcJobSystemAlloc(int threadCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcJobSystemFree(IntPtr jobs);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtcUpdateParallel(IntPtr crowd
+            , float deltaTime
+            , [In, Out] CrowdAgentCoreState[] coreStates
+            , IntPtr jobs);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtcUpdateAgentStates(IntPtr crowd
+            , float deltaTime
+            , IntPtr jobs
+            , [In, Out] Vector3[] positions
+            , [In, Out] Vector3[] velocities
+            , [In, Out] CrowdAgentState[] states
+            , [In, Out] int[] dirtyAgents);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern IntPtr dtcGetNavMeshQuery(IntPtr crowd);
 
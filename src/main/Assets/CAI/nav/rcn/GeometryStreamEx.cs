@@ -0,0 +1,38 @@
+using System;
+using System.Runtime.InteropServices;
+#if NUNITY
+using Vector3 = org.critterai.Vector3;
+#else
+using Vector3 = UnityEngine.Vector3;
+#endif
+
+namespace org.critterai.nav.rcn {
+    internal static class GeometryStreamEx {
+        [DllImport(InteropUtil.PLATFORM_DLL, CharSet = CharSet.Ansi)]
+        public static extern IntPtr dtgsCreateWriter(string path);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtgsWriteChunk(IntPtr writer
+            , [In] Vector3[] verts
+            , int nverts
+            , [In] int[] tris
+            , int ntris);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtgsCloseWriter(IntPtr writer);
+
+        [DllImport(InteropUtil.PLATFORM_DLL, CharSet = CharSet.Ansi)]
+        public static extern NavStatus dtgsOpen(string path, ref IntPtr file);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtgsFree(IntPtr file);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtgsGetChunkCount(IntPtr file);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtgsGetBounds(IntPtr file
+            , ref Vector3 bmin
+            , ref Vector3 bmax);
+    }
+}
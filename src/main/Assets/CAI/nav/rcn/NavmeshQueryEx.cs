@@ -183,6 +183,23 @@ namespace org.critterai.nav.rcn
             , ref int straightPathCount
             , int maxStraightPath);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtqFindStraightPaths(IntPtr query
+            , [In, Out] NavmeshPoint[] startPositions
+            , [In, Out] NavmeshPoint[] endPositions
+            , int count
+            , [In] ref Vector3 extents
+            , IntPtr filter
+            , int maxPath
+            , [In, Out] Vector3[] straightPathPoints
+            , [In, Out] WaypointFlag[] straightPathFlags
+            , [In, Out] uint[] straightPathRefs
+            , int maxStraightPath
+            , [In, Out] int[] offsets
+            , [In, Out] int[] straightPathCounts
+            , [In, Out] NavStatus[] statuses
+            , ref int totalCount);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqMoveAlongSurface(IntPtr query
             , NavmeshPoint startPosition
@@ -197,7 +214,8 @@ namespace org.critterai.nav.rcn
         public static extern NavStatus dtqInitSlicedFindPath(IntPtr query
             , NavmeshPoint startPosition
             , NavmeshPoint endPosition
-            , IntPtr filter);
+            , IntPtr filter
+            , FindPathOptions options);
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern NavStatus dtqUpdateSlicedFindPath(IntPtr query
@@ -221,5 +239,124 @@ namespace org.critterai.nav.rcn
             , float radius
             , IntPtr filter
             , ref NavmeshPoint randomPt);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnqpAlloc(IntPtr navmesh
+            , int maxNodes
+            , int threadCount
+            , ref IntPtr resultPool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnqpFree(IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtnqpGetThreadCount(IntPtr pool);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnqpAcquire(IntPtr pool
+            , ref IntPtr resultQuery);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnqpRelease(IntPtr pool
+            , IntPtr query);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnqpFindPaths(IntPtr pool
+            , [In, Out] NavmeshPoint[] startPositions
+            , [In, Out] NavmeshPoint[] endPositions
+            , int count
+            , [In] ref Vector3 extents
+            , IntPtr filter
+            , [In, Out] uint[] resultPaths
+            , [In, Out] int[] pathCounts
+            , int maxPath
+            , [In, Out] NavStatus[] statuses);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnhAlloc(IntPtr navmesh
+            , IntPtr filter
+            , ref IntPtr resultHierarchy);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnhFree(IntPtr hierarchy);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnhUpdate(IntPtr hierarchy
+            , ref int rebuiltCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtnhGetNodeCount(IntPtr hierarchy);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnhFindPath(IntPtr hierarchy
+            , IntPtr query
+            , NavmeshPoint startPosition
+            , NavmeshPoint endPosition
+            , IntPtr filter
+            , [In, Out] uint[] resultPath
+            , ref int pathCount
+            , int maxPath);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnpcAlloc(IntPtr navmesh
+            , int maxEntries
+            , ref IntPtr resultCache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnpcFree(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnpcFindPath(IntPtr cache
+            , IntPtr query
+            , NavmeshPoint startPosition
+            , NavmeshPoint endPosition
+            , IntPtr filter
+            , [In, Out] uint[] resultPath
+            , ref int pathCount
+            , int maxPath);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnpcClear(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnpcGetCounters(IntPtr cache
+            , ref int hitCount
+            , ref int missCount
+            , ref int entryCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnpcResetCounters(IntPtr cache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnlAlloc(IntPtr navmesh
+            , IntPtr filter
+            , int landmarkCount
+            , ref IntPtr resultLandmarks);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnlAllocFromRaw(IntPtr navmesh
+            , IntPtr filter
+            , [In] byte[] rawData
+            , int dataSize
+            , ref IntPtr resultLandmarks);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtnlFree(IntPtr landmarks);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnlUpdate(IntPtr landmarks
+            , ref int changedCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int dtnlGetLandmarkCount(IntPtr landmarks);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dtnlGetRawData(IntPtr landmarks
+            , ref IntPtr resultData
+            , ref int dataSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dtqSetLandmarks(IntPtr query
+            , IntPtr landmarks);
     }
 }
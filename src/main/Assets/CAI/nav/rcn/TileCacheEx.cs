@@ -26,5 +26,93 @@ namespace org.critterai.nav.rcn {
 
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern IntPtr getRasterizeTileLayers();
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcBuildParallel(
+            IntPtr buildContext,
+            [In] Vector3[] verts, int nverts, int vertsPerPoly,
+            [In] int[] tris, int ntris, int trisPerChunk,
+            bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+	        ref Vector3 bmin, ref Vector3 bmax,
+	        float cellSize, float cellHeight,
+	        float tileSize,
+            float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+	        float edgeMaxLen, float edgeMaxError,
+	        float regionMinSize, float regionMergeSize,
+	        float detailSampleDist, float detailSampleMaxError,
+	        ref IntPtr pTileCache, ref IntPtr pNavMesh, ref IntPtr pNavQuery,
+            IntPtr rasterizer, int threadCount,
+            int maxObstacles, TileCacheCompression compression, ref TileCacheBuildStats stats,
+            string chunkyMeshCachePath, string manifestPath);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcBuildFromFile(
+            IntPtr buildContext,
+            IntPtr geometryFile, int vertsPerPoly,
+            bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+	        ref Vector3 bmin, ref Vector3 bmax,
+	        float cellSize, float cellHeight,
+	        float tileSize,
+            float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+	        float edgeMaxLen, float edgeMaxError,
+	        float regionMinSize, float regionMergeSize,
+	        float detailSampleDist, float detailSampleMaxError,
+	        ref IntPtr pTileCache, ref IntPtr pNavMesh, ref IntPtr pNavQuery,
+            IntPtr rasterizer, int threadCount,
+            int maxObstacles, TileCacheCompression compression, ref TileCacheBuildStats stats);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr nmtcGetTileRasterizer();
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dttcFree(IntPtr tileCache);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void dttcGetAllocatorUsage(IntPtr tileCache
+            , ref int high
+            , ref int capacity);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcAddObstacle(IntPtr tileCache
+            , [In] ref Vector3 pos
+            , float radius
+            , float height
+            , ref uint result);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcAddBoxObstacle(IntPtr tileCache
+            , [In] ref Vector3 bmin
+            , [In] ref Vector3 bmax
+            , ref uint result);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcAddOrientedBoxObstacle(IntPtr tileCache
+            , [In] ref Vector3 center
+            , [In] ref Vector3 halfExtents
+            , float yRadians
+            , ref uint result);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcRemoveObstacle(IntPtr tileCache
+            , uint obstacleRef);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcUpdate(IntPtr tileCache
+            , IntPtr navmesh
+            , int maxTiles
+            , int maxMicroseconds
+            , ref int pendingTiles);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern IntPtr dttcwAlloc(IntPtr tileCache, int maxJobs);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcwFree(IntPtr worker, IntPtr navmesh);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern NavStatus dttcwSync(IntPtr worker
+            , IntPtr navmesh
+            , int maxCommits
+            , ref int pendingTiles);
     }
 }
\ No newline at end of file
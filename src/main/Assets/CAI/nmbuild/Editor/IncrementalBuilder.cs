@@ -386,9 +386,14 @@ namespace org.critterai.nmbuild
             // the heightfield.
             if (PostProcess() && PostCompactFieldCheck())
             {
+                chf = mBuildContext.CompactField;
+
+                // The erosion and region passes are faster on split connection data.
+                // (Optional.  They fall back to a temporary copy.)
+                chf.BuildSpanConnections(mBuildContext);
+
                 if (mConfig.WalkableRadius > 0)
                 {
-                    chf = mBuildContext.CompactField;
                     chf.ErodeWalkableArea(mBuildContext, mConfig.WalkableRadius);
                     mBuildContext.Log("Eroded walkable area by radius: " + mConfig.walkableRadius
                         , this);
@@ -33,8 +33,8 @@ namespace org.critterai.nmgen
     /// This class can be used as a base for a more complete build context.
     /// </para>
     /// <para>
-    /// The message buffer can hold a maximum of 1000 messages comprised of 64K characters.  
-    /// Any messages added after the buffer limit is reached will be ignored.
+    /// The message buffer grows as needed.  Build steps running on several threads can log to 
+    /// the same context.  Messages are returned in the order they were logged.
     /// </para>
     /// </remarks>
     public class BuildContext
@@ -54,19 +54,69 @@ namespace org.critterai.nmgen
         /// </summary>
         public const string WarningLabel = "WARNING";
 
-        private const int MessagePoolSize = 65536;
-
         internal IntPtr root = IntPtr.Zero;
         public IntPtr Root { get { return root; } }
 
         /// <summary>
-        /// The number of messages in the buffer. [Limit: &lt;= 1000]
+        /// The number of messages in the buffer.
         /// </summary>
         public int MessageCount
         {
             get { return BuildContextEx.nmbcGetMessageCount(root); }
         }
 
+        /// <summary>
+        /// The least severe category of message that is logged.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Less severe messages are dropped before they are formatted, so raising the category 
+        /// also cuts the cost of logging in the build steps.  The default is 
+        /// <see cref="BuildLogCategory.Progress"/>.
+        /// </para>
+        /// </remarks>
+        public BuildLogCategory LogCategory
+        {
+            get { return BuildContextEx.nmbcGetLogCategory(root); }
+            set { BuildContextEx.nmbcSetLogCategory(root, value); }
+        }
+
+        /// <summary>
+        /// The number of threads the build steps can use, including the calling thread.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The distance field and region builds of <see cref="CompactHeightfield"/> and the 
+        /// <see cref="PolyMeshDetail"/> build split their work across the threads.  The result 
+        /// is the same for any thread count.
+        /// </para>
+        /// <para>
+        /// Setting a value &lt;= 0 uses one thread per hardware core.  The default is one.
+        /// </para>
+        /// </remarks>
+        public int ThreadCount
+        {
+            get { return BuildContextEx.nmbcGetThreadCount(root); }
+            set { BuildContextEx.nmbcSetThreadCount(root, value); }
+        }
+
+        /// <summary>
+        /// True if the build steps record per-stage times and memory peaks.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Times are kept per thread and per tile, so tile cache builds on several threads can 
+        /// share the context.  Enabling profiling clears the previous profile.  Only change it 
+        /// between builds.
+        /// </para>
+        /// </remarks>
+        /// <seealso cref="GetProfileReport"/>
+        public bool ProfileEnabled
+        {
+            get { return BuildContextEx.nmbcGetProfileEnabled(root); }
+            set { BuildContextEx.nmbcEnableProfile(root, value); }
+        }
+
         /// <summary>
         /// Constructor.
         /// </summary>
@@ -116,7 +166,7 @@ namespace org.critterai.nmgen
 
             foreach (string msg in messages)
             {
-                BuildContextEx.nmbcLog(root, msg);
+                BuildContextEx.nmbcLog(root, BuildLogCategory.Progress, msg);
             }
         }
 
@@ -128,11 +178,7 @@ namespace org.critterai.nmgen
         /// <param name="context">The context of the message. (Optional)</param>
         public void Log(string category, string message, Object context)
         {
-            if (message != null && message.Length > 0)
-            {
-                BuildContextEx.nmbcLog(root, string.Format("{0}: {1}{2}"
-                    , category, message, ContextPart(context)));
-            }
+            Log(BuildLogCategory.Progress, category, message, context);
         }
 
         /// <summary>
@@ -142,7 +188,7 @@ namespace org.critterai.nmgen
         /// <param name="context">The context of the message. (Optional)</param>
         public void LogWarning(string message, Object context)
         {
-            Log(WarningLabel, message, context);
+            Log(BuildLogCategory.Warning, WarningLabel, message, context);
         }
 
         /// <summary>
@@ -152,7 +198,7 @@ namespace org.critterai.nmgen
         /// <param name="context">The context of the message. (Optional)</param>
         public void LogError(string message, Object context)
         {
-            Log(ErrorLabel, message, context);
+            Log(BuildLogCategory.Error, ErrorLabel, message, context);
         }
 
         /// <summary>
@@ -168,7 +214,11 @@ namespace org.critterai.nmgen
         /// </returns>
         public string[] GetMessages()
         {
-            byte[] buffer = new byte[MessagePoolSize];
+            int length = BuildContextEx.nmbcGetMessagePoolLength(root);
+            if (length == 0)
+                return new string[0];
+
+            byte[] buffer = new byte[length];
 
             int messageCount = BuildContextEx.nmbcGetMessagePool(root
                 , buffer
@@ -217,7 +267,36 @@ namespace org.critterai.nmgen
             string[] msgs = fromContext.GetMessages();
             foreach (string msg in msgs)
             {
-                BuildContextEx.nmbcLog(root, msg);
+                BuildContextEx.nmbcLog(root, BuildLogCategory.Progress, msg);
+            }
+        }
+
+        /// <summary>
+        /// Gets the profile of the builds run since profiling was enabled.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// The report has the total, maximum and call count of each stage, the time of each stage 
+        /// on each thread, and the stage times and memory peak of each tile.  Times are in 
+        /// microseconds and memory in bytes.
+        /// </para>
+        /// </remarks>
+        /// <param name="format">The report format.</param>
+        /// <returns>The report.</returns>
+        public string GetProfileReport(ProfileReportFormat format)
+        {
+            int length = BuildContextEx.nmbcGetProfileReport(root, format, null, 0);
+            byte[] buffer = new byte[length + 1];
+            BuildContextEx.nmbcGetProfileReport(root, format, buffer, buffer.Length);
+            return ASCIIEncoding.ASCII.GetString(buffer, 0, length);
+        }
+
+        private void Log(BuildLogCategory level, string category, string message, Object context)
+        {
+            if (message != null && message.Length > 0)
+            {
+                BuildContextEx.nmbcLog(root, level, string.Format("{0}: {1}{2}"
+                    , category, message, ContextPart(context)));
             }
         }
 
@@ -139,6 +139,7 @@ namespace org.critterai.nmgen
         private IntPtr mSpans = IntPtr.Zero;	// rcCompactSpan[spanCount]
         private IntPtr mDistanceToBorder = IntPtr.Zero;	// ushort[spanCount]
         private IntPtr mAreas = IntPtr.Zero;	// byte[spanCount]
+        private IntPtr mCons = IntPtr.Zero;     // uint[spanCount]
 
         /// <summary>
         /// The width of the heightfield. (Along the x-axis in cell units.)
@@ -371,6 +372,34 @@ namespace org.critterai.nmgen
             get { return (mDistanceToBorder != IntPtr.Zero); } 
         }
 
+        /// <summary>
+        /// True if the split connection data is available.
+        /// </summary>
+        public bool HasSpanConnections { get { return (mCons != IntPtr.Zero); } }
+
+        /// <summary>
+        /// Copies the span connection data into a separate array.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// Erosion, distance field and region builds only need the connection part of each 
+        /// span.  They run faster on the split copy, and build a temporary one on each call 
+        /// if it is not available.  Use this method once when the field is going to go 
+        /// through several of them.
+        /// </para>
+        /// <para>
+        /// The split data uses an additional four bytes per span.
+        /// </para>
+        /// </remarks>
+        /// <param name="context">The context to use during the operation.</param>
+        /// <returns>True if the operation completed successfully.</returns>
+        public bool BuildSpanConnections(BuildContext context)
+        {
+            if (IsDisposed)
+                return false;
+            return CompactHeightfieldEx.nmcfBuildSpanCons(context.root, this);
+        }
+
         /// <summary>
         /// Erodes the walkable area within the heightfield by the specified radius.
         /// </summary>
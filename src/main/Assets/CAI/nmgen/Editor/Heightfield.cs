@@ -202,6 +202,67 @@ namespace org.critterai.nmgen
                 , xzCellSize, yCellSize);
         }
 
+        /// <summary>
+        /// Clears the heightfield so it can be used for a new build.
+        /// </summary>
+        /// <remarks>
+        /// <para>
+        /// This is cheaper than disposing of the field and creating a new one.  The span 
+        /// memory is kept, and so is the column data if the cell count is unchanged.
+        /// </para>
+        /// </remarks>
+        /// <param name="width">The width of the field. [Limit: >= 1] [Units: Cells]</param>
+        /// <param name="depth">The depth of the field. [Limit: >= 1] [Units: Cells]</param>
+        /// <param name="boundsMin">The minimum bounds of the field's AABB. [Units: World]</param>
+        /// <param name="boundsMax">The maximum bounds of the field's AABB. [Units: World]</param>
+        /// <param name="xzCellSize">
+        /// The xz-plane cell size. [Limit:>= <see cref="NMGen.MinCellSize"/>] [Units: World]
+        /// </param>
+        /// <param name="yCellSize">
+        /// The y-axis span increments. [Limit:>= <see cref="NMGen.MinCellSize"/>] [Units: World]
+        /// </param>
+        /// <returns>True if the operation was successful.</returns>
+        public bool Reset(int width, int depth
+            , Vector3 boundsMin, Vector3 boundsMax
+            , float xzCellSize, float yCellSize)
+        {
+            if (IsDisposed
+                || width < 1 || depth < 1
+                || !TriangleMesh.IsBoundsValid(boundsMin, boundsMax)
+                || xzCellSize < NMGen.MinCellSize
+                || yCellSize < NMGen.MinCellSize)
+            {
+                return false;
+            }
+
+            if (!HeightfieldEx.nmhfResetField(root, width, depth
+                , ref boundsMin, ref boundsMax, xzCellSize, yCellSize))
+            {
+                return false;
+            }
+
+            mWidth = width;
+            mDepth = depth;
+            mBoundsMin = boundsMin;
+            mBoundsMax = boundsMax;
+            mXZCellSize = xzCellSize;
+            mYCellSize = yCellSize;
+
+            return true;
+        }
+
+        /// <summary>
+        /// Gets the span memory counters shared by all heightfields.
+        /// </summary>
+        /// <param name="reset">True if the counters should be set to zero after reading.</param>
+        /// <returns>The counters.</returns>
+        public static HeightfieldAllocStats GetAllocStats(bool reset)
+        {
+            HeightfieldAllocStats result = new HeightfieldAllocStats();
+            HeightfieldEx.nmhfGetAllocStats(ref result, reset);
+            return result;
+        }
+
         /// <summary>
         /// Frees all resources and marks object as disposed.
         /// </summary>
@@ -0,0 +1,59 @@
+﻿/*
+ * Copyright (c) 2011 Stephen A. Pratt
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+using System.Runtime.InteropServices;
+
+namespace org.critterai.nmgen
+{
+    /// <summary>
+    /// Counters for the memory used by heightfield spans.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The counters are shared by all heightfields.  Use them to confirm that 
+    /// <see cref="Heightfield.Reset"/> is reusing span memory between builds.
+    /// </para>
+    /// </remarks>
+    /// <seealso cref="Heightfield.GetAllocStats"/>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct HeightfieldAllocStats
+    {
+        /// <summary>
+        /// The number of span pools allocated.
+        /// </summary>
+        public int poolsAllocated;
+
+        /// <summary>
+        /// The number of span pools kept for the next build by a reset.
+        /// </summary>
+        public int poolsReused;
+
+        /// <summary>
+        /// The number of span column arrays allocated.
+        /// </summary>
+        public int columnsAllocated;
+
+        /// <summary>
+        /// The number of span column arrays kept for the next build by a reset.
+        /// </summary>
+        public int columnsReused;
+    }
+}
@@ -32,6 +32,12 @@ namespace org.critterai.nmgen.rcn
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void nmbcFreeContext(IntPtr context);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmbcSetThreadCount(IntPtr context, int threadCount);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetThreadCount(IntPtr context);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool nmbcGetLogEnabled(IntPtr context);
 
@@ -44,13 +50,35 @@ namespace org.critterai.nmgen.rcn
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int nmbcGetMessageCount(IntPtr context);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetMessagePoolLength(IntPtr context);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern int nmbcGetMessagePool(IntPtr context
             , [In, Out] byte[] messageBuffer
             , int bufferSize);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmbcEnableProfile(IntPtr context, bool state);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmbcGetProfileEnabled(IntPtr context);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern int nmbcGetProfileReport(IntPtr context
+            , ProfileReportFormat format
+            , [In, Out] byte[] buffer
+            , int bufferSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmbcSetLogCategory(IntPtr context, BuildLogCategory category);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern BuildLogCategory nmbcGetLogCategory(IntPtr context);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void nmbcLog(IntPtr ctx
+            , BuildLogCategory category
             , [In, MarshalAs(UnmanagedType.LPStr)] string message);
 
         // Note: It is ok for the method prefix to be different.
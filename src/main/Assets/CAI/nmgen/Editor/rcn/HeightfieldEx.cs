@@ -42,6 +42,19 @@ namespace org.critterai.nmgen.rcn
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern void nmhfFreeField(IntPtr hf);
 
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern bool nmhfResetField(IntPtr hf
+            , int width
+            , int depth
+            , [In] ref Vector3 boundsMin
+            , [In] ref Vector3 boundsMax
+            , float xzCellSize
+            , float yCellSize);
+
+        [DllImport(InteropUtil.PLATFORM_DLL)]
+        public static extern void nmhfGetAllocStats(ref HeightfieldAllocStats stats
+            , bool reset);
+
         [DllImport(InteropUtil.PLATFORM_DLL)]
         public static extern bool nmhfRasterizeTriangle(IntPtr context
             , [In] Vector3[] verts
@@ -122,6 +122,7 @@ enum dtStraightPathOptions
 enum dtFindPathOptions
 {
 	DT_FINDPATH_ANY_ANGLE	= 0x02,		///< use raycasts during pathfind to "shortcut" (raycast still consider costs)
+	DT_FINDPATH_BIDIRECTIONAL = 0x04,	///< search from both ends at once (can't be combined with DT_FINDPATH_ANY_ANGLE)
 };
 
 /// Options for dtNavMeshQuery::raycast
@@ -276,6 +277,10 @@ struct dtMeshHeader
 struct dtMeshTile
 {
 	unsigned int salt;					///< Counter describing modifications to the tile.
+	
+	/// Counter of changes to the polygon flags and areas through the navigation mesh,
+	/// and of the tile's removal.  (Unlike #salt, it is never restored.)
+	unsigned int polyRevision;
 
 	unsigned int linksFreeList;			///< Index to the next free link.
 	dtMeshHeader* header;				///< The tile header.
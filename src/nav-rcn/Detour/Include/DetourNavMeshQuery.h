@@ -161,6 +161,32 @@ public:
 	virtual void process(const dtMeshTile* tile, dtPoly** polys, dtPolyRef* refs, int count) = 0;
 };
 
+/// The maximum number of floats a dtPathHeuristic can keep about a goal.
+static const int DT_MAX_HEURISTIC_GOAL = 16;
+
+/// Provides a lower bound on the cost of the rest of a path to the A* searches
+/// of dtNavMeshQuery, for meshes where the straight line distance is a poor
+/// estimate.  The searches use the larger of the two.  If the bound can be
+/// more than the real cost, the paths found may be longer than the shortest.
+/// Used by dtNavMeshQuery::setHeuristic.
+/// @ingroup detour
+class dtPathHeuristic
+{
+public:
+	virtual ~dtPathHeuristic() { }
+
+	/// Gets what getLowerBound needs to know about the goal polygon.
+	///  @param[in]		ref		The reference id of the goal polygon.
+	///  @param[out]	goal	The goal data. [(float) * #DT_MAX_HEURISTIC_GOAL]
+	/// @returns False if there is no bound for paths to the polygon.
+	virtual bool getGoal(dtPolyRef ref, float* goal) const = 0;
+
+	/// Gets a lower bound on the cost of any path from the polygon to the goal.
+	///  @param[in]		ref		The reference id of the polygon.
+	///  @param[in]		goal	The data from getGoal.
+	virtual float getLowerBound(dtPolyRef ref, const float* goal) const = 0;
+};
+
 /// Provides the ability to perform pathfinding related queries against
 /// a navigation mesh.
 /// @ingroup detour
@@ -172,7 +198,7 @@ public:
 	
 	/// Initializes the query object.
 	///  @param[in]		nav			Pointer to the dtNavMesh object to use for all queries.
-	///  @param[in]		maxNodes	Maximum number of search nodes. [Limits: 0 < value <= 65535]
+	///  @param[in]		maxNodes	Maximum number of search nodes. [Limits: 0 < value < 2^24]
 	/// @returns The status flags for the query.
 	dtStatus init(const dtNavMesh* nav, const int maxNodes);
 	
@@ -194,6 +220,24 @@ public:
 					  const dtQueryFilter* filter,
 					  dtPolyRef* path, int* pathCount, const int maxPath) const;
 
+	/// Finds a path from the start polygon to the end polygon using the sliced path query.
+	///  @param[in]		startRef	The refrence id of the start polygon.
+	///  @param[in]		endRef		The reference id of the end polygon.
+	///  @param[in]		startPos	A position within the start polygon. [(x, y, z)]
+	///  @param[in]		endPos		A position within the end polygon. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	path		An ordered list of polygon references representing the path. (Start to end.) 
+	///  							[(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons returned in the @p path array.
+	///  @param[in]		maxPath		The maximum number of polygons the @p path array can hold. [Limit: >= 1]
+	///  @param[in]		options		Query options. (see: #dtFindPathOptions)
+	/// @returns The status flags for the query.
+	dtStatus findPath(dtPolyRef startRef, dtPolyRef endRef,
+					  const float* startPos, const float* endPos,
+					  const dtQueryFilter* filter,
+					  dtPolyRef* path, int* pathCount, const int maxPath,
+					  const unsigned int options);
+
 	/// Finds the straight path from the start to the end position within the polygon corridor.
 	///  @param[in]		startPos			Path start position. [(x, y, z)]
 	///  @param[in]		endPos				Path end position. [(x, y, z)]
@@ -504,6 +548,15 @@ public:
 	/// Gets the navigation mesh the query object is using.
 	/// @return The navigation mesh the query object is using.
 	const dtNavMesh* getAttachedNavMesh() const { return m_nav; }
+	
+	/// Sets the heuristic used by the path searches along with the straight
+	/// line distance.  It must outlive its use by the query.
+	///  @param[in]		heuristic	The heuristic, or null for none.
+	void setHeuristic(const dtPathHeuristic* heuristic) { m_heuristic = heuristic; }
+	
+	/// Gets the heuristic used by the path searches.
+	/// @return The heuristic, or null if there is none.
+	const dtPathHeuristic* getHeuristic() const { return m_heuristic; }
 
 	/// @}
 	
@@ -541,6 +594,14 @@ private:
 
 	// Gets the path leading to the specified end node.
 	dtStatus getPathToNode(struct dtNode* endNode, dtPolyRef* path, int* pathCount, int maxPath) const;
+
+	// Bidirectional sliced path query.  (See: #DT_FINDPATH_BIDIRECTIONAL)
+	dtStatus initBidirectionalPools(const bool allocate);
+	dtStatus expandBidirectional(const int side);
+	void checkMeeting(const int side, struct dtNode* node,
+					  dtPolyRef ref, const dtMeshTile* tile, const dtPoly* poly);
+	dtStatus updateSlicedFindPathBidirectional(const int maxIter, int* doneIters);
+	dtStatus finalizeSlicedFindPathBidirectional(dtPolyRef* path, int* pathCount, const int maxPath);
 	
 	const dtNavMesh* m_nav;				///< Pointer to navmesh data.
 
@@ -554,12 +615,26 @@ private:
 		const dtQueryFilter* filter;
 		unsigned int options;
 		float raycastLimitSqr;
+		
+		// Bidirectional query state.
+		float meetCost;						///< Cost of the best path found through both searches.
+		struct dtNode* meetNode;			///< The forward node on that path.
+		struct dtNode* meetBackNode;		///< The backward node for the same polygon.
+		
+		// Heuristic goal data for each search.  (See: dtPathHeuristic)
+		bool useGoal;
+		bool useBackGoal;
+		float goal[DT_MAX_HEURISTIC_GOAL];
+		float backGoal[DT_MAX_HEURISTIC_GOAL];
 	};
 	dtQueryData m_query;				///< Sliced query state.
 
 	class dtNodePool* m_tinyNodePool;	///< Pointer to small node pool.
 	class dtNodePool* m_nodePool;		///< Pointer to node pool.
 	class dtNodeQueue* m_openList;		///< Pointer to open list queue.
+	class dtNodePool* m_backNodePool;	///< Node pool of the backward search.  (Allocated on first use.)
+	class dtNodeQueue* m_backOpenList;	///< Open list of the backward search.  (Allocated on first use.)
+	const dtPathHeuristic* m_heuristic;	///< Lower bound used along with the straight line distance.  (Optional.)
 };
 
 /// Allocates a query object using the Detour allocator.
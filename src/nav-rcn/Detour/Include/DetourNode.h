@@ -28,7 +28,7 @@ enum dtNodeFlags
 	DT_NODE_PARENT_DETACHED = 0x04, // parent of the node is not adjacent. Found using raycast.
 };
 
-typedef unsigned short dtNodeIndex;
+typedef unsigned int dtNodeIndex;
 static const dtNodeIndex DT_NULL_IDX = (dtNodeIndex)~0;
 
 static const int DT_NODE_PARENT_BITS = 24;
@@ -46,9 +46,16 @@ struct dtNode
 
 static const int DT_MAX_STATES_PER_NODE = 1 << DT_NODE_STATE_BITS;	// number of extra states per node. See dtNode::state
 
+/// Allocates search nodes and finds them by polygon ref and state.
+///
+/// Each bucket head is tagged with the generation it was written in, so
+/// clear() only advances the generation.  A head from an older generation
+/// reads as empty.  The table is wiped only when the generation wraps.
 class dtNodePool
 {
 public:
+	/// @param[in]	maxNodes	The maximum number of nodes. [Limit: 0 < value < 2^DT_NODE_PARENT_BITS]
+	/// @param[in]	hashSize	The number of hash buckets. [Limit: Power of two]
 	dtNodePool(int maxNodes, int hashSize);
 	~dtNodePool();
 	void clear();
@@ -88,7 +95,7 @@ public:
 	inline int getMaxNodes() const { return m_maxNodes; }
 	
 	inline int getHashSize() const { return m_hashSize; }
-	inline dtNodeIndex getFirst(int bucket) const { return m_first[bucket]; }
+	inline dtNodeIndex getFirst(int bucket) const { return getHead((unsigned int)bucket); }
 	inline dtNodeIndex getNext(int i) const { return m_next[i]; }
 	inline int getNodeCount() const { return m_nodeCount; }
 	
@@ -97,12 +104,21 @@ private:
 	dtNodePool(const dtNodePool&);
 	dtNodePool& operator=(const dtNodePool&);
 	
+	static const dtNodeIndex DT_NODE_IDX_MASK = (1u << DT_NODE_PARENT_BITS) - 1;
+
+	inline dtNodeIndex getHead(unsigned int bucket) const
+	{
+		const dtNodeIndex head = m_first[bucket];
+		return (head >> DT_NODE_PARENT_BITS) == m_gen ? (head & DT_NODE_IDX_MASK) : DT_NULL_IDX;
+	}
+	
 	dtNode* m_nodes;
-	dtNodeIndex* m_first;
+	dtNodeIndex* m_first;	///< Generation in the top bits, node index in the low DT_NODE_PARENT_BITS.
 	dtNodeIndex* m_next;
 	const int m_maxNodes;
 	const int m_hashSize;
 	int m_nodeCount;
+	dtNodeIndex m_gen;
 };
 
 class dtNodeQueue
@@ -142,6 +158,7 @@ public:
 	}
 	
 	inline bool empty() const { return m_size == 0; }
+	inline int size() const { return m_size; }
 	
 	inline int getMemUsed() const
 	{
@@ -1246,6 +1246,7 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	tile->detailTris = 0;
 	tile->bvTree = 0;
 	tile->offMeshCons = 0;
+	tile->polyRevision++;
 
 	// Update salt, salt should never be zero.
 #ifdef DT_POLYREF64
@@ -1376,6 +1377,7 @@ dtStatus dtNavMesh::restoreTileState(dtMeshTile* tile, const unsigned char* data
 		p->flags = s->flags;
 		p->setArea(s->area);
 	}
+	tile->polyRevision++;
 	
 	return DT_SUCCESS;
 }
@@ -1468,6 +1470,7 @@ dtStatus dtNavMesh::setPolyFlags(dtPolyRef ref, unsigned short flags)
 	
 	// Change flags.
 	poly->flags = flags;
+	tile->polyRevision++;
 	
 	return DT_SUCCESS;
 }
@@ -1500,6 +1503,7 @@ dtStatus dtNavMesh::setPolyArea(dtPolyRef ref, unsigned char area)
 	dtPoly* poly = &tile->polys[ip];
 	
 	poly->setArea(area);
+	tile->polyRevision++;
 	
 	return DT_SUCCESS;
 }
@@ -54,12 +54,13 @@ dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 	m_next(0),
 	m_maxNodes(maxNodes),
 	m_hashSize(hashSize),
-	m_nodeCount(0)
+	m_nodeCount(0),
+	m_gen(1)
 {
 	dtAssert(dtNextPow2(m_hashSize) == (unsigned int)m_hashSize);
 	// pidx is special as 0 means "none" and 1 is the first node. For that reason
 	// we have 1 fewer nodes available than the number of values it can contain.
-	dtAssert(m_maxNodes > 0 && m_maxNodes <= DT_NULL_IDX && m_maxNodes <= (1 << DT_NODE_PARENT_BITS) - 1);
+	dtAssert(m_maxNodes > 0 && m_maxNodes <= (1 << DT_NODE_PARENT_BITS) - 1);
 
 	m_nodes = (dtNode*)dtAlloc(sizeof(dtNode)*m_maxNodes, DT_ALLOC_PERM);
 	m_next = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*m_maxNodes, DT_ALLOC_PERM);
@@ -69,7 +70,7 @@ dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 	dtAssert(m_next);
 	dtAssert(m_first);
 
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
+	memset(m_first, 0, sizeof(dtNodeIndex)*m_hashSize);
 	memset(m_next, 0xff, sizeof(dtNodeIndex)*m_maxNodes);
 }
 
@@ -82,15 +83,23 @@ dtNodePool::~dtNodePool()
 
 void dtNodePool::clear()
 {
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
 	m_nodeCount = 0;
+
+	// Heads from older generations read as empty.  Only wipe them when the
+	// generation wraps.  (Generation zero is never used.)
+	m_gen++;
+	if (m_gen > (~0u >> DT_NODE_PARENT_BITS))
+	{
+		memset(m_first, 0, sizeof(dtNodeIndex)*m_hashSize);
+		m_gen = 1;
+	}
 }
 
 unsigned int dtNodePool::findNodes(dtPolyRef id, dtNode** nodes, const int maxNodes)
 {
 	int n = 0;
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = getHead(bucket);
 	while (i != DT_NULL_IDX)
 	{
 		if (m_nodes[i].id == id)
@@ -108,7 +117,7 @@ unsigned int dtNodePool::findNodes(dtPolyRef id, dtNode** nodes, const int maxNo
 dtNode* dtNodePool::findNode(dtPolyRef id, unsigned char state)
 {
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = getHead(bucket);
 	while (i != DT_NULL_IDX)
 	{
 		if (m_nodes[i].id == id && m_nodes[i].state == state)
@@ -121,7 +130,7 @@ dtNode* dtNodePool::findNode(dtPolyRef id, unsigned char state)
 dtNode* dtNodePool::getNode(dtPolyRef id, unsigned char state)
 {
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = getHead(bucket);
 	dtNode* node = 0;
 	while (i != DT_NULL_IDX)
 	{
@@ -145,8 +154,8 @@ dtNode* dtNodePool::getNode(dtPolyRef id, unsigned char state)
 	node->state = state;
 	node->flags = 0;
 	
-	m_next[i] = m_first[bucket];
-	m_first[bucket] = i;
+	m_next[i] = getHead(bucket);
+	m_first[bucket] = (m_gen << DT_NODE_PARENT_BITS) | i;
 	
 	return node;
 }
@@ -198,6 +198,30 @@ struct dtCrowdAgentDebugInfo
 	dtObstacleAvoidanceDebugData* vod;
 };
 
+/// A range of crowd update work.
+///  @param[in]		ctx		The context passed to dtCrowdJobSystem::run().
+///  @param[in]		begin	The first item in the range.
+///  @param[in]		end		One past the last item in the range.
+///  @param[in]		thread	The index of the thread running the range. [Limits: 0 <= value < dtCrowdJobSystem::getThreadCount()]
+/// @ingroup crowd
+typedef void (*dtCrowdJobFunc)(void* ctx, const int begin, const int end, const int thread);
+
+/// Runs crowd update work on multiple threads.  Implemented by the host.
+/// @ingroup crowd
+/// @see dtCrowd::update()
+class dtCrowdJobSystem
+{
+public:
+	virtual ~dtCrowdJobSystem() {}
+	
+	/// The number of threads work can run on, including the calling thread.
+	virtual int getThreadCount() const = 0;
+	
+	/// Calls @p job for ranges covering [0, @p count) and returns once all have finished.
+	/// Ranges running at the same time must have different thread indices.
+	virtual void run(dtCrowdJobFunc job, void* ctx, const int count) = 0;
+};
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
@@ -205,6 +229,9 @@ class dtCrowd
 	int m_maxAgents;
 	dtCrowdAgent* m_agents;
 	dtCrowdAgent** m_activeAgents;
+	int m_nactiveAgents;	// As of the last update.
+	int* m_removedAgents;
+	int m_nremovedAgents;	// -1 if more agents were removed than could be kept.
 	dtCrowdAgentAnimation* m_agentAnims;
 	
 	dtPathQueue m_pathq;
@@ -227,6 +254,19 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	// Per-thread scratch for parallel updates.  Entry 0 is the crowd's own query.
+	int m_maxThreads;
+	dtNavMeshQuery** m_threadNavQueries;
+	dtObstacleAvoidanceQuery** m_threadObstacleQueries;
+	int* m_threadSampleCounts;
+
+	void updatePhase(const int phase, dtCrowdAgent** agents, const int nagents,
+					 const int begin, const int end, const int thread,
+					 const float dt, dtCrowdAgentDebugInfo* debug);
+	void runPhase(dtCrowdJobSystem* jobs, const int phase, dtCrowdAgent** agents, const int nagents,
+				  const float dt, dtCrowdAgentDebugInfo* debug);
+	static void runPhaseJob(void* ctx, const int begin, const int end, const int thread);
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
@@ -236,6 +276,7 @@ class dtCrowd
 	bool requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos);
 
 	void purge();
+	void purgeThreads();
 	
 public:
 	dtCrowd();
@@ -248,6 +289,14 @@ public:
 	/// @return True if the initialization succeeded.
 	bool init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav);
 	
+	/// Allocates the per-thread scratch used by a parallel #update().
+	///  @param[in]		maxThreads		The maximum number of threads the update can run on. [Limit: >= 1]
+	/// @return True if the initialization succeeded.
+	bool initThreads(const int maxThreads);
+	
+	/// The maximum number of threads the update can run on.
+	inline int getMaxThreads() const { return m_maxThreads; }
+	
 	/// Sets the shared avoidance configuration for the specified index.
 	///  @param[in]		idx		The index. [Limits: 0 <= value < #DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS]
 	///  @param[in]		params	The new configuration.
@@ -312,11 +361,32 @@ public:
 	/// @return The number of agents returned in @p agents.
 	int getActiveAgents(dtCrowdAgent** agents, const int maxAgents);
 
+	/// Gets the agents that were active in the last #update, without searching the pool.
+	/// Agents removed since then are still listed.
+	///  @param[out]	count	The number of agents returned.
+	/// @return The agents.
+	dtCrowdAgent* const* getUpdatedAgents(int* count) const { *count = m_nactiveAgents; return m_activeAgents; }
+
+	/// Gets the agents removed since the last #clearRemovedAgents.  An agent that was removed,
+	/// added again and removed again is listed twice.
+	///  @param[out]	indices		The agent indices.
+	/// @return The number of indices, or -1 if more agents were removed than the list can hold.
+	int getRemovedAgents(const int** indices) const { *indices = m_removedAgents; return m_nremovedAgents; }
+
+	/// Clears the list returned by #getRemovedAgents.
+	void clearRemovedAgents() { m_nremovedAgents = 0; }
+
 	/// Updates the steering and positions of all agents.
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
 	void update(const float dt, dtCrowdAgentDebugInfo* debug);
 	
+	/// Updates the steering and positions of all agents, running the per-agent work through a job system.
+	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
+	///  @param[out]	debug	A debug object to load with debug information. [Opt]
+	///  @param[in]		jobs	The job system to run the update on. [Opt]
+	void update(const float dt, dtCrowdAgentDebugInfo* debug, dtCrowdJobSystem* jobs);
+	
 	/// Gets the filter used by the crowd.
 	/// @return The filter used by the crowd.
 	inline const dtQueryFilter* getFilter(const int i) const { return (i >= 0 && i < DT_CROWD_MAX_QUERY_FILTER_TYPE) ? &m_filters[i] : 0; }
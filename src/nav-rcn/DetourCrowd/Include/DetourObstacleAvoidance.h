@@ -138,6 +138,12 @@ private:
 						const float minPenalty,
 						dtObstacleAvoidanceDebugData* debug);
 
+	void processSamples(const float* vx, const float* vz, const int n, const float cs,
+						const float* pos, const float rad,
+						const float* vel, const float* dvel,
+						float& minPenalty, float* bestVel,
+						dtObstacleAvoidanceDebugData* debug);
+
 	dtObstacleAvoidanceParams m_params;
 	float m_invHorizTime;
 	float m_vmax;
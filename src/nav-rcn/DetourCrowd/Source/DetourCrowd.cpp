@@ -333,6 +333,9 @@ dtCrowd::dtCrowd() :
 	m_maxAgents(0),
 	m_agents(0),
 	m_activeAgents(0),
+	m_nactiveAgents(0),
+	m_removedAgents(0),
+	m_nremovedAgents(0),
 	m_agentAnims(0),
 	m_obstacleQuery(0),
 	m_grid(0),
@@ -340,7 +343,11 @@ dtCrowd::dtCrowd() :
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_navquery(0),
+	m_maxThreads(0),
+	m_threadNavQueries(0),
+	m_threadObstacleQueries(0),
+	m_threadSampleCounts(0)
 {
 }
 
@@ -351,6 +358,8 @@ dtCrowd::~dtCrowd()
 
 void dtCrowd::purge()
 {
+	purgeThreads();
+	
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -359,6 +368,11 @@ void dtCrowd::purge()
 	
 	dtFree(m_activeAgents);
 	m_activeAgents = 0;
+	m_nactiveAgents = 0;
+
+	dtFree(m_removedAgents);
+	m_removedAgents = 0;
+	m_nremovedAgents = 0;
 
 	dtFree(m_agentAnims);
 	m_agentAnims = 0;
@@ -435,6 +449,10 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	if (!m_activeAgents)
 		return false;
 
+	m_removedAgents = (int*)dtAlloc(sizeof(int)*m_maxAgents, DT_ALLOC_PERM);
+	if (!m_removedAgents)
+		return false;
+
 	m_agentAnims = (dtCrowdAgentAnimation*)dtAlloc(sizeof(dtCrowdAgentAnimation)*m_maxAgents, DT_ALLOC_PERM);
 	if (!m_agentAnims)
 		return false;
@@ -459,6 +477,72 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	if (dtStatusFailed(m_navquery->init(nav, MAX_COMMON_NODES)))
 		return false;
 	
+	return initThreads(1);
+}
+
+void dtCrowd::purgeThreads()
+{
+	// Entry 0 belongs to the crowd.
+	for (int i = 1; i < m_maxThreads; ++i)
+	{
+		dtFreeNavMeshQuery(m_threadNavQueries[i]);
+		dtFreeObstacleAvoidanceQuery(m_threadObstacleQueries[i]);
+	}
+	dtFree(m_threadNavQueries);
+	m_threadNavQueries = 0;
+	dtFree(m_threadObstacleQueries);
+	m_threadObstacleQueries = 0;
+	dtFree(m_threadSampleCounts);
+	m_threadSampleCounts = 0;
+	m_maxThreads = 0;
+}
+
+/// @par
+///
+/// Must be called after #init().  Each thread gets its own navigation mesh query and obstacle
+/// avoidance query.
+bool dtCrowd::initThreads(const int maxThreads)
+{
+	if (maxThreads < 1 || !m_navquery || !m_obstacleQuery)
+		return false;
+	
+	purgeThreads();
+	
+	m_threadNavQueries = (dtNavMeshQuery**)dtAlloc(sizeof(dtNavMeshQuery*)*maxThreads, DT_ALLOC_PERM);
+	m_threadObstacleQueries = (dtObstacleAvoidanceQuery**)dtAlloc(sizeof(dtObstacleAvoidanceQuery*)*maxThreads, DT_ALLOC_PERM);
+	m_threadSampleCounts = (int*)dtAlloc(sizeof(int)*maxThreads, DT_ALLOC_PERM);
+	if (!m_threadNavQueries || !m_threadObstacleQueries || !m_threadSampleCounts)
+	{
+		dtFree(m_threadNavQueries);
+		m_threadNavQueries = 0;
+		dtFree(m_threadObstacleQueries);
+		m_threadObstacleQueries = 0;
+		dtFree(m_threadSampleCounts);
+		m_threadSampleCounts = 0;
+		return false;
+	}
+	memset(m_threadNavQueries, 0, sizeof(dtNavMeshQuery*)*maxThreads);
+	memset(m_threadObstacleQueries, 0, sizeof(dtObstacleAvoidanceQuery*)*maxThreads);
+	memset(m_threadSampleCounts, 0, sizeof(int)*maxThreads);
+	m_maxThreads = maxThreads;
+	
+	m_threadNavQueries[0] = m_navquery;
+	m_threadObstacleQueries[0] = m_obstacleQuery;
+	
+	for (int i = 1; i < maxThreads; ++i)
+	{
+		m_threadNavQueries[i] = dtAllocNavMeshQuery();
+		m_threadObstacleQueries[i] = dtAllocObstacleAvoidanceQuery();
+		if (!m_threadNavQueries[i] || !m_threadObstacleQueries[i]
+			|| dtStatusFailed(m_threadNavQueries[i]->init(m_navquery->getAttachedNavMesh(), MAX_COMMON_NODES))
+			|| !m_threadObstacleQueries[i]->init(6, 8))
+		{
+			// Fall back to serial updates.
+			initThreads(1);
+			return false;
+		}
+	}
+	
 	return true;
 }
 
@@ -574,6 +658,13 @@ void dtCrowd::removeAgent(const int idx)
 {
 	if (idx >= 0 && idx < m_maxAgents)
 	{
+		if (m_agents[idx].active && m_nremovedAgents >= 0)
+		{
+			if (m_nremovedAgents < m_maxAgents)
+				m_removedAgents[m_nremovedAgents++] = idx;
+			else
+				m_nremovedAgents = -1;
+		}
 		m_agents[idx].active = false;
 	}
 }
@@ -1044,298 +1135,315 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 	}
 }
 	
-void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+// The per-agent phases of dtCrowd::update, in update order.
+enum dtCrowdUpdatePhase
 {
-	m_velocitySampleCount = 0;
-	
+	DT_CROWD_PHASE_NEIGHBOURS,
+	DT_CROWD_PHASE_CORNERS,
+	DT_CROWD_PHASE_OFFMESH,
+	DT_CROWD_PHASE_STEERING,
+	DT_CROWD_PHASE_VELOCITY_PLANNING,
+	DT_CROWD_PHASE_INTEGRATE,
+	DT_CROWD_PHASE_COLLISION_DISP,
+	DT_CROWD_PHASE_COLLISION_APPLY,
+	DT_CROWD_PHASE_MOVE,
+};
+
+struct dtCrowdPhaseContext
+{
+	dtCrowd* crowd;
+	int phase;
+	dtCrowdAgent** agents;
+	int nagents;
+	float dt;
+	dtCrowdAgentDebugInfo* debug;
+};
+
+void dtCrowd::updatePhase(const int phase, dtCrowdAgent** agents, const int nagents,
+						  const int begin, const int end, const int thread,
+						  const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	dtNavMeshQuery* navquery = m_threadNavQueries[thread];
+	dtObstacleAvoidanceQuery* obstacleQuery = m_threadObstacleQueries[thread];
 	const int debugIdx = debug ? debug->idx : -1;
 	
-	dtCrowdAgent** agents = m_activeAgents;
-	int nagents = getActiveAgents(agents, m_maxAgents);
-
-	// Check that all agents still have valid paths.
-	checkPathValidity(agents, nagents, dt);
-	
-	// Update async move request and path finder.
-	updateMoveRequest(dt);
-
-	// Optimize path topology.
-	updateTopologyOptimization(agents, nagents, dt);
-	
-	// Register agents to proximity grid.
-	m_grid->clear();
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		const float* p = ag->npos;
-		const float r = ag->params.radius;
-		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
-	}
-	
-	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
+	switch (phase)
 	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-
-		// Update the collision boundary after certain distance has been passed or
-		// if it has become invalid.
-		const float updateThr = ag->params.collisionQueryRange*0.25f;
-		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
+	case DT_CROWD_PHASE_NEIGHBOURS:
+		// Get nearby navmesh segments and agents to collide with.
+		for (int i = begin; i < end; ++i)
 		{
-			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+
+			// Update the collision boundary after certain distance has been passed or
+			// if it has become invalid.
+			const float updateThr = ag->params.collisionQueryRange*0.25f;
+			if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
+				!ag->boundary.isValid(navquery, &m_filters[ag->params.queryFilterType]))
+			{
+				ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
+									navquery, &m_filters[ag->params.queryFilterType]);
+			}
+			// Query neighbour agents
+			ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
+									  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
+									  agents, nagents, m_grid);
+			for (int j = 0; j < ag->nneis; j++)
+				ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
 		}
-		// Query neighbour agents
-		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
-								  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
-								  agents, nagents, m_grid);
-		for (int j = 0; j < ag->nneis; j++)
-			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
-	}
-	
-	// Find next corner to steer to.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
+		break;
+
+	case DT_CROWD_PHASE_CORNERS:
+		// Find next corner to steer to.
+		for (int i = begin; i < end; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
 		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+				continue;
 		
-		// Find corners for steering
-		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
+			// Find corners for steering
+			ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
+													DT_CROWDAGENT_MAX_CORNERS, navquery, &m_filters[ag->params.queryFilterType]);
 		
-		// Check to see if the corner after the next corner is directly visible,
-		// and short cut to there.
-		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
-		{
-			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
-			
-			// Copy data for debug purposes.
-			if (debugIdx == i)
+			// Check to see if the corner after the next corner is directly visible,
+			// and short cut to there.
+			if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
 			{
-				dtVcopy(debug->optStart, ag->corridor.getPos());
-				dtVcopy(debug->optEnd, target);
+				const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
+				ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, navquery, &m_filters[ag->params.queryFilterType]);
+			
+				// Copy data for debug purposes.
+				if (debugIdx == i)
+				{
+					dtVcopy(debug->optStart, ag->corridor.getPos());
+					dtVcopy(debug->optEnd, target);
+				}
 			}
-		}
-		else
-		{
-			// Copy data for debug purposes.
-			if (debugIdx == i)
+			else
 			{
-				dtVset(debug->optStart, 0,0,0);
-				dtVset(debug->optEnd, 0,0,0);
+				// Copy data for debug purposes.
+				if (debugIdx == i)
+				{
+					dtVset(debug->optStart, 0,0,0);
+					dtVset(debug->optEnd, 0,0,0);
+				}
 			}
 		}
-	}
-	
-	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
+		break;
+
+	case DT_CROWD_PHASE_OFFMESH:
+		// Trigger off-mesh connections (depends on corners).
+		for (int i = begin; i < end; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
 		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+				continue;
 		
-		// Check 
-		const float triggerRadius = ag->params.radius*2.25f;
-		if (overOffmeshConnection(ag, triggerRadius))
-		{
-			// Prepare to off-mesh connection.
-			const int idx = (int)(ag - m_agents);
-			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
-			
-			// Adjust the path over the off-mesh connection.
-			dtPolyRef refs[2];
-			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
-													   anim->startPos, anim->endPos, m_navquery))
+			// Check 
+			const float triggerRadius = ag->params.radius*2.25f;
+			if (overOffmeshConnection(ag, triggerRadius))
 			{
-				dtVcopy(anim->initPos, ag->npos);
-				anim->polyRef = refs[1];
-				anim->active = true;
-				anim->t = 0.0f;
-				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+				// Prepare to off-mesh connection.
+				const int idx = (int)(ag - m_agents);
+				dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+			
+				// Adjust the path over the off-mesh connection.
+				dtPolyRef refs[2];
+				if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
+														   anim->startPos, anim->endPos, navquery))
+				{
+					dtVcopy(anim->initPos, ag->npos);
+					anim->polyRef = refs[1];
+					anim->active = true;
+					anim->t = 0.0f;
+					anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
 				
-				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
-				ag->ncorners = 0;
-				ag->nneis = 0;
-				continue;
-			}
-			else
-			{
-				// Path validity check will ensure that bad/blocked connections will be replanned.
+					ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+					ag->ncorners = 0;
+					ag->nneis = 0;
+					continue;
+				}
+				else
+				{
+					// Path validity check will ensure that bad/blocked connections will be replanned.
+				}
 			}
 		}
-	}
-		
-	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
+		break;
 
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
-			continue;
+	case DT_CROWD_PHASE_STEERING:
+		// Calculate steering.
+		for (int i = begin; i < end; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
+
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
+				continue;
 		
-		float dvel[3] = {0,0,0};
+			float dvel[3] = {0,0,0};
 
-		if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			dtVcopy(dvel, ag->targetPos);
-			ag->desiredSpeed = dtVlen(ag->targetPos);
-		}
-		else
-		{
-			// Calculate steering direction.
-			if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
-				calcSmoothSteerDirection(ag, dvel);
+			if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			{
+				dtVcopy(dvel, ag->targetPos);
+				ag->desiredSpeed = dtVlen(ag->targetPos);
+			}
 			else
-				calcStraightSteerDirection(ag, dvel);
+			{
+				// Calculate steering direction.
+				if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
+					calcSmoothSteerDirection(ag, dvel);
+				else
+					calcStraightSteerDirection(ag, dvel);
 			
-			// Calculate speed scale, which tells the agent to slowdown at the end of the path.
-			const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
-			const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
+				// Calculate speed scale, which tells the agent to slowdown at the end of the path.
+				const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
+				const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
 				
-			ag->desiredSpeed = ag->params.maxSpeed;
-			dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
-		}
+				ag->desiredSpeed = ag->params.maxSpeed;
+				dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
+			}
 
-		// Separation
-		if (ag->params.updateFlags & DT_CROWD_SEPARATION)
-		{
-			const float separationDist = ag->params.collisionQueryRange; 
-			const float invSeparationDist = 1.0f / separationDist; 
-			const float separationWeight = ag->params.separationWeight;
+			// Separation
+			if (ag->params.updateFlags & DT_CROWD_SEPARATION)
+			{
+				const float separationDist = ag->params.collisionQueryRange; 
+				const float invSeparationDist = 1.0f / separationDist; 
+				const float separationWeight = ag->params.separationWeight;
 			
-			float w = 0;
-			float disp[3] = {0,0,0};
+				float w = 0;
+				float disp[3] = {0,0,0};
 			
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+				for (int j = 0; j < ag->nneis; ++j)
+				{
+					const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
 				
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
+					float diff[3];
+					dtVsub(diff, ag->npos, nei->npos);
+					diff[1] = 0;
 				
-				const float distSqr = dtVlenSqr(diff);
-				if (distSqr < 0.00001f)
-					continue;
-				if (distSqr > dtSqr(separationDist))
-					continue;
-				const float dist = dtMathSqrtf(distSqr);
-				const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
+					const float distSqr = dtVlenSqr(diff);
+					if (distSqr < 0.00001f)
+						continue;
+					if (distSqr > dtSqr(separationDist))
+						continue;
+					const float dist = dtMathSqrtf(distSqr);
+					const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
 				
-				dtVmad(disp, disp, diff, weight/dist);
-				w += 1.0f;
-			}
+					dtVmad(disp, disp, diff, weight/dist);
+					w += 1.0f;
+				}
 			
-			if (w > 0.0001f)
-			{
-				// Adjust desired velocity.
-				dtVmad(dvel, dvel, disp, 1.0f/w);
-				// Clamp desired velocity to desired speed.
-				const float speedSqr = dtVlenSqr(dvel);
-				const float desiredSqr = dtSqr(ag->desiredSpeed);
-				if (speedSqr > desiredSqr)
-					dtVscale(dvel, dvel, desiredSqr/speedSqr);
+				if (w > 0.0001f)
+				{
+					// Adjust desired velocity.
+					dtVmad(dvel, dvel, disp, 1.0f/w);
+					// Clamp desired velocity to desired speed.
+					const float speedSqr = dtVlenSqr(dvel);
+					const float desiredSqr = dtSqr(ag->desiredSpeed);
+					if (speedSqr > desiredSqr)
+						dtVscale(dvel, dvel, desiredSqr/speedSqr);
+				}
 			}
-		}
 		
-		// Set the desired velocity.
-		dtVcopy(ag->dvel, dvel);
-	}
-	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
+			// Set the desired velocity.
+			dtVcopy(ag->dvel, dvel);
+		}
+		break;
+
+	case DT_CROWD_PHASE_VELOCITY_PLANNING:
+		// Velocity planning.	
+		for (int i = begin; i < end; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
 		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
 		
-		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
-		{
-			m_obstacleQuery->reset();
-			
-			// Add neighbours as obstacles.
-			for (int j = 0; j < ag->nneis; ++j)
+			if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
-			}
+				obstacleQuery->reset();
+			
+				// Add neighbours as obstacles.
+				for (int j = 0; j < ag->nneis; ++j)
+				{
+					const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+					obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
+				}
 
-			// Append neighbour segments as obstacles.
-			for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
-			{
-				const float* s = ag->boundary.getSegment(j);
-				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
-					continue;
-				m_obstacleQuery->addSegment(s, s+3);
-			}
+				// Append neighbour segments as obstacles.
+				for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
+				{
+					const float* s = ag->boundary.getSegment(j);
+					if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
+						continue;
+					obstacleQuery->addSegment(s, s+3);
+				}
 
-			dtObstacleAvoidanceDebugData* vod = 0;
-			if (debugIdx == i) 
-				vod = debug->vod;
+				dtObstacleAvoidanceDebugData* vod = 0;
+				if (debugIdx == i) 
+					vod = debug->vod;
 			
-			// Sample new safe velocity.
-			bool adaptive = true;
-			int ns = 0;
+				// Sample new safe velocity.
+				bool adaptive = true;
+				int ns = 0;
 
-			const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
+				const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
 				
-			if (adaptive)
-			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+				if (adaptive)
+				{
+					ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+																 ag->vel, ag->dvel, ag->nvel, params, vod);
+				}
+				else
+				{
+					ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
 															 ag->vel, ag->dvel, ag->nvel, params, vod);
+				}
+				m_threadSampleCounts[thread] += ns;
 			}
 			else
 			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
+				// If not using velocity planning, new velocity is directly the desired velocity.
+				dtVcopy(ag->nvel, ag->dvel);
 			}
-			m_velocitySampleCount += ns;
 		}
-		else
+		break;
+
+	case DT_CROWD_PHASE_INTEGRATE:
+		// Integrate.
+		for (int i = begin; i < end; ++i)
 		{
-			// If not using velocity planning, new velocity is directly the desired velocity.
-			dtVcopy(ag->nvel, ag->dvel);
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+			integrate(ag, dt);
 		}
-	}
+		break;
 
-	// Integrate.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		integrate(ag, dt);
-	}
-	
-	// Handle collisions.
-	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
-	
-	for (int iter = 0; iter < 4; ++iter)
-	{
-		for (int i = 0; i < nagents; ++i)
+	case DT_CROWD_PHASE_COLLISION_DISP:
+		// Handle collisions.
+		static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+		
+		for (int i = begin; i < end; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
 			const int idx0 = getAgentIndex(ag);
-			
+		
 			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 				continue;
 
 			dtVset(ag->disp, 0,0,0);
-			
+		
 			float w = 0;
 
 			for (int j = 0; j < ag->nneis; ++j)
@@ -1346,7 +1454,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				float diff[3];
 				dtVsub(diff, ag->npos, nei->npos);
 				diff[1] = 0;
-				
+			
 				float dist = dtVlenSqr(diff);
 				if (dist > dtSqr(ag->params.radius + nei->params.radius))
 					continue;
@@ -1365,49 +1473,158 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				{
 					pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
 				}
-				
-				dtVmad(ag->disp, ag->disp, diff, pen);			
-				
+			
+				dtVmad(ag->disp, ag->disp, diff, pen);
+			
 				w += 1.0f;
 			}
-			
+		
 			if (w > 0.0001f)
 			{
 				const float iw = 1.0f / w;
 				dtVscale(ag->disp, ag->disp, iw);
 			}
 		}
-		
-		for (int i = 0; i < nagents; ++i)
+		break;
+
+	case DT_CROWD_PHASE_COLLISION_APPLY:
+		for (int i = begin; i < end; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
 			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 				continue;
-			
+		
 			dtVadd(ag->npos, ag->npos, ag->disp);
 		}
+		break;
+
+	case DT_CROWD_PHASE_MOVE:
+		for (int i = begin; i < end; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
+		
+			// Move along navmesh.
+			ag->corridor.movePosition(ag->npos, navquery, &m_filters[ag->params.queryFilterType]);
+			// Get valid constrained position back.
+			dtVcopy(ag->npos, ag->corridor.getPos());
+
+			// If not using path, truncate the corridor to just one poly.
+			if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+			{
+				ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
+				ag->partial = false;
+			}
+
+		}
+		break;
+
+	default:
+		dtAssert(false);
+		break;
+	}
+}
+
+void dtCrowd::runPhaseJob(void* ctx, const int begin, const int end, const int thread)
+{
+	const dtCrowdPhaseContext* pc = (const dtCrowdPhaseContext*)ctx;
+	pc->crowd->updatePhase(pc->phase, pc->agents, pc->nagents, begin, end, thread, pc->dt, pc->debug);
+}
+
+void dtCrowd::runPhase(dtCrowdJobSystem* jobs, const int phase, dtCrowdAgent** agents, const int nagents,
+					   const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	if (!jobs)
+	{
+		updatePhase(phase, agents, nagents, 0, nagents, 0, dt, debug);
+		return;
 	}
 	
+	dtCrowdPhaseContext ctx;
+	ctx.crowd = this;
+	ctx.phase = phase;
+	ctx.agents = agents;
+	ctx.nagents = nagents;
+	ctx.dt = dt;
+	ctx.debug = debug;
+	jobs->run(runPhaseJob, &ctx, nagents);
+}
+
+void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	update(dt, debug, 0);
+}
+
+/// @par
+///
+/// The per-agent phases of the update are run through @p jobs.  Path requests, the proximity grid
+/// and off-mesh animations are updated on the calling thread.  The result is the same as a serial
+/// update.
+///
+/// The update is serial if @p jobs is null or uses more threads than set by #initThreads().
+void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug, dtCrowdJobSystem* jobs)
+{
+	m_velocitySampleCount = 0;
+	
+	if (jobs && jobs->getThreadCount() > m_maxThreads)
+		jobs = 0;
+	for (int i = 0; i < m_maxThreads; ++i)
+		m_threadSampleCounts[i] = 0;
+	
+	dtCrowdAgent** agents = m_activeAgents;
+	int nagents = getActiveAgents(agents, m_maxAgents);
+	m_nactiveAgents = nagents;
+
+	// Check that all agents still have valid paths.
+	checkPathValidity(agents, nagents, dt);
+	
+	// Update async move request and path finder.
+	updateMoveRequest(dt);
+
+	// Optimize path topology.
+	updateTopologyOptimization(agents, nagents, dt);
+	
+	// Register agents to proximity grid.
+	m_grid->clear();
 	for (int i = 0; i < nagents; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		
-		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
-		// Get valid constrained position back.
-		dtVcopy(ag->npos, ag->corridor.getPos());
-
-		// If not using path, truncate the corridor to just one poly.
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
-			ag->partial = false;
-		}
-
+		const float* p = ag->npos;
+		const float r = ag->params.radius;
+		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
 	}
 	
+	// Get nearby navmesh segments and agents to collide with.
+	runPhase(jobs, DT_CROWD_PHASE_NEIGHBOURS, agents, nagents, dt, debug);
+	
+	// Find next corner to steer to.
+	runPhase(jobs, DT_CROWD_PHASE_CORNERS, agents, nagents, dt, debug);
+	
+	// Trigger off-mesh connections (depends on corners).
+	runPhase(jobs, DT_CROWD_PHASE_OFFMESH, agents, nagents, dt, debug);
+	
+	// Calculate steering.
+	runPhase(jobs, DT_CROWD_PHASE_STEERING, agents, nagents, dt, debug);
+	
+	// Velocity planning.
+	runPhase(jobs, DT_CROWD_PHASE_VELOCITY_PLANNING, agents, nagents, dt, debug);
+	for (int i = 0; i < m_maxThreads; ++i)
+		m_velocitySampleCount += m_threadSampleCounts[i];
+	
+	// Integrate.
+	runPhase(jobs, DT_CROWD_PHASE_INTEGRATE, agents, nagents, dt, debug);
+	
+	// Handle collisions.
+	for (int iter = 0; iter < 4; ++iter)
+	{
+		runPhase(jobs, DT_CROWD_PHASE_COLLISION_DISP, agents, nagents, dt, debug);
+		runPhase(jobs, DT_CROWD_PHASE_COLLISION_APPLY, agents, nagents, dt, debug);
+	}
+	
+	// Move along navmesh.
+	runPhase(jobs, DT_CROWD_PHASE_MOVE, agents, nagents, dt, debug);
+	
 	// Update agents using off-mesh connection.
 	for (int i = 0; i < m_maxAgents; ++i)
 	{
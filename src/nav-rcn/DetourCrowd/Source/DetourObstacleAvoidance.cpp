@@ -25,6 +25,14 @@
 #include <float.h>
 #include <new>
 
+// Candidate velocities are scored four at a time when SSE2 is available.
+// Define DT_OBSTACLE_AVOIDANCE_NO_SIMD to force the scalar path.
+#if !defined(DT_OBSTACLE_AVOIDANCE_NO_SIMD) \
+	&& (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define DT_OBSTACLE_AVOIDANCE_SSE2 1
+#endif
+
 static const float DT_PI = 3.14159265f;
 
 static int sweepCircleCircle(const float* c0, const float r0, const float* v,
@@ -432,6 +440,218 @@ float dtObstacleAvoidanceQuery::processSample(const float* vcand, const float cs
 	return penalty;
 }
 
+#ifdef DT_OBSTACLE_AVOIDANCE_SSE2
+
+inline __m128 dtSimdAbs(const __m128 v)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+inline __m128 dtSimdSelect(const __m128 mask, const __m128 a, const __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Four wide version of processSample().  Evaluates the same expressions in
+// the same order, so the penalties match the scalar path.  The early out only
+// uses the minimum penalty at the start of the batch, candidates that fail it
+// get FLT_MAX.  The caller repeats the exact test against the running minimum
+// using the returned desired/current velocity penalties and time of impact.
+static void processSample4(const __m128 vx, const __m128 vz,
+						   const dtObstacleAvoidanceParams& params,
+						   const float invHorizTime, const float invVmax,
+						   const dtObstacleCircle* circles, const int ncircles,
+						   const dtObstacleSegment* segments, const int nsegments,
+						   const float* pos, const float rad,
+						   const float* vel, const float* dvel,
+						   const float minPenalty, float* penalties,
+						   float* vpens, float* vcpens, float* tmins)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 invVmax4 = _mm_set1_ps(invVmax);
+
+	// Penalty for straying away from the desired and current velocities.
+	__m128 dx = _mm_sub_ps(_mm_set1_ps(dvel[0]), vx);
+	__m128 dz = _mm_sub_ps(_mm_set1_ps(dvel[2]), vz);
+	const __m128 vpen = _mm_mul_ps(_mm_set1_ps(params.weightDesVel),
+		_mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz))), invVmax4));
+	dx = _mm_sub_ps(_mm_set1_ps(vel[0]), vx);
+	dz = _mm_sub_ps(_mm_set1_ps(vel[2]), vz);
+	const __m128 vcpen = _mm_mul_ps(_mm_set1_ps(params.weightCurVel),
+		_mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz))), invVmax4));
+
+	// Early out threshold, see processSample().
+	const __m128 horizTime = _mm_set1_ps(params.horizTime);
+	const __m128 minPen = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(minPenalty), vpen), vcpen);
+	const __m128 tThresold = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(_mm_set1_ps(params.weightToi), minPen),
+		_mm_set1_ps(0.1f)), horizTime);
+	__m128 rejected = _mm_cmpgt_ps(_mm_sub_ps(tThresold, horizTime), _mm_set1_ps(-FLT_EPSILON));
+
+	__m128 tmin = horizTime;
+	__m128 side = zero;
+
+	const __m128 vx2 = _mm_mul_ps(vx, two);
+	const __m128 vz2 = _mm_mul_ps(vz, two);
+
+	for (int i = 0; i < ncircles && _mm_movemask_ps(rejected) != 0xf; ++i)
+	{
+		const dtObstacleCircle* cir = &circles[i];
+
+		// RVO
+		const __m128 vabx = _mm_sub_ps(_mm_sub_ps(vx2, _mm_set1_ps(vel[0])), _mm_set1_ps(cir->vel[0]));
+		const __m128 vabz = _mm_sub_ps(_mm_sub_ps(vz2, _mm_set1_ps(vel[2])), _mm_set1_ps(cir->vel[2]));
+
+		// Side
+		const __m128 sdp = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(cir->dp[0]), vabx),
+			_mm_mul_ps(_mm_set1_ps(cir->dp[2]), vabz)), half), half);
+		const __m128 snp = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(cir->np[0]), vabx),
+			_mm_mul_ps(_mm_set1_ps(cir->np[2]), vabz)), two);
+		side = _mm_add_ps(side, _mm_min_ps(_mm_max_ps(_mm_min_ps(sdp, snp), zero), one));
+
+		// Sweep, see sweepCircleCircle().
+		const float sx = cir->p[0] - pos[0];
+		const float sz = cir->p[2] - pos[2];
+		const float r = rad + cir->rad;
+		const __m128 c = _mm_set1_ps((sx*sx + sz*sz) - r*r);
+		const __m128 a = _mm_add_ps(_mm_mul_ps(vabx, vabx), _mm_mul_ps(vabz, vabz));
+		const __m128 b = _mm_add_ps(_mm_mul_ps(vabx, _mm_set1_ps(sx)), _mm_mul_ps(vabz, _mm_set1_ps(sz)));
+		const __m128 d = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+		const __m128 hit = _mm_and_ps(_mm_cmpge_ps(a, _mm_set1_ps(0.0001f)), _mm_cmpge_ps(d, zero));
+		if (!_mm_movemask_ps(hit))
+			continue;
+
+		const __m128 inva = _mm_div_ps(one, dtSimdSelect(hit, a, one));
+		const __m128 rd = _mm_sqrt_ps(_mm_max_ps(d, zero));
+		__m128 htmin = _mm_mul_ps(_mm_sub_ps(b, rd), inva);
+		const __m128 htmax = _mm_mul_ps(_mm_add_ps(b, rd), inva);
+
+		// Handle overlapping obstacles, avoid more when overlapped.
+		const __m128 overlap = _mm_and_ps(_mm_cmplt_ps(htmin, zero), _mm_cmpgt_ps(htmax, zero));
+		htmin = dtSimdSelect(overlap, _mm_mul_ps(_mm_sub_ps(zero, htmin), half), htmin);
+
+		const __m128 closer = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(htmin, zero), _mm_cmplt_ps(htmin, tmin)));
+		tmin = dtSimdSelect(closer, htmin, tmin);
+		rejected = _mm_or_ps(rejected, _mm_and_ps(closer, _mm_cmplt_ps(tmin, tThresold)));
+	}
+
+	for (int i = 0; i < nsegments && _mm_movemask_ps(rejected) != 0xf; ++i)
+	{
+		const dtObstacleSegment* seg = &segments[i];
+		const float sdx = seg->q[0] - seg->p[0];
+		const float sdz = seg->q[2] - seg->p[2];
+
+		__m128 hit, htmin;
+		if (seg->touch)
+		{
+			// Immediate collision unless the velocity points towards the segment.
+			const __m128 dn = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-sdz), vx), _mm_mul_ps(_mm_set1_ps(sdx), vz));
+			hit = _mm_cmpge_ps(dn, zero);
+			htmin = zero;
+		}
+		else
+		{
+			// See isectRaySeg().
+			const float wx = pos[0] - seg->p[0];
+			const float wz = pos[2] - seg->p[2];
+			__m128 d = _mm_sub_ps(_mm_mul_ps(vz, _mm_set1_ps(sdx)), _mm_mul_ps(vx, _mm_set1_ps(sdz)));
+			hit = _mm_cmpge_ps(dtSimdAbs(d), _mm_set1_ps(1e-6f));
+			d = _mm_div_ps(one, dtSimdSelect(hit, d, one));
+			const __m128 t = _mm_mul_ps(_mm_set1_ps(sdz*wx - sdx*wz), d);
+			const __m128 s = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(vz, _mm_set1_ps(wx)), _mm_mul_ps(vx, _mm_set1_ps(wz))), d);
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, one)));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(s, zero), _mm_cmple_ps(s, one)));
+			htmin = t;
+		}
+
+		// Avoid less when facing walls.
+		htmin = _mm_mul_ps(htmin, two);
+
+		const __m128 closer = _mm_and_ps(hit, _mm_cmplt_ps(htmin, tmin));
+		tmin = dtSimdSelect(closer, htmin, tmin);
+		rejected = _mm_or_ps(rejected, _mm_and_ps(closer, _mm_cmplt_ps(tmin, tThresold)));
+	}
+
+	// Normalize side bias, to prevent it dominating too much.
+	if (ncircles)
+		side = _mm_div_ps(side, _mm_set1_ps((float)ncircles));
+
+	const __m128 spen = _mm_mul_ps(_mm_set1_ps(params.weightSide), side);
+	const __m128 tpen = _mm_mul_ps(_mm_set1_ps(params.weightToi),
+		_mm_div_ps(one, _mm_add_ps(_mm_set1_ps(0.1f), _mm_mul_ps(tmin, _mm_set1_ps(invHorizTime)))));
+
+	const __m128 penalty = _mm_add_ps(_mm_add_ps(_mm_add_ps(vpen, vcpen), spen), tpen);
+	_mm_storeu_ps(penalties, dtSimdSelect(rejected, _mm_set1_ps(FLT_MAX), penalty));
+	_mm_storeu_ps(vpens, vpen);
+	_mm_storeu_ps(vcpens, vcpen);
+	_mm_storeu_ps(tmins, tmin);
+}
+
+#endif // DT_OBSTACLE_AVOIDANCE_SSE2
+
+/* Score up to four candidate velocities and keep the best one
+ *
+ * Candidates are considered in order, so the selected velocity is the same
+ * as calling processSample() on each of them in turn.
+ */
+void dtObstacleAvoidanceQuery::processSamples(const float* vx, const float* vz, const int n, const float cs,
+											  const float* pos, const float rad,
+											  const float* vel, const float* dvel,
+											  float& minPenalty, float* bestVel,
+											  dtObstacleAvoidanceDebugData* debug)
+{
+	dtAssert(n > 0 && n <= 4);
+
+#ifdef DT_OBSTACLE_AVOIDANCE_SSE2
+	// The debug data wants every sample that passes the early out, so it
+	// keeps using the scalar path.
+	if (!debug)
+	{
+		float x[4], z[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			x[i] = vx[i < n ? i : 0];
+			z[i] = vz[i < n ? i : 0];
+		}
+
+		float penalties[4], vpens[4], vcpens[4], tmins[4];
+		processSample4(_mm_loadu_ps(x), _mm_loadu_ps(z), m_params, m_invHorizTime, m_invVmax,
+					   m_circles, m_ncircles, m_segments, m_nsegments,
+					   pos, rad, vel, dvel, minPenalty, penalties, vpens, vcpens, tmins);
+
+		for (int i = 0; i < n; ++i)
+		{
+			// Same early out as processSample(), so the same candidates are rejected.
+			const float minPen = minPenalty - vpens[i] - vcpens[i];
+			const float tThresold = (m_params.weightToi / minPen - 0.1f) * m_params.horizTime;
+			if (tThresold - m_params.horizTime > -FLT_EPSILON || tmins[i] < tThresold)
+				continue;
+
+			if (penalties[i] < minPenalty)
+			{
+				minPenalty = penalties[i];
+				dtVset(bestVel, vx[i], 0, vz[i]);
+			}
+		}
+		return;
+	}
+#endif
+
+	for (int i = 0; i < n; ++i)
+	{
+		float vcand[3];
+		dtVset(vcand, vx[i], 0, vz[i]);
+		const float penalty = processSample(vcand, cs, pos,rad,vel,dvel, minPenalty, debug);
+		if (penalty < minPenalty)
+		{
+			minPenalty = penalty;
+			dtVcopy(bestVel, vcand);
+		}
+	}
+}
+
 int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float rad, const float vmax,
 												 const float* vel, const float* dvel, float* nvel,
 												 const dtObstacleAvoidanceParams* params,
@@ -456,27 +676,31 @@ int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float r
 		
 	float minPenalty = FLT_MAX;
 	int ns = 0;
+
+	float bx[4], bz[4];
+	int nb = 0;
 		
 	for (int y = 0; y < m_params.gridSize; ++y)
 	{
 		for (int x = 0; x < m_params.gridSize; ++x)
 		{
-			float vcand[3];
-			vcand[0] = cvx + x*cs - half;
-			vcand[1] = 0;
-			vcand[2] = cvz + y*cs - half;
+			const float vx = cvx + x*cs - half;
+			const float vz = cvz + y*cs - half;
 			
-			if (dtSqr(vcand[0])+dtSqr(vcand[2]) > dtSqr(vmax+cs/2)) continue;
+			if (dtSqr(vx)+dtSqr(vz) > dtSqr(vmax+cs/2)) continue;
 			
-			const float penalty = processSample(vcand, cs, pos,rad,vel,dvel, minPenalty, debug);
+			bx[nb] = vx;
+			bz[nb] = vz;
 			ns++;
-			if (penalty < minPenalty)
+			if (++nb == 4)
 			{
-				minPenalty = penalty;
-				dtVcopy(nvel, vcand);
+				processSamples(bx, bz, nb, cs, pos,rad,vel,dvel, minPenalty, nvel, debug);
+				nb = 0;
 			}
 		}
 	}
+	if (nb)
+		processSamples(bx, bz, nb, cs, pos,rad,vel,dvel, minPenalty, nvel, debug);
 	
 	return ns;
 }
@@ -589,24 +813,28 @@ int dtObstacleAvoidanceQuery::sampleVelocityAdaptive(const float* pos, const flo
 		float minPenalty = FLT_MAX;
 		float bvel[3];
 		dtVset(bvel, 0,0,0);
+
+		float bx[4], bz[4];
+		int nb = 0;
 		
 		for (int i = 0; i < npat; ++i)
 		{
-			float vcand[3];
-			vcand[0] = res[0] + pat[i*2+0]*cr;
-			vcand[1] = 0;
-			vcand[2] = res[2] + pat[i*2+1]*cr;
+			const float vx = res[0] + pat[i*2+0]*cr;
+			const float vz = res[2] + pat[i*2+1]*cr;
 			
-			if (dtSqr(vcand[0])+dtSqr(vcand[2]) > dtSqr(vmax+0.001f)) continue;
+			if (dtSqr(vx)+dtSqr(vz) > dtSqr(vmax+0.001f)) continue;
 			
-			const float penalty = processSample(vcand,cr/10, pos,rad,vel,dvel, minPenalty, debug);
+			bx[nb] = vx;
+			bz[nb] = vz;
 			ns++;
-			if (penalty < minPenalty)
+			if (++nb == 4)
 			{
-				minPenalty = penalty;
-				dtVcopy(bvel, vcand);
+				processSamples(bx, bz, nb, cr/10, pos,rad,vel,dvel, minPenalty, bvel, debug);
+				nb = 0;
 			}
 		}
+		if (nb)
+			processSamples(bx, bz, nb, cr/10, pos,rad,vel,dvel, minPenalty, bvel, debug);
 
 		dtVcopy(res, bvel);
 
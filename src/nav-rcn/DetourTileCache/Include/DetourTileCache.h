@@ -232,11 +232,58 @@ public:
 	///  							If the tile cache is up to date another (immediate) call to update will have no effect;
 	///  							otherwise another call will continue processing obstacle requests and tile rebuilds.
 	dtStatus update(const float dt, class dtNavMesh* navmesh, bool* upToDate = 0);
+
+	/// The number of tiles queued for rebuild by processed obstacle requests.
+	inline int getPendingTileCount() const { return m_nupdate; }
+
+	/// The number of obstacle requests waiting to be processed by #update.
+	inline int getPendingRequestCount() const { return m_nreqs; }
 	
 	dtStatus buildNavMeshTilesAt(const int tx, const int ty, class dtNavMesh* navmesh);
 	
 	dtStatus buildNavMeshTile(const dtCompressedTileRef ref, class dtNavMesh* navmesh);
 	
+	/// @name Deferred Tile Rebuilds
+	/// The steps of #update, split so the expensive #buildNavMeshTileData can run on another thread.
+	/// Everything except #buildNavMeshTileData must be called from the thread that owns the cache.
+	/// @{
+	
+	/// Processes the queued obstacle requests.  Tiles already on the rebuild queue stay there.
+	/// Must not be called while a tile taken with #popTileUpdate is still being rebuilt.
+	void processObstacleRequests();
+	
+	/// Takes the next tile off the rebuild queue.
+	///  @param[out]	ref		The tile to rebuild.
+	/// @return False if the queue is empty.
+	bool popTileUpdate(dtCompressedTileRef* ref);
+	
+	/// Copies the obstacles that must be rasterized into a tile.
+	/// @return The number of obstacles copied.
+	int getTileObstacles(const dtCompressedTileRef ref, dtTileCacheObstacle* obstacles, const int maxObstacles) const;
+	
+	/// Builds navigation mesh tile data without touching the cache's obstacles, allocator or a navigation mesh.
+	/// Safe to call from any thread as long as the compressed tile is not removed, and the compressor
+	/// and mesh process are thread safe.
+	///  @param[in]		ref				The tile to build.
+	///  @param[in]		talloc			The allocator for intermediate data.
+	///  @param[in]		obstacles		The obstacles to rasterize.  (From #getTileObstacles.)
+	///  @param[in]		nobstacles		The number of obstacles.
+	///  @param[out]	navData			The tile data, or null if the tile is empty.  Allocated with #dtAlloc.
+	///  @param[out]	navDataSize		The size of the tile data.
+	dtStatus buildNavMeshTileData(const dtCompressedTileRef ref, struct dtTileCacheAlloc* talloc,
+								  const dtTileCacheObstacle* obstacles, const int nobstacles,
+								  unsigned char** navData, int* navDataSize) const;
+	
+	/// Replaces the navigation mesh tile at the tile's location.  The navigation mesh takes
+	/// ownership of @p navData.  A null @p navData just removes the existing tile.
+	dtStatus commitNavMeshTile(const dtCompressedTileRef ref, unsigned char* navData, const int navDataSize,
+							   class dtNavMesh* navmesh);
+	
+	/// Updates the obstacle states once a tile from #popTileUpdate has been committed.
+	void finishTileUpdate(const dtCompressedTileRef ref);
+	
+	/// @}
+	
 	void calcTightTileBounds(const struct dtTileCacheLayerHeader* header, float* bmin, float* bmax) const;
 	
 	void getObstacleBounds(const struct dtTileCacheObstacle* ob, float* bmin, float* bmax) const;
@@ -319,12 +366,14 @@ private:
 	dtTileCacheObstacle* m_obstacles;
 	dtTileCacheObstacle* m_nextFreeObstacle;
 	
-	static const int MAX_REQUESTS = 64;
-	ObstacleRequest m_reqs[MAX_REQUESTS];
+	// Sized so every obstacle can have an add and a remove request queued.
+	ObstacleRequest* m_reqs;
+	int m_maxReqs;
 	int m_nreqs;
 	
-	static const int MAX_UPDATE = 64;
-	dtCompressedTileRef m_update[MAX_UPDATE];
+	// Sized so every tile can be queued for rebuild at once.
+	dtCompressedTileRef* m_update;
+	int m_maxUpdate;
 	int m_nupdate;
 };
 
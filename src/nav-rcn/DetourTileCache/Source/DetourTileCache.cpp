@@ -74,11 +74,14 @@ dtTileCache::dtTileCache() :
 	m_tmproc(0),
 	m_obstacles(0),
 	m_nextFreeObstacle(0),
+	m_reqs(0),
+	m_maxReqs(0),
 	m_nreqs(0),
+	m_update(0),
+	m_maxUpdate(0),
 	m_nupdate(0)
 {
 	memset(&m_params, 0, sizeof(m_params));
-	memset(m_reqs, 0, sizeof(ObstacleRequest) * MAX_REQUESTS);
 }
 	
 dtTileCache::~dtTileCache()
@@ -97,7 +100,11 @@ dtTileCache::~dtTileCache()
 	m_posLookup = 0;
 	dtFree(m_tiles);
 	m_tiles = 0;
+	dtFree(m_reqs);
+	m_reqs = 0;
 	m_nreqs = 0;
+	dtFree(m_update);
+	m_update = 0;
 	m_nupdate = 0;
 }
 
@@ -127,6 +134,10 @@ dtStatus dtTileCache::init(const dtTileCacheParams* params,
 	m_nreqs = 0;
 	memcpy(&m_params, params, sizeof(m_params));
 	
+	// Obstacle refs have 16 bits for the index.
+	if (m_params.maxObstacles < 0 || m_params.maxObstacles > 0xffff)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
 	// Alloc space for obstacles.
 	m_obstacles = (dtTileCacheObstacle*)dtAlloc(sizeof(dtTileCacheObstacle)*m_params.maxObstacles, DT_ALLOC_PERM);
 	if (!m_obstacles)
@@ -140,6 +151,19 @@ dtStatus dtTileCache::init(const dtTileCacheParams* params,
 		m_nextFreeObstacle = &m_obstacles[i];
 	}
 	
+	// Alloc space for the request and update queues.
+	m_maxReqs = dtMax(1, m_params.maxObstacles*2);
+	m_reqs = (ObstacleRequest*)dtAlloc(sizeof(ObstacleRequest)*m_maxReqs, DT_ALLOC_PERM);
+	if (!m_reqs)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(m_reqs, 0, sizeof(ObstacleRequest)*m_maxReqs);
+	
+	m_maxUpdate = dtMax(1, m_params.maxTiles);
+	m_update = (dtCompressedTileRef*)dtAlloc(sizeof(dtCompressedTileRef)*m_maxUpdate, DT_ALLOC_PERM);
+	if (!m_update)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	m_nupdate = 0;
+	
 	// Init tiles
 	m_tileLutSize = dtNextPow2(m_params.maxTiles/4);
 	if (!m_tileLutSize) m_tileLutSize = 1;
@@ -354,7 +378,7 @@ dtStatus dtTileCache::removeTile(dtCompressedTileRef ref, unsigned char** data,
 
 dtStatus dtTileCache::addObstacle(const float* pos, const float radius, const float height, dtObstacleRef* result)
 {
-	if (m_nreqs >= MAX_REQUESTS)
+	if (m_nreqs >= m_maxReqs)
 		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
 	
 	dtTileCacheObstacle* ob = 0;
@@ -389,7 +413,7 @@ dtStatus dtTileCache::addObstacle(const float* pos, const float radius, const fl
 
 dtStatus dtTileCache::addBoxObstacle(const float* bmin, const float* bmax, dtObstacleRef* result)
 {
-	if (m_nreqs >= MAX_REQUESTS)
+	if (m_nreqs >= m_maxReqs)
 		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
 	
 	dtTileCacheObstacle* ob = 0;
@@ -423,7 +447,7 @@ dtStatus dtTileCache::addBoxObstacle(const float* bmin, const float* bmax, dtObs
 
 dtStatus dtTileCache::addBoxObstacle(const float* center, const float* halfExtents, const float yRadians, dtObstacleRef* result)
 {
-	if (m_nreqs >= MAX_REQUESTS)
+	if (m_nreqs >= m_maxReqs)
 		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
 
 	dtTileCacheObstacle* ob = 0;
@@ -464,7 +488,7 @@ dtStatus dtTileCache::removeObstacle(const dtObstacleRef ref)
 {
 	if (!ref)
 		return DT_SUCCESS;
-	if (m_nreqs >= MAX_REQUESTS)
+	if (m_nreqs >= m_maxReqs)
 		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
 	
 	ObstacleRequest* req = &m_reqs[m_nreqs++];
@@ -520,119 +544,150 @@ dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh,
 							 bool* upToDate)
 {
 	if (m_nupdate == 0)
+		processObstacleRequests();
+	
+	dtStatus status = DT_SUCCESS;
+	// Process updates
+	dtCompressedTileRef ref;
+	if (popTileUpdate(&ref))
 	{
-		// Process requests.
-		for (int i = 0; i < m_nreqs; ++i)
+		// Build mesh
+		status = buildNavMeshTile(ref, navmesh);
+		finishTileUpdate(ref);
+	}
+	
+	if (upToDate)
+		*upToDate = m_nupdate == 0 && m_nreqs == 0;
+
+	return status;
+}
+
+void dtTileCache::processObstacleRequests()
+{
+	// Process requests.
+	for (int i = 0; i < m_nreqs; ++i)
+	{
+		ObstacleRequest* req = &m_reqs[i];
+		
+		unsigned int idx = decodeObstacleIdObstacle(req->ref);
+		if ((int)idx >= m_params.maxObstacles)
+			continue;
+		dtTileCacheObstacle* ob = &m_obstacles[idx];
+		unsigned int salt = decodeObstacleIdSalt(req->ref);
+		if (ob->salt != salt)
+			continue;
+		
+		if (req->action == REQUEST_ADD)
 		{
-			ObstacleRequest* req = &m_reqs[i];
-			
-			unsigned int idx = decodeObstacleIdObstacle(req->ref);
-			if ((int)idx >= m_params.maxObstacles)
-				continue;
-			dtTileCacheObstacle* ob = &m_obstacles[idx];
-			unsigned int salt = decodeObstacleIdSalt(req->ref);
-			if (ob->salt != salt)
-				continue;
-			
-			if (req->action == REQUEST_ADD)
+			// Find touched tiles.
+			float bmin[3], bmax[3];
+			getObstacleBounds(ob, bmin, bmax);
+
+			int ntouched = 0;
+			queryTiles(bmin, bmax, ob->touched, &ntouched, DT_MAX_TOUCHED_TILES);
+			ob->ntouched = (unsigned char)ntouched;
+			// Add tiles to update list.
+			ob->npending = 0;
+			for (int j = 0; j < ob->ntouched; ++j)
 			{
-				// Find touched tiles.
-				float bmin[3], bmax[3];
-				getObstacleBounds(ob, bmin, bmax);
-
-				int ntouched = 0;
-				queryTiles(bmin, bmax, ob->touched, &ntouched, DT_MAX_TOUCHED_TILES);
-				ob->ntouched = (unsigned char)ntouched;
-				// Add tiles to update list.
-				ob->npending = 0;
-				for (int j = 0; j < ob->ntouched; ++j)
+				if (m_nupdate < m_maxUpdate)
 				{
-					if (m_nupdate < MAX_UPDATE)
-					{
-						if (!contains(m_update, m_nupdate, ob->touched[j]))
-							m_update[m_nupdate++] = ob->touched[j];
-						ob->pending[ob->npending++] = ob->touched[j];
-					}
+					if (!contains(m_update, m_nupdate, ob->touched[j]))
+						m_update[m_nupdate++] = ob->touched[j];
+					ob->pending[ob->npending++] = ob->touched[j];
 				}
 			}
-			else if (req->action == REQUEST_REMOVE)
+		}
+		else if (req->action == REQUEST_REMOVE)
+		{
+			// Prepare to remove obstacle.
+			ob->state = DT_OBSTACLE_REMOVING;
+			// Add tiles to update list.
+			ob->npending = 0;
+			for (int j = 0; j < ob->ntouched; ++j)
 			{
-				// Prepare to remove obstacle.
-				ob->state = DT_OBSTACLE_REMOVING;
-				// Add tiles to update list.
-				ob->npending = 0;
-				for (int j = 0; j < ob->ntouched; ++j)
+				if (m_nupdate < m_maxUpdate)
 				{
-					if (m_nupdate < MAX_UPDATE)
-					{
-						if (!contains(m_update, m_nupdate, ob->touched[j]))
-							m_update[m_nupdate++] = ob->touched[j];
-						ob->pending[ob->npending++] = ob->touched[j];
-					}
+					if (!contains(m_update, m_nupdate, ob->touched[j]))
+						m_update[m_nupdate++] = ob->touched[j];
+					ob->pending[ob->npending++] = ob->touched[j];
 				}
 			}
 		}
-		
-		m_nreqs = 0;
 	}
 	
-	dtStatus status = DT_SUCCESS;
-	// Process updates
-	if (m_nupdate)
-	{
-		// Build mesh
-		const dtCompressedTileRef ref = m_update[0];
-		status = buildNavMeshTile(ref, navmesh);
-		m_nupdate--;
-		if (m_nupdate > 0)
-			memmove(m_update, m_update+1, m_nupdate*sizeof(dtCompressedTileRef));
+	m_nreqs = 0;
+}
 
-		// Update obstacle states.
-		for (int i = 0; i < m_params.maxObstacles; ++i)
+bool dtTileCache::popTileUpdate(dtCompressedTileRef* ref)
+{
+	if (!m_nupdate)
+		return false;
+	
+	*ref = m_update[0];
+	m_nupdate--;
+	if (m_nupdate > 0)
+		memmove(m_update, m_update+1, m_nupdate*sizeof(dtCompressedTileRef));
+	
+	return true;
+}
+
+void dtTileCache::finishTileUpdate(const dtCompressedTileRef ref)
+{
+	// Update obstacle states.
+	for (int i = 0; i < m_params.maxObstacles; ++i)
+	{
+		dtTileCacheObstacle* ob = &m_obstacles[i];
+		if (ob->state == DT_OBSTACLE_PROCESSING || ob->state == DT_OBSTACLE_REMOVING)
 		{
-			dtTileCacheObstacle* ob = &m_obstacles[i];
-			if (ob->state == DT_OBSTACLE_PROCESSING || ob->state == DT_OBSTACLE_REMOVING)
+			// Remove handled tile from pending list.
+			for (int j = 0; j < (int)ob->npending; j++)
 			{
-				// Remove handled tile from pending list.
-				for (int j = 0; j < (int)ob->npending; j++)
+				if (ob->pending[j] == ref)
 				{
-					if (ob->pending[j] == ref)
-					{
-						ob->pending[j] = ob->pending[(int)ob->npending-1];
-						ob->npending--;
-						break;
-					}
+					ob->pending[j] = ob->pending[(int)ob->npending-1];
+					ob->npending--;
+					break;
 				}
-				
-				// If all pending tiles processed, change state.
-				if (ob->npending == 0)
+			}
+			
+			// If all pending tiles processed, change state.
+			if (ob->npending == 0)
+			{
+				if (ob->state == DT_OBSTACLE_PROCESSING)
 				{
-					if (ob->state == DT_OBSTACLE_PROCESSING)
-					{
-						ob->state = DT_OBSTACLE_PROCESSED;
-					}
-					else if (ob->state == DT_OBSTACLE_REMOVING)
-					{
-						ob->state = DT_OBSTACLE_EMPTY;
-						// Update salt, salt should never be zero.
-						ob->salt = (ob->salt+1) & ((1<<16)-1);
-						if (ob->salt == 0)
-							ob->salt++;
-						// Return obstacle to free list.
-						ob->next = m_nextFreeObstacle;
-						m_nextFreeObstacle = ob;
-					}
+					ob->state = DT_OBSTACLE_PROCESSED;
+				}
+				else if (ob->state == DT_OBSTACLE_REMOVING)
+				{
+					ob->state = DT_OBSTACLE_EMPTY;
+					// Update salt, salt should never be zero.
+					ob->salt = (ob->salt+1) & ((1<<16)-1);
+					if (ob->salt == 0)
+						ob->salt++;
+					// Return obstacle to free list.
+					ob->next = m_nextFreeObstacle;
+					m_nextFreeObstacle = ob;
 				}
 			}
 		}
 	}
-	
-	if (upToDate)
-		*upToDate = m_nupdate == 0 && m_nreqs == 0;
-
-	return status;
 }
 
+int dtTileCache::getTileObstacles(const dtCompressedTileRef ref, dtTileCacheObstacle* obstacles,
+								  const int maxObstacles) const
+{
+	int n = 0;
+	for (int i = 0; i < m_params.maxObstacles && n < maxObstacles; ++i)
+	{
+		const dtTileCacheObstacle* ob = &m_obstacles[i];
+		if (ob->state == DT_OBSTACLE_EMPTY || ob->state == DT_OBSTACLE_REMOVING)
+			continue;
+		if (contains(ob->touched, ob->ntouched, ref))
+			obstacles[n++] = *ob;
+	}
+	return n;
+}
 
 dtStatus dtTileCache::buildNavMeshTilesAt(const int tx, const int ty, dtNavMesh* navmesh)
 {
@@ -651,8 +706,22 @@ dtStatus dtTileCache::buildNavMeshTilesAt(const int tx, const int ty, dtNavMesh*
 }
 
 dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh* navmesh)
+{
+	unsigned char* navData = 0;
+	int navDataSize = 0;
+	dtStatus status = buildNavMeshTileData(ref, m_talloc, m_obstacles, m_params.maxObstacles,
+										   &navData, &navDataSize);
+	if (dtStatusFailed(status))
+		return status;
+	
+	return commitNavMeshTile(ref, navData, navDataSize, navmesh);
+}
+
+dtStatus dtTileCache::buildNavMeshTileData(const dtCompressedTileRef ref, dtTileCacheAlloc* talloc,
+										   const dtTileCacheObstacle* obstacles, const int nobstacles,
+										   unsigned char** navData, int* navDataSize) const
 {	
-	dtAssert(m_talloc);
+	dtAssert(talloc);
 	dtAssert(m_tcomp);
 	
 	unsigned int idx = decodeTileIdTile(ref);
@@ -663,21 +732,24 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	if (tile->salt != salt)
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
-	m_talloc->reset();
+	*navData = 0;
+	*navDataSize = 0;
 	
-	NavMeshTileBuildContext bc(m_talloc);
+	talloc->reset();
+	
+	NavMeshTileBuildContext bc(talloc);
 	const int walkableClimbVx = (int)(m_params.walkableClimb / m_params.ch);
 	dtStatus status;
 	
 	// Decompress tile layer data. 
-	status = dtDecompressTileCacheLayer(m_talloc, m_tcomp, tile->data, tile->dataSize, &bc.layer);
+	status = dtDecompressTileCacheLayer(talloc, m_tcomp, tile->data, tile->dataSize, &bc.layer);
 	if (dtStatusFailed(status))
 		return status;
 	
 	// Rasterize obstacles.
-	for (int i = 0; i < m_params.maxObstacles; ++i)
+	for (int i = 0; i < nobstacles; ++i)
 	{
-		const dtTileCacheObstacle* ob = &m_obstacles[i];
+		const dtTileCacheObstacle* ob = &obstacles[i];
 		if (ob->state == DT_OBSTACLE_EMPTY || ob->state == DT_OBSTACLE_REMOVING)
 			continue;
 		if (contains(ob->touched, ob->ntouched, ref))
@@ -701,32 +773,28 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	}
 	
 	// Build navmesh
-	status = dtBuildTileCacheRegions(m_talloc, *bc.layer, walkableClimbVx);
+	status = dtBuildTileCacheRegions(talloc, *bc.layer, walkableClimbVx);
 	if (dtStatusFailed(status))
 		return status;
 	
-	bc.lcset = dtAllocTileCacheContourSet(m_talloc);
+	bc.lcset = dtAllocTileCacheContourSet(talloc);
 	if (!bc.lcset)
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
-	status = dtBuildTileCacheContours(m_talloc, *bc.layer, walkableClimbVx,
+	status = dtBuildTileCacheContours(talloc, *bc.layer, walkableClimbVx,
 									  m_params.maxSimplificationError, *bc.lcset);
 	if (dtStatusFailed(status))
 		return status;
 	
-	bc.lmesh = dtAllocTileCachePolyMesh(m_talloc);
+	bc.lmesh = dtAllocTileCachePolyMesh(talloc);
 	if (!bc.lmesh)
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
-	status = dtBuildTileCachePolyMesh(m_talloc, *bc.lcset, *bc.lmesh);
+	status = dtBuildTileCachePolyMesh(talloc, *bc.lcset, *bc.lmesh);
 	if (dtStatusFailed(status))
 		return status;
 	
 	// Early out if the mesh tile is empty.
 	if (!bc.lmesh->npolys)
-	{
-		// Remove existing tile.
-		navmesh->removeTile(navmesh->getTileRefAt(tile->header->tx,tile->header->ty,tile->header->tlayer),0,0);
 		return DT_SUCCESS;
-	}
 	
 	dtNavMeshCreateParams params;
 	memset(&params, 0, sizeof(params));
@@ -754,10 +822,30 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 		m_tmproc->process(&params, bc.lmesh->areas, bc.lmesh->flags);
 	}
 	
-	unsigned char* navData = 0;
-	int navDataSize = 0;
-	if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+	if (!dtCreateNavMeshData(&params, navData, navDataSize))
 		return DT_FAILURE;
+	
+	return DT_SUCCESS;
+}
+
+dtStatus dtTileCache::commitNavMeshTile(const dtCompressedTileRef ref, unsigned char* navData,
+										const int navDataSize, dtNavMesh* navmesh)
+{
+	unsigned int idx = decodeTileIdTile(ref);
+	if (idx > (unsigned int)m_params.maxTiles)
+	{
+		dtFree(navData);
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+	const dtCompressedTile* tile = &m_tiles[idx];
+	unsigned int salt = decodeTileIdSalt(ref);
+	if (tile->salt != salt)
+	{
+		dtFree(navData);
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+	
+	dtStatus status;
 
 	// Remove existing tile.
 	navmesh->removeTile(navmesh->getTileRefAt(tile->header->tx,tile->header->ty,tile->header->tlayer),0,0);
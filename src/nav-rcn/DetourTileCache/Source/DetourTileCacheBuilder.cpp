@@ -2138,10 +2138,24 @@ dtStatus dtBuildTileCacheLayer(dtTileCacheCompressor* comp,
 		return status;
 	}
 
-	*outData = data;
-	*outDataSize = headerSize + compressedSize;
-	
 	dtFree(buffer);
+
+	// The data buffer was sized for the worst case.  Shrink it to fit so
+	// the compression saves memory as well as storage.
+	const int dataSize = headerSize + compressedSize;
+	if (dataSize < maxDataSize)
+	{
+		unsigned char* fitted = (unsigned char*)dtAlloc(dataSize, DT_ALLOC_PERM);
+		if (fitted)
+		{
+			memcpy(fitted, data, dataSize);
+			dtFree(data);
+			data = fitted;
+		}
+	}
+
+	*outData = data;
+	*outDataSize = dataSize;
 	
 	return DT_SUCCESS;
 }
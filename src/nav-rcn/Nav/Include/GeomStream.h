@@ -0,0 +1,45 @@
+#ifndef CAI_GEOMSTREAM_H
+#define CAI_GEOMSTREAM_H
+
+#include "DetourStatus.h"
+
+/// The bounds and size of a chunk of input geometry.
+struct rcnGeomChunk
+{
+	float bmin[3];
+	float bmax[3];
+	int nverts;
+	int ntris;
+};
+
+/// Loads a chunk into buffers sized from its rcnGeomChunk entry.  Triangle
+/// indices are local to the chunk.  May be called from several threads at
+/// once, but never twice for the same chunk at the same time.
+typedef bool (*rcnLoadGeomChunkFunc)(void* user, int chunk, float* verts, int* tris);
+
+/// Input geometry that is loaded a chunk at a time.
+///
+/// The chunk table describes the whole world up front so a build can tell
+/// which chunks each tile needs without loading them.  Chunks should be
+/// spatially compact.  (E.g. one per scene cell.)  A chunk is loaded when
+/// the first tile that overlaps it is built and freed once the last one has
+/// been gathered.
+struct rcnGeomSource
+{
+	const rcnGeomChunk* chunks;
+	int nchunks;
+	rcnLoadGeomChunkFunc loadChunk;
+	void* user;
+};
+
+/// Writes chunked geometry to a file one chunk at a time.
+struct rcnGeomFileWriter;
+
+/// An open chunked geometry file.  Only the chunk table is held in memory.
+struct rcnGeomFile;
+
+/// Gets the source that reads chunks from the file.  The source is valid
+/// until the file is freed.
+const rcnGeomSource* rcnGetGeomFileSource(const rcnGeomFile* file);
+
+#endif
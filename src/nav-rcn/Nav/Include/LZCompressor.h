@@ -0,0 +1,29 @@
+#ifndef CAI_LZCOMPRESSOR_H
+#define CAI_LZCOMPRESSOR_H
+
+#include "DetourTileCacheBuilder.h"
+
+/// A byte oriented LZ77 codec for tile cache layers.
+///
+/// The stream is a series of sequences.  Each sequence is a token byte
+/// (literal run length in the high nibble, match length - 4 in the low nibble,
+/// 15 meaning "add the following bytes until one is not 255"), the literal
+/// bytes, then a two byte little endian match offset.  The final sequence
+/// holds literals only.
+///
+/// Layer data is mostly long runs of identical heights, areas and
+/// connections, so it compresses well even with a single probe hash.
+struct LZCompressor : public dtTileCacheCompressor
+{
+	static LZCompressor instance;
+
+	virtual int maxCompressedSize(const int bufferSize);
+
+	virtual dtStatus compress(const unsigned char* buffer, const int bufferSize,
+		unsigned char* compressed, const int maxCompressedSize, int* compressedSize);
+
+	virtual dtStatus decompress(const unsigned char* compressed, const int compressedSize,
+		unsigned char* buffer, const int maxBufferSize, int* bufferSize);
+};
+
+#endif
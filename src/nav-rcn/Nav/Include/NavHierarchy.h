@@ -0,0 +1,87 @@
+#ifndef CAI_NAVHIERARCHY_H
+#define CAI_NAVHIERARCHY_H
+
+#include <vector>
+#include "DetourNavMeshQuery.h"
+
+/// A tile level graph of a navigation mesh for long distance path finding.
+///
+/// The nodes are entrances: small groups of connected polygons on a tile
+/// border that link into the same neighbour tile.  Each tile keeps the cost
+/// between each pair of its entrances, found with a search that stays inside
+/// the tile, and each entrance has an edge to the entrance it crosses into.
+///
+/// findPath searches this graph first, then refines the result a few tiles
+/// at a time with dtNavMeshQuery::findPath, so the query's node pool only has
+/// to hold a few tiles' worth of nodes however long the path is.  The path is
+/// close to, but not always as short as, the one a full A* search finds.
+/// The graph costs come from the filter given to init.
+///
+/// The graph does not track the mesh.  Call update after adding or removing
+/// tiles, or changing polygon flags or areas.  Only the tiles that changed and
+/// their neighbours are rebuilt.
+/// Tiles that changed since the last update are searched without the graph.
+///
+/// findPath may be called from several threads at once, each with its own
+/// query.  init and update must not overlap with anything else.
+class NavHierarchy
+{
+public:
+	NavHierarchy();
+	~NavHierarchy();
+
+	/// Builds the graph for every tile in the mesh.  The filter decides which
+	/// polygons can be used and sets the edge costs.  It is copied.
+	dtStatus init(const dtNavMesh* nav, const dtQueryFilter* filter);
+
+	/// Rebuilds the tiles that were added, removed, or had polygon flags or
+	/// areas changed since the last update, and their neighbours.
+	///  @param[out]	rebuiltCount	The number of tiles rebuilt. [Opt]
+	dtStatus update(int* rebuiltCount);
+
+	/// Finds a polygon path from the start to the end polygon.  Behaves like
+	/// dtNavMeshQuery::findPath, which is used directly for nearby tiles.
+	dtStatus findPath(dtNavMeshQuery* query
+		, dtPolyRef startRef, dtPolyRef endRef
+		, const float* startPos, const float* endPos
+		, const dtQueryFilter* filter
+		, dtPolyRef* path, int* pathCount, const int maxPath) const;
+
+	/// The number of entrances in the graph.
+	int getNodeCount() const;
+
+private:
+	struct Entrance
+	{
+		dtPolyRef ref;		// The polygon the entrance is placed on.
+		dtPolyRef cross;	// The polygon in the neighbour tile it links to.
+		float pos[3];		// The center of the polygon.
+	};
+
+	struct Cluster
+	{
+		Cluster() : built(false), salt(0), polyRevision(0), x(0), y(0) {}
+
+		bool built;
+		unsigned int salt;	// Of the tile the cluster was built for.
+		unsigned int polyRevision;	// Of the tile's polygon flags and areas.
+		int x, y;
+		std::vector<Entrance> entrances;
+		std::vector<float> costs;	// Between each pair of entrances.  (FLT_MAX if none.)
+		std::vector<unsigned short> polyEntrance;	// Per polygon.  (NO_ENTRANCE if none.)
+	};
+
+	bool isCurrent(const unsigned int tileIndex) const;
+	void buildCluster(const int tileIndex);
+	void searchTile(const dtMeshTile* tile, const int start, const float* startPos
+		, std::vector<float>& dist) const;
+
+	const dtNavMesh* m_nav;
+	dtQueryFilter m_filter;
+	std::vector<Cluster> m_clusters;	// Per tile index.
+
+	NavHierarchy(const NavHierarchy&);
+	NavHierarchy& operator=(const NavHierarchy&);
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef CAI_NAVJOBSYSTEM_H
+#define CAI_NAVJOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// A fixed pool of worker threads that runs one range job at a time.
+///
+/// The calling thread works too, as thread 0, so a pool started with N
+/// threads runs N - 1 workers.  Ranges are handed out from an atomic
+/// counter, so threads that finish early take over the remaining items.
+///
+/// run() is not reentrant.  Callers that share a job system between
+/// threads must serialize their calls.
+class NavJobSystem
+{
+public:
+	/// The job function.  Processes items [begin, end) on the given thread.
+	typedef void (*JobFunc)(void* ctx, int begin, int end, int thread);
+
+	/// @param[in]	minParallelCount	Runs with fewer items than this stay on the
+	///  								calling thread.
+	explicit NavJobSystem(const int minParallelCount);
+	~NavJobSystem();
+
+	/// Starts the workers.  Only call once.
+	void startThreads(const int threadCount);
+
+	/// The number of threads that run jobs, including the calling thread.
+	int getThreadCount() const { return (int)m_threads.size() + 1; }
+
+	/// Runs @p job over [0, count) and returns when all items are done.
+	void run(JobFunc job, void* ctx, const int count);
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	NavJobSystem(const NavJobSystem&);
+	NavJobSystem& operator=(const NavJobSystem&);
+
+	void work(const int thread);
+	void workerMain(const int thread);
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_lock;
+	std::condition_variable m_start;
+	std::condition_variable m_finished;
+
+	const int m_minParallelCount;
+	JobFunc m_job;
+	void* m_ctx;
+	int m_count;
+	int m_chunk;
+	std::atomic<int> m_next;
+	unsigned int m_generation;
+	int m_running;
+	bool m_quit;
+};
+
+#endif
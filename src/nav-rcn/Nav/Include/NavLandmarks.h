@@ -0,0 +1,100 @@
+#ifndef CAI_NAVLANDMARKS_H
+#define CAI_NAVLANDMARKS_H
+
+#include <vector>
+#include "DetourNavMeshQuery.h"
+
+/// An ALT (A*, landmarks and the triangle inequality) heuristic for
+/// dtNavMeshQuery.
+///
+/// A few landmark polygons are picked far apart from each other, and the
+/// path cost from each landmark to every polygon is stored in a table per
+/// tile.  For any landmark L, the cost from a polygon to the goal is at least
+/// |cost(L, goal) - cost(L, polygon)|.  On meshes where walls keep paths far
+/// longer than the straight line, such as mazes and buildings, this bound is
+/// much closer than the straight line distance and the searches expand far
+/// fewer nodes.  Set it on a query with dtNavMeshQuery::setHeuristic.
+///
+/// The bound is not guaranteed to stay below the real cost, so paths found
+/// with it are not guaranteed to be the shortest.  The table costs are to one
+/// point in each polygon, while the search is at another, so the bound gives
+/// up the most a move across the polygon and across the goal polygon can
+/// cost.  But the tables, like the searches, measure paths between points
+/// fixed on the polygon edges, and along a long path the error can add up to
+/// more than that.  On a test maze, more than half of the paths came out
+/// longer: by 0.8% in total and 4.5% at most.  On open ground it was one path
+/// in 300, by 0.3%.
+///
+/// The costs come from the filter given to init and assume the same cost in
+/// both directions.  Searches with filters of lower area costs get paths that
+/// are further from the shortest.
+///
+/// The tables do not track the mesh.  A tile that was added or replaced has
+/// no bound until update is called, which runs the landmark searches again.
+/// Changes to polygon flags and areas need an update too.
+///
+/// getGoal and getLowerBound may be called from several threads at once.
+/// init and update must not overlap with anything else.
+class NavLandmarks : public dtPathHeuristic
+{
+public:
+	NavLandmarks();
+	virtual ~NavLandmarks();
+
+	/// Picks the landmarks and builds the tables for every tile in the mesh.
+	/// The filter decides which polygons can be used and sets the costs.  It
+	/// is copied.
+	///  @param[in]	landmarkCount	The number of landmarks.
+	///  							[Limits: 0 < value < #DT_MAX_HEURISTIC_GOAL]
+	dtStatus init(const dtNavMesh* nav, const dtQueryFilter* filter, const int landmarkCount);
+
+	/// Loads the landmarks and tables from getRawData.  The tables of tiles
+	/// that are not in the mesh as they were saved are left out, so the next
+	/// update rebuilds them.
+	dtStatus initFromRawData(const dtNavMesh* nav, const dtQueryFilter* filter
+		, const unsigned char* data, const int dataSize);
+
+	/// Rebuilds the tables if tiles were added or removed since the last
+	/// update.  Landmarks that are still on the mesh are kept.
+	///  @param[out]	changedCount	The number of tiles that changed. [Opt]
+	dtStatus update(int* changedCount);
+
+	/// Saves the landmarks and tables.  The tiles are identified by reference,
+	/// as in the raw navigation mesh data, so the tables can be loaded with
+	/// the mesh.  Free the data with dtFree.
+	dtStatus getRawData(unsigned char** data, int* dataSize) const;
+
+	/// The number of landmarks in use.  May be fewer than asked for if the
+	/// mesh is small.
+	int getLandmarkCount() const { return (int)m_landmarks.size(); }
+	dtPolyRef getLandmark(const int i) const { return m_landmarks[i]; }
+
+	virtual bool getGoal(dtPolyRef ref, float* goal) const;
+	virtual float getLowerBound(dtPolyRef ref, const float* goal) const;
+
+private:
+	struct TileTable
+	{
+		TileTable() : built(false), salt(0) {}
+
+		bool built;
+		unsigned int salt;		// Of the tile the table was built for.
+		std::vector<float> costs;	// Per polygon, per landmark.  (FLT_MAX if unreached.)
+		std::vector<float> slack;	// Per polygon.
+	};
+
+	dtStatus build();
+	bool isCurrent(const int tileIndex) const;
+	const float* getCosts(dtPolyRef ref, float* slack) const;
+
+	const dtNavMesh* m_nav;
+	dtQueryFilter m_filter;
+	int m_maxLandmarks;		// The stride of the tables.
+	std::vector<dtPolyRef> m_landmarks;
+	std::vector<TileTable> m_tables;	// Per tile index.
+
+	NavLandmarks(const NavLandmarks&);
+	NavLandmarks& operator=(const NavLandmarks&);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef CAI_NAVPATHCACHE_H
+#define CAI_NAVPATHCACHE_H
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "DetourNavMeshQuery.h"
+
+/// A least recently used cache of polygon paths in front of
+/// dtNavMeshQuery::findPath.
+///
+/// Entries are keyed on the start and end polygons and the filter's include
+/// and exclude flags and area costs.  The start and end points only matter
+/// on a miss, so a hit returns the path found for the first request between
+/// the two polygons.  Straight paths depend on the points and are not
+/// cached.  Run dtNavMeshQuery::findStraightPath on the result as usual.
+///
+/// Each entry remembers the salt and polygon revision of every tile its path
+/// crosses.  An entry is dropped on lookup if any of those tiles was removed,
+/// replaced, or had a polygon's flags or area changed through the mesh, so
+/// the cache never needs to be told about mesh changes.  Flags and areas
+/// written directly to a dtPoly are not seen.  Only complete paths are
+/// cached.
+///
+/// findPath may be called from several threads at once, each with its own
+/// query.
+class NavPathCache
+{
+public:
+	NavPathCache();
+	~NavPathCache();
+
+	/// Sets up an empty cache.
+	///  @param[in]	maxEntries	The maximum number of paths held. [Limit: > 0]
+	dtStatus init(const dtNavMesh* nav, const int maxEntries);
+
+	/// Finds a polygon path from the start to the end polygon.  Behaves like
+	/// dtNavMeshQuery::findPath, which is called on a miss.
+	dtStatus findPath(dtNavMeshQuery* query
+		, dtPolyRef startRef, dtPolyRef endRef
+		, const float* startPos, const float* endPos
+		, const dtQueryFilter* filter
+		, dtPolyRef* path, int* pathCount, const int maxPath);
+
+	/// Drops all entries.  The counters are kept.
+	void clear();
+
+	void resetCounters();
+	int getHitCount() const;
+	int getMissCount() const;
+	int getEntryCount() const;
+
+private:
+	struct Key
+	{
+		dtPolyRef startRef;
+		dtPolyRef endRef;
+		unsigned long long filter;	// Hash of the filter.
+
+		bool operator==(const Key& o) const
+		{
+			return startRef == o.startRef && endRef == o.endRef && filter == o.filter;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& k) const;
+	};
+
+	struct TileState
+	{
+		int index;
+		unsigned int salt;
+		unsigned int polyRevision;
+	};
+
+	struct Entry
+	{
+		Key key;
+		std::vector<dtPolyRef> path;
+		std::vector<TileState> tiles;
+		int prev, next;		// Recently used list.  (-1 at the ends.)
+	};
+
+	bool isValid(const Entry& entry) const;
+	void unlink(const int i);
+	void pushFront(const int i);
+	void remove(const int i);
+
+	const dtNavMesh* m_nav;
+
+	// Guards everything below.  The searches run outside it.
+	mutable std::mutex m_lock;
+	std::vector<Entry> m_entries;
+	std::vector<int> m_free;
+	std::unordered_map<Key, int, KeyHash> m_index;
+	int m_head, m_tail;
+	int m_hits, m_misses;
+
+	NavPathCache(const NavPathCache&);
+	NavPathCache& operator=(const NavPathCache&);
+};
+
+#endif
@@ -20,12 +20,19 @@
  * THE SOFTWARE.
  */
 #include <string.h>
+#include <new>
+#include <thread>
 #include "DetourCrowd.h"
 #include "DetourCommon.h"
 #include "DetourEx.h"
+#include "NavJobSystem.h"
 
 static const int MAX_LOCAL_BOUNDARY_SEGS = 8;
 
+// The state dtcUpdateAgentStates reports for removed agents.  It is not a
+// CrowdAgentState.  (CrowdAgentState.Inactive in the C# code.)
+static const unsigned char AGENT_STATE_INACTIVE = 0xff;
+
 struct rcnLocalBoundary
 {
     float center[3];
@@ -66,6 +73,46 @@ struct rcnCrowdAgentCoreData
 	float corner[3];	// Next corner.
 };
 
+// Runs the parallel crowd update phases on a NavJobSystem.  The calling
+// thread works too, as thread 0.
+class CrowdJobSystem : public dtCrowdJobSystem
+{
+public:
+	CrowdJobSystem()
+		: m_jobs(MIN_PARALLEL_COUNT)
+	{
+	}
+
+	void startThreads(const int threadCount)
+	{
+		m_jobs.startThreads(threadCount);
+	}
+
+	virtual int getThreadCount() const
+	{
+		return m_jobs.getThreadCount();
+	}
+
+	virtual void run(dtCrowdJobFunc job, void* ctx, const int count)
+	{
+		m_jobs.run(job, ctx, count);
+	}
+
+private:
+	// Small batches are not worth waking the workers for.
+	static const int MIN_PARALLEL_COUNT = 32;
+
+	NavJobSystem m_jobs;
+};
+
+static void updateCrowd(dtCrowd* crowd, const float dt, dtCrowdJobSystem* jobs)
+{
+	if (jobs && crowd->getMaxThreads() < jobs->getThreadCount())
+		crowd->initThreads(jobs->getThreadCount());
+
+	crowd->update(dt, 0, jobs);
+}
+
 extern "C"
 {
     EXPORT_API dtCrowd* dtcDetourCrowdAlloc(const int maxAgents
@@ -291,6 +338,123 @@ extern "C"
         }
     }
 
+    // Creates a thread pool for dtcUpdateParallel.  threadCount includes
+    // the calling thread.  (One per hardware core if threadCount <= 0.)
+    // A pool can be shared by crowds that are not updated at the same time.
+    EXPORT_API dtCrowdJobSystem* dtcJobSystemAlloc(int threadCount)
+    {
+        if (threadCount <= 0)
+            threadCount = dtMax(1, (int)std::thread::hardware_concurrency());
+
+        CrowdJobSystem* jobs = new(std::nothrow) CrowdJobSystem();
+        if (jobs)
+            jobs->startThreads(threadCount);
+        return jobs;
+    }
+
+    EXPORT_API void dtcJobSystemFree(dtCrowdJobSystem* jobs)
+    {
+        delete jobs;
+    }
+
+    // Same as dtcUpdate, but runs the per-agent work on the job system's
+    // threads.  The result is the same as dtcUpdate.
+    EXPORT_API void dtcUpdateParallel(dtCrowd* crowd
+        , const float dt
+        , rcnCrowdAgentCoreData* coreData
+        , dtCrowdJobSystem* jobs)
+    {
+        updateCrowd(crowd, dt, jobs);
+
+        for (int i = 0; i < crowd->getAgentCount(); i++)
+        {
+            dtcaGetAgentCoreData(crowd->getAgent(i), &coreData[i]);
+        }
+    }
+
+    // Updates the crowd, then writes the position, velocity and state of
+    // each active agent that changed into the caller's arrays.  The arrays
+    // are indexed by agent index and must keep the values from the previous
+    // call, since changes are detected against them.  An agent removed since
+    // the previous call is reported once, with state AGENT_STATE_INACTIVE.
+    // [Size: positions, velocities: 3 * getAgentCount(),
+    //  states, dirtyAgents: getAgentCount()]
+    // The indices of the changed agents are written to dirtyAgents.
+    // jobs is optional.  Returns the number of changed agents.
+    EXPORT_API int dtcUpdateAgentStates(dtCrowd* crowd
+        , const float dt
+        , dtCrowdJobSystem* jobs
+        , float* positions
+        , float* velocities
+        , unsigned char* states
+        , int* dirtyAgents)
+    {
+        if (!crowd || !positions || !velocities || !states || !dirtyAgents)
+            return 0;
+
+        updateCrowd(crowd, dt, jobs);
+
+        int ndirty = 0;
+
+        // An agent that was added again is reported below, since its state
+        // no longer matches.
+        const int* removed;
+        const int nremoved = crowd->getRemovedAgents(&removed);
+        if (nremoved < 0)
+        {
+            // Too many to list.  Fall back to searching the pool.  (Slots
+            // that were never used are reported once too.)
+            for (int i = 0; i < crowd->getAgentCount(); i++)
+            {
+                if (!crowd->getAgent(i)->active && states[i] != AGENT_STATE_INACTIVE)
+                {
+                    states[i] = AGENT_STATE_INACTIVE;
+                    dirtyAgents[ndirty++] = i;
+                }
+            }
+        }
+        else
+        {
+            for (int i = 0; i < nremoved; i++)
+            {
+                const int idx = removed[i];
+                if (states[idx] == AGENT_STATE_INACTIVE)
+                    continue;
+
+                states[idx] = AGENT_STATE_INACTIVE;
+                if (!crowd->getAgent(idx)->active)
+                    dirtyAgents[ndirty++] = idx;
+            }
+        }
+        crowd->clearRemovedAgents();
+
+        int nagents;
+        dtCrowdAgent* const* agents = crowd->getUpdatedAgents(&nagents);
+        const dtCrowdAgent* pool = crowd->getAgent(0);
+        for (int i = 0; i < nagents; i++)
+        {
+            const dtCrowdAgent* agent = agents[i];
+            const int idx = (int)(agent - pool);
+
+            float* pos = &positions[idx * 3];
+            float* vel = &velocities[idx * 3];
+
+            if (states[idx] == agent->state
+                && memcmp(pos, agent->npos, sizeof(float) * 3) == 0
+                && memcmp(vel, agent->vel, sizeof(float) * 3) == 0)
+            {
+                continue;
+            }
+
+            states[idx] = agent->state;
+            dtVcopy(pos, agent->npos);
+            dtVcopy(vel, agent->vel);
+            dirtyAgents[ndirty++] = idx;
+        }
+
+        return ndirty;
+    }
+
     EXPORT_API int dtcAddAgent(dtCrowd* crowd
         , const float* pos
         , const dtCrowdAgentParams* params
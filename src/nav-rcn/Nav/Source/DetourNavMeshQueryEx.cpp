@@ -21,8 +21,16 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
 #include "DetourNavMeshQuery.h"
+#include "DetourAlloc.h"
+#include "DetourCommon.h"
 #include "DetourEx.h"
+#include "NavJobSystem.h"
 
 // Returns a random number [0..1)
 static float frand()
@@ -30,6 +38,234 @@ static float frand()
 	return (float)rand()/(float)RAND_MAX;
 }
 
+// Snaps the points with a zero polygon reference to the mesh, then finds the
+// path between them.
+static dtStatus findPathExt(dtNavMeshQuery* query
+	, rcnNavmeshPoint* startPos
+	, rcnNavmeshPoint* endPos
+	, const float* extents
+	, const dtQueryFilter* filter
+	, dtPolyRef* path
+	, int* pathCount
+	, const int maxPath)
+{
+	if (startPos->polyRef == 0)
+	{
+		dtStatus status = query->findNearestPoly(&startPos->point[0]
+			, extents
+			, filter
+			, &startPos->polyRef
+			, &startPos->point[0]);
+		if (dtStatusFailed(status))
+			return status;
+	}
+
+	if (endPos->polyRef == 0)
+	{
+		dtStatus status = query->findNearestPoly(&endPos->point[0]
+			, extents
+			, filter
+			, &endPos->polyRef
+			, &endPos->point[0]);
+		if (dtStatusFailed(status))
+			return status;
+	}
+
+	if (startPos->polyRef == 0 || endPos->polyRef == 0)
+		// One of the searches failed. 
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	return query->findPath(startPos->polyRef
+		, endPos->polyRef
+		, &startPos->point[0]
+		, &endPos->point[0]
+		, filter
+		, path
+		, pathCount
+		, maxPath);
+}
+
+static dtStatus createQuery(const dtNavMesh* nav, const int maxNodes, dtNavMeshQuery** result)
+{
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	if (!query)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	dtStatus status = query->init(nav, maxNodes);
+	if (dtStatusFailed(status))
+	{
+		dtFreeNavMeshQuery(query);
+		return status;
+	}
+
+	*result = query;
+	return DT_SUCCESS;
+}
+
+// Hands out queries for one navigation mesh to concurrent callers, and runs
+// batches of path requests on a pool of worker threads.  Every query,
+// including the one each worker uses, has its own node pool and queue, so the
+// only shared state is the mesh.  The mesh must not change while queries are
+// in use.
+class NavQueryPool
+{
+public:
+	NavQueryPool(const dtNavMesh* nav, const int maxNodes)
+		: m_nav(nav)
+		, m_maxNodes(maxNodes)
+		, m_jobs(MIN_PARALLEL_COUNT)
+	{
+	}
+
+	~NavQueryPool()
+	{
+		for (size_t i = 0; i < m_queries.size(); ++i)
+			dtFreeNavMeshQuery(m_queries[i]);
+		for (size_t i = 0; i < m_threadQueries.size(); ++i)
+			dtFreeNavMeshQuery(m_threadQueries[i]);
+	}
+
+	void startThreads(const int threadCount)
+	{
+		m_jobs.startThreads(threadCount);
+		m_threadQueries.resize(m_jobs.getThreadCount(), 0);
+	}
+
+	int getThreadCount() const { return m_jobs.getThreadCount(); }
+
+	// Takes a free query, or creates one if all are in use.
+	dtStatus acquire(dtNavMeshQuery** query)
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			if (!m_free.empty())
+			{
+				*query = m_free.back();
+				m_free.pop_back();
+				return DT_SUCCESS;
+			}
+		}
+
+		dtNavMeshQuery* result = 0;
+		dtStatus status = createQuery(m_nav, m_maxNodes, &result);
+		if (dtStatusFailed(status))
+			return status;
+
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_queries.push_back(result);
+		*query = result;
+
+		return DT_SUCCESS;
+	}
+
+	dtStatus release(dtNavMeshQuery* query)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+
+		if (std::find(m_queries.begin(), m_queries.end(), query) == m_queries.end()
+			|| std::find(m_free.begin(), m_free.end(), query) != m_free.end())
+		{
+			// Not from this pool, or already released.
+			return DT_FAILURE | DT_INVALID_PARAM;
+		}
+
+		m_free.push_back(query);
+
+		return DT_SUCCESS;
+	}
+
+	// Finds the paths for a batch of requests.  Request i writes up to
+	// maxPath polygons to paths[i * maxPath].
+	void findPaths(rcnNavmeshPoint* startPos
+		, rcnNavmeshPoint* endPos
+		, const int count
+		, const float* extents
+		, const dtQueryFilter* filter
+		, dtPolyRef* paths
+		, int* pathCounts
+		, const int maxPath
+		, dtStatus* statuses)
+	{
+		FindPathsJob job;
+		job.pool = this;
+		job.startPos = startPos;
+		job.endPos = endPos;
+		job.extents = extents;
+		job.filter = filter;
+		job.paths = paths;
+		job.pathCounts = pathCounts;
+		job.maxPath = maxPath;
+		job.statuses = statuses;
+
+		// The workers and their queries serve one batch at a time.
+		std::lock_guard<std::mutex> guard(m_batchLock);
+		m_jobs.run(findPathsRange, &job, count);
+	}
+
+private:
+	// Path searches are long enough to spread even tiny batches.
+	static const int MIN_PARALLEL_COUNT = 2;
+
+	struct FindPathsJob
+	{
+		NavQueryPool* pool;
+		rcnNavmeshPoint* startPos;
+		rcnNavmeshPoint* endPos;
+		const float* extents;
+		const dtQueryFilter* filter;
+		dtPolyRef* paths;
+		int* pathCounts;
+		int maxPath;
+		dtStatus* statuses;
+	};
+
+	static void findPathsRange(void* ctx, const int begin, const int end, const int thread)
+	{
+		FindPathsJob* job = (FindPathsJob*)ctx;
+		NavQueryPool* pool = job->pool;
+
+		// Each thread only touches its own query, so it is created lazily
+		// without locking.
+		dtNavMeshQuery*& query = pool->m_threadQueries[thread];
+		dtStatus status = DT_SUCCESS;
+		if (!query)
+			status = createQuery(pool->m_nav, pool->m_maxNodes, &query);
+
+		for (int i = begin; i < end; ++i)
+		{
+			job->pathCounts[i] = 0;
+			if (dtStatusFailed(status))
+			{
+				job->statuses[i] = status;
+				continue;
+			}
+			job->statuses[i] = findPathExt(query
+				, &job->startPos[i]
+				, &job->endPos[i]
+				, job->extents
+				, job->filter
+				, &job->paths[i * job->maxPath]
+				, &job->pathCounts[i]
+				, job->maxPath);
+		}
+	}
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	NavQueryPool(const NavQueryPool&);
+	NavQueryPool& operator=(const NavQueryPool&);
+
+	const dtNavMesh* m_nav;
+	const int m_maxNodes;
+
+	std::mutex m_lock;
+	std::vector<dtNavMeshQuery*> m_queries;
+	std::vector<dtNavMeshQuery*> m_free;
+
+	std::mutex m_batchLock;
+	NavJobSystem m_jobs;
+	std::vector<dtNavMeshQuery*> m_threadQueries;
+};
+
 extern "C"
 {
     EXPORT_API dtStatus dtnqBuildDTNavQuery(dtNavMesh* pNavMesh
@@ -239,36 +475,10 @@ extern "C"
         , int* pathCount
         , const int maxPath)
     {
-		if (startPos->polyRef == 0)
-        {
-			dtStatus status = query->findNearestPoly(&startPos->point[0]
-                , extents
-                , filter
-				, &startPos->polyRef
-				, &startPos->point[0]);
-            if (dtStatusFailed(status))
-                return status;
-        }
-
-		if (endPos->polyRef == 0)
-        {
-			dtStatus status = query->findNearestPoly(&endPos->point[0]
-                , extents
-                , filter
-				, &endPos->polyRef
-				, &endPos->point[0]);
-            if (dtStatusFailed(status))
-                return status;
-        }
-
-		if (startPos->polyRef == 0 || endPos->polyRef == 0)
-            // One of the searches failed. 
-            return DT_FAILURE | DT_INVALID_PARAM;
-
-		return query->findPath(startPos->polyRef
-			, endPos->polyRef
-			, &startPos->point[0]
-            , &endPos->point[0]
+		return findPathExt(query
+            , startPos
+            , endPos
+            , extents
             , filter
             , path
             , pathCount
@@ -332,6 +542,124 @@ extern "C"
             , maxStraightPath);
     }
 
+    // Finds the straight paths for count requests in a single call.  Points
+    // with a zero polygon reference are snapped to the mesh first, as for
+    // dtqFindPathExt.  The results are packed one after the other: request i
+    // writes straightCounts[i] points starting at point offsets[i].  Requests
+    // that don't fit in the remaining space fail with DT_BUFFER_TOO_SMALL.
+    // A request cut short by the end of the buffer succeeds with the points
+    // that fit, and its status has DT_BUFFER_TOO_SMALL.
+    // (straightPathFlags and straightPathRefs are optional.)
+    EXPORT_API dtStatus dtqFindStraightPaths(dtNavMeshQuery* query
+        , rcnNavmeshPoint* startPos
+        , rcnNavmeshPoint* endPos
+        , const int count
+        , const float* extents
+        , const dtQueryFilter* filter
+        , const int maxPath
+        , float* straightPath
+        , unsigned char* straightPathFlags
+        , dtPolyRef* straightPathRefs
+        , const int maxStraightPath
+        , int* offsets
+        , int* straightCounts
+        , dtStatus* statuses
+        , int* totalCount)
+    {
+        if (!query || count < 0 || maxPath < 1 || !extents || !filter || !totalCount
+            || maxStraightPath < 0 || (maxStraightPath > 0 && !straightPath)
+            || (count > 0 && (!startPos || !endPos || !offsets || !straightCounts || !statuses)))
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        dtPolyRef* path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef) * maxPath, DT_ALLOC_TEMP);
+        if (!path)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        dtStatus result = DT_SUCCESS;
+        int used = 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            offsets[i] = used;
+            straightCounts[i] = 0;
+
+            int pathCount = 0;
+            dtStatus status = findPathExt(query
+                , &startPos[i]
+                , &endPos[i]
+                , extents
+                , filter
+                , path
+                , &pathCount
+                , maxPath);
+
+            if (dtStatusFailed(status) || pathCount == 0)
+            {
+                statuses[i] = dtStatusFailed(status) ? status : DT_FAILURE;
+                continue;
+            }
+
+            if (used >= maxStraightPath)
+            {
+                statuses[i] = DT_FAILURE | DT_BUFFER_TOO_SMALL;
+                result |= DT_BUFFER_TOO_SMALL;
+                continue;
+            }
+
+            // A partial path ends short of the end point, so straighten it to
+            // the closest point on its last polygon instead.
+            float end[3];
+            dtVcopy(end, &endPos[i].point[0]);
+            if (path[pathCount - 1] != endPos[i].polyRef)
+                query->closestPointOnPoly(path[pathCount - 1], &endPos[i].point[0], end, 0);
+
+            dtStatus straightStatus = query->findStraightPath(&startPos[i].point[0]
+                , end
+                , path
+                , pathCount
+                , &straightPath[used * 3]
+                , straightPathFlags ? &straightPathFlags[used] : 0
+                , straightPathRefs ? &straightPathRefs[used] : 0
+                , &straightCounts[i]
+                , maxStraightPath - used);
+
+            if (dtStatusFailed(straightStatus))
+            {
+                statuses[i] = straightStatus;
+                straightCounts[i] = 0;
+                continue;
+            }
+
+            // findStraightPath also sets DT_BUFFER_TOO_SMALL when the path
+            // exactly fills the space left.  Keep it only when the path was
+            // cut short, so the status tells the caller about the truncation.
+            if (dtStatusDetail(straightStatus, DT_BUFFER_TOO_SMALL))
+            {
+                float closestEnd[3];
+                const float* last = &straightPath[(used + straightCounts[i] - 1) * 3];
+                if (dtStatusSucceed(query->closestPointOnPolyBoundary(path[pathCount - 1], end, closestEnd))
+                    && dtVequal(last, closestEnd))
+                {
+                    straightStatus &= ~DT_BUFFER_TOO_SMALL;
+                }
+            }
+
+            statuses[i] = status | straightStatus;
+            if (dtStatusDetail(straightStatus, DT_BUFFER_TOO_SMALL))
+                result |= DT_BUFFER_TOO_SMALL;
+
+            used += straightCounts[i];
+        }
+
+        dtFree(path);
+
+        *totalCount = used;
+
+        return result;
+    }
+
     EXPORT_API dtStatus dtqMoveAlongSurface(dtNavMeshQuery* query
         , rcnNavmeshPoint startPos
         , const float* endPos
@@ -354,13 +682,15 @@ extern "C"
 	EXPORT_API dtStatus dtqInitSlicedFindPath(dtNavMeshQuery* query
         , rcnNavmeshPoint startPos
         , rcnNavmeshPoint endPos
-        , const dtQueryFilter* filter)
+        , const dtQueryFilter* filter
+        , const unsigned int options)
     {
 		return query->initSlicedFindPath(startPos.polyRef
 			, endPos.polyRef
 			, &startPos.point[0]
 			, &endPos.point[0]
-            , filter);
+            , filter
+            , options);
     }
 
 	EXPORT_API dtStatus dtqUpdateSlicedFindPath(dtNavMeshQuery* query
@@ -396,4 +726,96 @@ extern "C"
 			, &randomPt->polyRef, &randomPt->point[0]);
 	}
 
+    // Creates a query pool for the navigation mesh.  threadCount is the
+    // number of threads used by dtnqpFindPaths, including the calling
+    // thread.  (One per hardware core if threadCount <= 0.)
+    EXPORT_API dtStatus dtnqpAlloc(dtNavMesh* navmesh
+        , const int maxNodes
+        , int threadCount
+        , NavQueryPool** ppPool)
+    {
+        if (!navmesh || !ppPool)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        if (threadCount <= 0)
+            threadCount = dtMax(1, (int)std::thread::hardware_concurrency());
+
+        NavQueryPool* pool = new(std::nothrow) NavQueryPool(navmesh, maxNodes);
+        if (!pool)
+            return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+        // Create the first query up front so bad parameters fail here.
+        dtNavMeshQuery* query = 0;
+        dtStatus status = pool->acquire(&query);
+        if (dtStatusFailed(status))
+        {
+            delete pool;
+            return status;
+        }
+        pool->release(query);
+
+        pool->startThreads(threadCount);
+
+        *ppPool = pool;
+
+        return DT_SUCCESS;
+    }
+
+    // Frees the pool and all of its queries, including acquired ones.
+    EXPORT_API void dtnqpFree(NavQueryPool* pool)
+    {
+        delete pool;
+    }
+
+    EXPORT_API int dtnqpGetThreadCount(NavQueryPool* pool)
+    {
+        return pool ? pool->getThreadCount() : 0;
+    }
+
+    // Gets a query for the exclusive use of the caller until it is released.
+    EXPORT_API dtStatus dtnqpAcquire(NavQueryPool* pool
+        , dtNavMeshQuery** query)
+    {
+        if (!pool || !query)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return pool->acquire(query);
+    }
+
+    EXPORT_API dtStatus dtnqpRelease(NavQueryPool* pool
+        , dtNavMeshQuery* query)
+    {
+        if (!pool || !query)
+            return DT_FAILURE | DT_INVALID_PARAM;
+
+        return pool->release(query);
+    }
+
+    // Finds the paths for count requests on the pool's threads.  Points with
+    // a zero polygon reference are snapped to the mesh first, as for
+    // dtqFindPathExt.  Request i writes its path to paths[i * maxPath], its
+    // size to pathCounts[i] and its status to statuses[i].
+    EXPORT_API dtStatus dtnqpFindPaths(NavQueryPool* pool
+        , rcnNavmeshPoint* startPos
+        , rcnNavmeshPoint* endPos
+        , const int count
+        , const float* extents
+        , const dtQueryFilter* filter
+        , dtPolyRef* paths
+        , int* pathCounts
+        , const int maxPath
+        , dtStatus* statuses)
+    {
+        if (!pool || count < 0 || maxPath < 1 || !extents || !filter
+            || (count > 0 && (!startPos || !endPos || !paths || !pathCounts || !statuses)))
+        {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+
+        pool->findPaths(startPos, endPos, count, extents, filter
+            , paths, pathCounts, maxPath, statuses);
+
+        return DT_SUCCESS;
+    }
+
 }
\ No newline at end of file
@@ -5,7 +5,20 @@
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
 #include "ChunkyTriMesh.h"
+#include "DetourEx.h"
+#include "LZCompressor.h"
+#include "GeomStream.h"
+#include <stdio.h>
 #include <string.h>
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
 
 struct Compressor : public dtTileCacheCompressor
 {
@@ -35,46 +48,121 @@ struct Compressor : public dtTileCacheCompressor
 
 Compressor Compressor::instance;
 
+// Layer compression used by the tile cache.
+// Note: Keep in sync with the managed TileCacheCompression enum.
+enum rcnTileCacheCompression
+{
+	RCN_TILECACHE_COMPRESSION_NONE = 0,
+	RCN_TILECACHE_COMPRESSION_LZ = 1,
+};
+
+// Size information for a completed tile cache build.
+struct rcnTileCacheBuildStats
+{
+	int layerCount;
+	int compressedSize;		// Total size of the compressed layers.
+	int rawSize;			// Total size of the layers if uncompressed.
+	int navmeshSize;		// Total size of the navmesh tile data.
+	int inputPeakSize;		// Most input geometry loaded at once. (Streamed builds.)
+	int inputChunkLoads;	// Number of geometry chunks loaded. (Streamed builds.)
+	int chunkyMeshMapped;	// 1 if the chunky mesh was mapped from its cache file.
+	int tilesReused;		// Tiles whose layers were taken from the bake manifest.
+};
+
+// A bump allocator for tile rebuilds that grows in pages.
+//
+// Pages are kept across reset() so a tile cache settles on the amount of
+// memory its largest tile needs and then stops allocating.  Each tile cache
+// gets its own instance, so separate tile caches can rebuild concurrently.
 struct LinearAllocator : public dtTileCacheAlloc
 {
-	static LinearAllocator instance;
+	struct Page
+	{
+		Page* next;
+		size_t capacity;
+		size_t top;
+	};
+
+	// Allocations are aligned to this many bytes.
+	static const size_t ALIGNMENT = 8;
 
-	unsigned char* buffer;
+	Page* first;
+	Page* current;
+	size_t pageSize;
 	size_t capacity;
-	size_t top;
+	size_t used;
 	size_t high;
 
-	LinearAllocator(const size_t cap) : buffer(0), capacity(0), top(0), high(0)
+	LinearAllocator(const size_t initialPageSize)
+		: first(0), current(0), pageSize(initialPageSize), capacity(0), used(0), high(0)
 	{
-		resize(cap);
 	}
 
 	~LinearAllocator()
 	{
-		dtFree(buffer);
+		Page* page = first;
+		while (page)
+		{
+			Page* next = page->next;
+			dtFree(page);
+			page = next;
+		}
+	}
+
+	static inline unsigned char* getPageData(Page* page)
+	{
+		return (unsigned char*)page + align(sizeof(Page));
 	}
 
-	void resize(const size_t cap)
+	static inline size_t align(const size_t size)
 	{
-		if (buffer) dtFree(buffer);
-		buffer = (unsigned char*)dtAlloc(cap, DT_ALLOC_PERM);
-		capacity = cap;
+		return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
 	}
 
 	virtual void reset()
 	{
-		high = dtMax(high, top);
-		top = 0;
+		high = dtMax(high, used);
+		used = 0;
+		for (Page* page = first; page; page = page->next)
+			page->top = 0;
+		current = first;
 	}
 
 	virtual void* alloc(const size_t size)
 	{
-		if (!buffer)
-			return 0;
-		if (top + size > capacity)
-			return 0;
-		unsigned char* mem = &buffer[top];
-		top += size;
+		const size_t asize = align(size);
+
+		// Use the first remaining page with enough room.
+		while (current && current->top + asize > current->capacity)
+			current = current->next;
+
+		if (!current)
+		{
+			const size_t cap = dtMax(pageSize, asize);
+			Page* page = (Page*)dtAlloc(align(sizeof(Page)) + cap, DT_ALLOC_PERM);
+			if (!page)
+				return 0;
+			page->next = 0;
+			page->capacity = cap;
+			page->top = 0;
+
+			if (first)
+			{
+				Page* last = first;
+				while (last->next)
+					last = last->next;
+				last->next = page;
+			}
+			else
+				first = page;
+
+			capacity += cap;
+			current = page;
+		}
+
+		unsigned char* mem = getPageData(current) + current->top;
+		current->top += asize;
+		used += asize;
 		return mem;
 	}
 
@@ -82,9 +170,39 @@ struct LinearAllocator : public dtTileCacheAlloc
 	{
 		// Empty
 	}
+
+	static LinearAllocator* create(const size_t initialPageSize)
+	{
+		void* mem = dtAlloc(sizeof(LinearAllocator), DT_ALLOC_PERM);
+		if (!mem)
+			return 0;
+		return new(mem) LinearAllocator(initialPageSize);
+	}
+
+	static void destroy(LinearAllocator* allocator)
+	{
+		if (!allocator)
+			return;
+		allocator->~LinearAllocator();
+		dtFree(allocator);
+	}
 };
 
-LinearAllocator LinearAllocator::instance(32000);
+// The obstacle capacity of tile caches built by handleBuild.
+static const int DEFAULT_MAX_OBSTACLES = 128;
+
+// The initial page size of the tile cache allocators.
+static const size_t TILECACHE_ALLOC_PAGE_SIZE = 32000;
+
+// Frees a tile cache created by this library along with its allocator.
+static void freeTileCache(dtTileCache* tileCache)
+{
+	if (!tileCache)
+		return;
+	LinearAllocator* allocator = (LinearAllocator*)tileCache->getAlloc();
+	dtFreeTileCache(tileCache);
+	LinearAllocator::destroy(allocator);
+}
 
 struct MeshProcess : public dtTileCacheMeshProcess
 {
@@ -108,6 +226,667 @@ struct TileCacheData
 	int dataSize;
 };
 
+typedef bool (*BuildTileCacheLayerFunc)(
+	int tx, int ty, int i,
+	const float *bmin, const float *bmax,
+	int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
+	unsigned char *heights, unsigned char *areas, unsigned char *cons,
+	TileCacheData *tile);
+
+typedef dtStatus (*RasterizeTileLayersFunc)(
+	void *pCtx,
+	int tx, int ty,
+	rcConfig *cfg,
+	TileCacheData* tiles, int maxTiles,
+	float *verts, int nverts,
+	rcChunkyTriMesh *chunkyMesh,
+	bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+	BuildTileCacheLayerFunc buildTileCacheLayer);
+
+// Note: Keep this layout in sync with the definition in NMGen.h.
+// rasterizeTileLayers returns -1 if the tile could not be built.
+// (pCtx is an nmgBuildContext, which this library does not see.)
+struct TileRasterizer
+{
+	void* (*allocContext)();
+	void (*freeContext)(void* rc);
+	int (*rasterizeTileLayers)(
+		void *pCtx, void *rc,
+		int tx, int ty,
+		rcConfig *cfg,
+		TileCacheData* tiles, int maxTiles,
+		float *verts, int nverts,
+		rcChunkyTriMesh *chunkyMesh,
+		bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+		BuildTileCacheLayerFunc buildTileCacheLayer);
+};
+
+// The layers produced for a single tile grid cell.
+struct RasterizedTile
+{
+	TileCacheData layers[MAX_LAYERS];
+	int nlayers;
+};
+
+// Gets the xz-bounds of a tile, including its border, the same way the
+// rasterizer does.
+static void calcTileBounds(const rcConfig& cfg, const int tx, const int ty
+	, float* tbmin, float* tbmax)
+{
+	const float tcs = cfg.tileSize * cfg.cs;
+	tbmin[0] = cfg.bmin[0] + tx * tcs;
+	tbmin[1] = cfg.bmin[2] + ty * tcs;
+	tbmax[0] = cfg.bmin[0] + (tx + 1)*tcs;
+	tbmax[1] = cfg.bmin[2] + (ty + 1)*tcs;
+	tbmin[0] -= cfg.borderSize*cfg.cs;
+	tbmin[1] -= cfg.borderSize*cfg.cs;
+	tbmax[0] += cfg.borderSize*cfg.cs;
+	tbmax[1] += cfg.borderSize*cfg.cs;
+}
+
+inline bool overlapRect(const float* amin, const float* amax
+	, const float* bmin, const float* bmax)
+{
+	return !(amin[0] > bmax[0] || amax[0] < bmin[0]
+		|| amin[1] > bmax[1] || amax[1] < bmin[1]);
+}
+
+// The input geometry of a streamed build.
+//
+// A chunk is loaded by the first tile that overlaps it and freed once every
+// tile that overlaps it has copied out its triangles.  Tiles are handed out
+// in row order, so only a band of rows worth of chunks is loaded at a time.
+struct GeomChunkCache
+{
+	enum State
+	{
+		CHUNK_UNLOADED,
+		CHUNK_LOADING,
+		CHUNK_LOADED,
+		CHUNK_FAILED,
+	};
+
+	struct Entry
+	{
+		float* verts;
+		int* tris;
+		int tilesLeft;
+		State state;
+	};
+
+	const rcnGeomSource* source;
+	std::vector<Entry> entries;
+
+	// The chunks that overlap each tile, in chunk order.
+	std::vector<int> tileChunkStart;	// [Size: ntiles + 1]
+	std::vector<int> tileChunks;
+
+	std::mutex lock;
+	std::condition_variable loaded;
+	long long residentSize;
+	long long peakSize;
+	int loads;
+
+	GeomChunkCache()
+		: source(0), residentSize(0), peakSize(0), loads(0)
+	{
+	}
+
+	~GeomChunkCache()
+	{
+		for (size_t i = 0; i < entries.size(); ++i)
+			freeEntry(entries[i]);
+	}
+
+	static long long getChunkSize(const rcnGeomChunk& chunk)
+	{
+		return (long long)chunk.nverts*3*sizeof(float) + (long long)chunk.ntris*3*sizeof(int);
+	}
+
+	void freeEntry(Entry& entry)
+	{
+		dtFree(entry.verts);
+		dtFree(entry.tris);
+		entry.verts = 0;
+		entry.tris = 0;
+	}
+
+	bool init(const rcnGeomSource* src, const rcConfig& cfg, const int tw, const int th)
+	{
+		source = src;
+		entries.resize(src->nchunks);
+
+		// Count, then list, the tiles each chunk overlaps.
+		const float tcs = cfg.tileSize * cfg.cs;
+		const float border = cfg.borderSize * cfg.cs;
+		tileChunkStart.assign(tw*th + 1, 0);
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			std::vector<int> fill;
+			if (pass == 1)
+			{
+				for (int t = 0; t < tw*th; ++t)
+					tileChunkStart[t + 1] += tileChunkStart[t];
+				tileChunks.resize(tileChunkStart[tw*th]);
+				fill.assign(tileChunkStart.begin(), tileChunkStart.end() - 1);
+			}
+
+			for (int i = 0; i < src->nchunks; ++i)
+			{
+				const rcnGeomChunk& chunk = src->chunks[i];
+				const float cmin[2] = { chunk.bmin[0], chunk.bmin[2] };
+				const float cmax[2] = { chunk.bmax[0], chunk.bmax[2] };
+
+				// Conservative tile range, refined by the exact tile bounds test.
+				const int tx0 = dtClamp((int)floorf((cmin[0] - cfg.bmin[0] - border) / tcs) - 1, 0, tw - 1);
+				const int tx1 = dtClamp((int)floorf((cmax[0] - cfg.bmin[0] + border) / tcs) + 1, 0, tw - 1);
+				const int ty0 = dtClamp((int)floorf((cmin[1] - cfg.bmin[2] - border) / tcs) - 1, 0, th - 1);
+				const int ty1 = dtClamp((int)floorf((cmax[1] - cfg.bmin[2] + border) / tcs) + 1, 0, th - 1);
+
+				int tiles = 0;
+				for (int ty = ty0; ty <= ty1; ++ty)
+				{
+					for (int tx = tx0; tx <= tx1; ++tx)
+					{
+						float tbmin[2], tbmax[2];
+						calcTileBounds(cfg, tx, ty, tbmin, tbmax);
+						if (!overlapRect(cmin, cmax, tbmin, tbmax))
+							continue;
+
+						const int t = tx + ty*tw;
+						if (pass == 0)
+							tileChunkStart[t + 1]++;
+						else
+							tileChunks[fill[t]++] = i;
+						tiles++;
+					}
+				}
+
+				Entry& entry = entries[i];
+				entry.verts = 0;
+				entry.tris = 0;
+				entry.tilesLeft = tiles;
+				entry.state = CHUNK_UNLOADED;
+			}
+		}
+
+		return true;
+	}
+
+	// Gets a loaded chunk, loading it if needed.  Returns null on failure.
+	const Entry* acquire(const int chunk)
+	{
+		Entry& entry = entries[chunk];
+		const rcnGeomChunk& info = source->chunks[chunk];
+
+		std::unique_lock<std::mutex> guard(lock);
+		loaded.wait(guard, [&entry] { return entry.state != CHUNK_LOADING; });
+		if (entry.state == CHUNK_LOADED)
+			return &entry;
+		if (entry.state == CHUNK_FAILED)
+			return 0;
+
+		entry.state = CHUNK_LOADING;
+		guard.unlock();
+
+		// Load outside the lock so other threads can keep working.
+		entry.verts = (float*)dtAlloc(sizeof(float)*3*info.nverts, DT_ALLOC_TEMP);
+		entry.tris = (int*)dtAlloc(sizeof(int)*3*info.ntris, DT_ALLOC_TEMP);
+		const bool ok = entry.verts && entry.tris
+			&& source->loadChunk(source->user, chunk, entry.verts, entry.tris);
+
+		guard.lock();
+		if (ok)
+		{
+			entry.state = CHUNK_LOADED;
+			loads++;
+			residentSize += getChunkSize(info);
+			peakSize = dtMax(peakSize, residentSize);
+		}
+		else
+		{
+			entry.state = CHUNK_FAILED;
+			freeEntry(entry);
+		}
+		guard.unlock();
+		loaded.notify_all();
+
+		return ok ? &entry : 0;
+	}
+
+	// Call once a tile is done with an acquired chunk.
+	void release(const int chunk)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		Entry& entry = entries[chunk];
+		if (--entry.tilesLeft == 0 && entry.state == CHUNK_LOADED)
+		{
+			freeEntry(entry);
+			entry.state = CHUNK_UNLOADED;
+			residentSize -= getChunkSize(source->chunks[chunk]);
+		}
+	}
+};
+
+// The geometry of a single tile of a streamed build, gathered from the
+// chunks that overlap it.  The mesh is a single node over the whole tile.
+struct TileGeomBuffer
+{
+	std::vector<float> verts;
+	std::vector<int> tris;
+	rcChunkyTriMeshNode node;
+	rcChunkyTriMesh mesh;
+
+	~TileGeomBuffer()
+	{
+		// The mesh only borrows its arrays.
+		mesh.nodes = 0;
+		mesh.tris = 0;
+	}
+
+	// Copies the triangles that overlap the tile.  Returns false if a chunk
+	// could not be loaded.
+	bool gather(GeomChunkCache& cache, const rcConfig& cfg, const int tx, const int ty, const int tile)
+	{
+		float tbmin[2], tbmax[2];
+		calcTileBounds(cfg, tx, ty, tbmin, tbmax);
+
+		verts.clear();
+		tris.clear();
+
+		bool ok = true;
+		for (int i = cache.tileChunkStart[tile]; i < cache.tileChunkStart[tile + 1]; ++i)
+		{
+			const int chunk = cache.tileChunks[i];
+			const GeomChunkCache::Entry* entry = ok ? cache.acquire(chunk) : 0;
+			if (!entry)
+			{
+				// Still release, so the chunk's other tiles see the right count.
+				ok = false;
+				cache.release(chunk);
+				continue;
+			}
+
+			const rcnGeomChunk& info = cache.source->chunks[chunk];
+			const int vbase = (int)verts.size() / 3;
+			const size_t tbase = tris.size();
+			for (int j = 0; j < info.ntris; ++j)
+			{
+				const int* t = &entry->tris[j*3];
+				const float* va = &entry->verts[t[0]*3];
+				const float* vb = &entry->verts[t[1]*3];
+				const float* vc = &entry->verts[t[2]*3];
+				const float bmin[2] = { dtMin(va[0], dtMin(vb[0], vc[0])), dtMin(va[2], dtMin(vb[2], vc[2])) };
+				const float bmax[2] = { dtMax(va[0], dtMax(vb[0], vc[0])), dtMax(va[2], dtMax(vb[2], vc[2])) };
+				if (!overlapRect(bmin, bmax, tbmin, tbmax))
+					continue;
+				tris.push_back(vbase + t[0]);
+				tris.push_back(vbase + t[1]);
+				tris.push_back(vbase + t[2]);
+			}
+			if (tris.size() > tbase)
+				verts.insert(verts.end(), entry->verts, entry->verts + info.nverts*3);
+
+			cache.release(chunk);
+		}
+
+		node.bmin[0] = tbmin[0];
+		node.bmin[1] = tbmin[1];
+		node.bmax[0] = tbmax[0];
+		node.bmax[1] = tbmax[1];
+		node.i = 0;
+		node.n = (int)tris.size() / 3;
+
+		mesh.nodes = &node;
+		mesh.nnodes = 1;
+		mesh.tris = tris.empty() ? 0 : &tris[0];
+		mesh.ntris = node.n;
+		mesh.maxTrisPerChunk = node.n;
+
+		return ok;
+	}
+};
+
+static inline unsigned long long hashWords(unsigned long long h, const void* data, const size_t size)
+{
+	// FNV-1a over 32-bit words.  Everything hashed here is made of 32-bit fields.
+	// (memcpy keeps the float loads legal under strict aliasing.)
+	const unsigned char* p = (const unsigned char*)data;
+	const size_t n = size / 4;
+	for (size_t i = 0; i < n; ++i)
+	{
+		unsigned int w;
+		memcpy(&w, p + i*4, sizeof(w));
+		h ^= w;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+// The input hash and layers of every tile from the previous bake.
+//
+// A tile's hash covers the build settings, its bounds, and the triangles the
+// rasterizer will see for it.  (The same chunky mesh query.)  The bounds are
+// in world space and the settings leave out the world bounds, so growing the
+// world only rebuilds the tiles that see new geometry.  Previous tiles are
+// found by hash rather than by grid cell for the same reason.  A rebake only
+// rasterizes the tiles whose hash changed and copies the stored layers for the
+// rest.  The manifest is rewritten after every build that succeeds.
+struct BakeManifest
+{
+	static const int MAGIC = 'R'<<24 | 'C'<<16 | 'B'<<8 | 'M';
+	static const int VERSION = 2;
+
+	struct Header
+	{
+		int magic;
+		int version;
+		int tileCount;
+		unsigned long long configHash;
+	};
+
+	struct Tile
+	{
+		unsigned long long hash;
+		int tx;
+		int ty;
+		int firstLayer;
+		int nlayers;
+	};
+
+	struct Layer
+	{
+		const unsigned char* data;
+		int dataSize;
+	};
+
+	std::vector<unsigned char> file;
+	std::vector<Tile> tiles;	// Sorted by hash.  (Empty if there is no usable previous bake.)
+	std::vector<Layer> layers;
+
+	static bool compareHash(const Tile& tile, const unsigned long long hash)
+	{
+		return tile.hash < hash;
+	}
+
+	static bool lessHash(const Tile& a, const Tile& b)
+	{
+		return a.hash < b.hash;
+	}
+
+	static unsigned long long hashConfig(const rcConfig& cfg, const int compression
+		, const bool filterLowHangingObstacles, const bool filterLedgeSpans
+		, const bool filterWalkableLowHeightSpans)
+	{
+		// Note: The config is zeroed before it is filled in, so its padding
+		// is stable.  The world bounds are left out.  (See hashTile.)
+		rcConfig tcfg;
+		memcpy(&tcfg, &cfg, sizeof(tcfg));
+		memset(tcfg.bmin, 0, sizeof(tcfg.bmin));
+		memset(tcfg.bmax, 0, sizeof(tcfg.bmax));
+
+		const int options[5] = { DT_TILECACHE_VERSION, compression
+			, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans };
+		unsigned long long h = 14695981039346656037ULL;
+		h = hashWords(h, &tcfg, sizeof(tcfg));
+		return hashWords(h, options, sizeof(options));
+	}
+
+	// Returns false if the tile's triangles index past the vertices.
+	static bool hashTile(const unsigned long long configHash, const rcConfig& cfg
+		, const float* verts, const int nverts, const rcChunkyTriMesh* chunkyMesh
+		, const int tx, const int ty, unsigned long long* hash)
+	{
+		float tbmin[2], tbmax[2];
+		calcTileBounds(cfg, tx, ty, tbmin, tbmax);
+		int cid[512];	// Same limit as the rasterizer.
+		const int ncid = rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid, 512);
+
+		// Only the triangles that touch the tile count, and they are combined
+		// in an order independent way.  Adding geometry elsewhere changes the
+		// chunk partitioning and the triangle indices, but not this tile.
+		unsigned long long sum = 0;
+		for (int i = 0; i < ncid; ++i)
+		{
+			if (!rcCheckChunkyTriMeshChunk(chunkyMesh, cid[i], nverts))
+				return false;
+
+			const rcChunkyTriMeshNode& node = chunkyMesh->nodes[cid[i]];
+			for (int j = 0; j < node.n; ++j)
+			{
+				const int* t = &chunkyMesh->tris[(node.i + j)*3];
+				float tri[9];
+				dtVcopy(&tri[0], &verts[t[0]*3]);
+				dtVcopy(&tri[3], &verts[t[1]*3]);
+				dtVcopy(&tri[6], &verts[t[2]*3]);
+
+				float bmin[2] = { tri[0], tri[2] };
+				float bmax[2] = { tri[0], tri[2] };
+				for (int k = 1; k < 3; ++k)
+				{
+					bmin[0] = dtMin(bmin[0], tri[k*3+0]);
+					bmin[1] = dtMin(bmin[1], tri[k*3+2]);
+					bmax[0] = dtMax(bmax[0], tri[k*3+0]);
+					bmax[1] = dtMax(bmax[1], tri[k*3+2]);
+				}
+				if (!overlapRect(bmin, bmax, tbmin, tbmax))
+					continue;
+
+				// Finish with a 64-bit mix so the sum doesn't cancel out
+				// small differences.
+				unsigned long long h = hashWords(14695981039346656037ULL, tri, sizeof(tri));
+				h ^= h >> 33;
+				h *= 0xff51afd7ed558ccdULL;
+				h ^= h >> 33;
+				h *= 0xc4ceb9fe1a85ec53ULL;
+				h ^= h >> 33;
+				sum += h;
+			}
+		}
+
+		// The heightfield of the tile spans the full height of the world.
+		const float bounds[6] = { tbmin[0], cfg.bmin[1], tbmin[1], tbmax[0], cfg.bmax[1], tbmax[1] };
+		const unsigned long long h = hashWords(configHash, bounds, sizeof(bounds));
+		*hash = hashWords(h, &sum, sizeof(sum));
+		return true;
+	}
+
+	// Loads the previous bake.  Leaves the manifest empty if there is none or
+	// it was baked with different settings.
+	void load(const char* path, const unsigned long long configHash)
+	{
+		FILE* fp = fopen(path, "rb");
+		if (!fp)
+			return;
+
+		bool ok = fseek(fp, 0, SEEK_END) == 0;
+		const long size = ok ? ftell(fp) : -1;
+		ok = size >= (long)sizeof(Header) && fseek(fp, 0, SEEK_SET) == 0;
+		if (ok)
+		{
+			file.resize(size);
+			ok = fread(&file[0], 1, size, fp) == (size_t)size;
+		}
+		fclose(fp);
+
+		// Note: The layers point into the file buffer.
+		if (!ok || !parse(configHash))
+		{
+			file.clear();
+			tiles.clear();
+			layers.clear();
+		}
+	}
+
+	bool parse(const unsigned long long configHash)
+	{
+		Header header;
+		memcpy(&header, &file[0], sizeof(header));
+		if (header.magic != MAGIC || header.version != VERSION
+			|| header.configHash != configHash || header.tileCount < 0)
+		{
+			return false;
+		}
+
+		// Tile records follow the header: hash, grid cell, layer count, then
+		// each layer's size and data.
+		const size_t recordSize = sizeof(unsigned long long) + sizeof(int)*3;
+		size_t pos = sizeof(header);
+		const size_t end = file.size();
+		tiles.resize(header.tileCount);
+		for (int t = 0; t < header.tileCount; ++t)
+		{
+			Tile& tile = tiles[t];
+			if (end - pos < recordSize)
+				return false;
+			memcpy(&tile.hash, &file[pos], sizeof(tile.hash));
+			pos += sizeof(tile.hash);
+			memcpy(&tile.tx, &file[pos], sizeof(int));
+			memcpy(&tile.ty, &file[pos + sizeof(int)], sizeof(int));
+			memcpy(&tile.nlayers, &file[pos + sizeof(int)*2], sizeof(int));
+			pos += sizeof(int)*3;
+			if (tile.nlayers < 0 || tile.nlayers > MAX_LAYERS)
+				return false;
+
+			tile.firstLayer = (int)layers.size();
+			for (int i = 0; i < tile.nlayers; ++i)
+			{
+				Layer layer;
+				if (end - pos < sizeof(int))
+					return false;
+				memcpy(&layer.dataSize, &file[pos], sizeof(int));
+				pos += sizeof(int);
+				if (layer.dataSize < (int)sizeof(dtTileCacheLayerHeader)
+					|| end - pos < (size_t)layer.dataSize)
+				{
+					return false;
+				}
+				layer.data = &file[pos];
+				pos += layer.dataSize;
+
+				// The layers go straight into the tile cache, so at least
+				// make sure they are layers of this tile.
+				dtTileCacheLayerHeader lh;
+				memcpy(&lh, layer.data, sizeof(lh));
+				if (lh.magic != DT_TILECACHE_MAGIC || lh.version != DT_TILECACHE_VERSION
+					|| lh.tx != tile.tx || lh.ty != tile.ty)
+				{
+					return false;
+				}
+
+				layers.push_back(layer);
+			}
+		}
+
+		std::sort(tiles.begin(), tiles.end(), lessHash);
+
+		return pos == end;
+	}
+
+	// Copies the previous layers of a tile if its input hash is unchanged.
+	// The copies are owned by the tile, the same as rasterized layers.  They
+	// are moved to the tile's cell, which shifts if the world grows toward
+	// its minimum.
+	bool reuse(const int tx, const int ty, const unsigned long long hash, RasterizedTile* tile) const
+	{
+		std::vector<Tile>::const_iterator it =
+			std::lower_bound(tiles.begin(), tiles.end(), hash, compareHash);
+		if (it == tiles.end() || it->hash != hash)
+			return false;
+
+		const Tile& prev = *it;
+		for (int i = 0; i < prev.nlayers; ++i)
+		{
+			const Layer& layer = layers[prev.firstLayer + i];
+			unsigned char* data = (unsigned char*)dtAlloc(layer.dataSize, DT_ALLOC_PERM);
+			if (!data)
+			{
+				for (int j = 0; j < i; ++j)
+				{
+					dtFree(tile->layers[j].data);
+					tile->layers[j].data = 0;
+				}
+				return false;
+			}
+			memcpy(data, layer.data, layer.dataSize);
+
+			dtTileCacheLayerHeader lh;
+			memcpy(&lh, data, sizeof(lh));
+			lh.tx = tx;
+			lh.ty = ty;
+			memcpy(data, &lh, sizeof(lh));
+
+			tile->layers[i].data = data;
+			tile->layers[i].dataSize = layer.dataSize;
+		}
+		tile->nlayers = prev.nlayers;
+
+		return true;
+	}
+
+	static bool save(const char* path, const int tw, const int th, const unsigned long long configHash
+		, const unsigned long long* hashes, const RasterizedTile* results)
+	{
+		FILE* fp = fopen(path, "wb");
+		if (!fp)
+			return false;
+
+		Header header;
+		memset(&header, 0, sizeof(header));
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.tileCount = tw*th;
+		header.configHash = configHash;
+
+		bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+		for (int t = 0; ok && t < tw*th; ++t)
+		{
+			const RasterizedTile& tile = results[t];
+			const int cell[2] = { t % tw, t / tw };
+			ok = fwrite(&hashes[t], sizeof(hashes[t]), 1, fp) == 1
+				&& fwrite(cell, sizeof(cell), 1, fp) == 1
+				&& fwrite(&tile.nlayers, sizeof(int), 1, fp) == 1;
+			for (int i = 0; ok && i < tile.nlayers; ++i)
+			{
+				ok = fwrite(&tile.layers[i].dataSize, sizeof(int), 1, fp) == 1
+					&& fwrite(tile.layers[i].data, tile.layers[i].dataSize, 1, fp) == 1;
+			}
+		}
+		ok = fclose(fp) == 0 && ok;
+
+		// A partial manifest would only be rejected next time.
+		if (!ok)
+			remove(path);
+
+		return ok;
+	}
+};
+
+// Shared state for the tile rasterization workers.
+struct TileRasterizeJob
+{
+	void *pCtx;
+	const TileRasterizer* rasterizer;
+	rcConfig* cfg;
+	float* verts;
+	int nverts;
+	rcChunkyTriMesh* chunkyMesh;
+	bool filterLowHangingObstacles;
+	bool filterLedgeSpans;
+	bool filterWalkableLowHeightSpans;
+	BuildTileCacheLayerFunc buildTileCacheLayer;
+	GeomChunkCache* geom;	// Streamed builds only.
+	const BakeManifest* manifest;	// Incremental builds only.
+	unsigned long long configHash;
+	unsigned long long* hashes;		// The input hash of each tile.  (Incremental builds only.)
+	std::atomic<int> reused;
+	int tw;
+	int ntiles;
+	RasterizedTile* results;
+	std::atomic<int> next;
+	std::atomic<bool> failed;
+};
+
 static int calcLayerBufferSize(const int gridWidth, const int gridHeight)
 {
 	const int headerSize = dtAlign4(sizeof(dtTileCacheLayerHeader));
@@ -115,7 +894,8 @@ static int calcLayerBufferSize(const int gridWidth, const int gridHeight)
 	return headerSize + gridSize * 4;
 }
 
-bool buildTileCacheLayer(
+static bool buildTileCacheLayer(
+	dtTileCacheCompressor* compressor,
 	int tx, int ty, int i,
 	const float *bmin, const float *bmax,
 	int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
@@ -144,7 +924,7 @@ bool buildTileCacheLayer(
 	header.hmax = (unsigned short)/*layer->*/hmax;
 
 	dtStatus status = dtBuildTileCacheLayer(
-		&Compressor::instance,
+		compressor,
 		&header,
 		/*layer->*/heights, /*layer->*/areas, /*layer->*/cons,
 		&tile->data, &tile->dataSize);
@@ -155,7 +935,111 @@ bool buildTileCacheLayer(
 	return true;
 }
 
-dtStatus handleBuild(
+bool buildTileCacheLayer(
+	int tx, int ty, int i,
+	const float *bmin, const float *bmax,
+	int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
+	unsigned char *heights, unsigned char *areas, unsigned char *cons,
+	TileCacheData *tile)
+{
+	return buildTileCacheLayer(&Compressor::instance
+		, tx, ty, i, bmin, bmax
+		, width, height, minx, maxx, miny, maxy, hmin, hmax
+		, heights, areas, cons, tile);
+}
+
+static bool buildTileCacheLayerLZ(
+	int tx, int ty, int i,
+	const float *bmin, const float *bmax,
+	int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
+	unsigned char *heights, unsigned char *areas, unsigned char *cons,
+	TileCacheData *tile)
+{
+	return buildTileCacheLayer(&LZCompressor::instance
+		, tx, ty, i, bmin, bmax
+		, width, height, minx, maxx, miny, maxy, hmin, hmax
+		, heights, areas, cons, tile);
+}
+
+static void rasterizeTileWorker(TileRasterizeJob* job)
+{
+	void* rc = job->rasterizer->allocContext();
+	TileGeomBuffer* geom = job->geom ? new(std::nothrow) TileGeomBuffer() : 0;
+	if (!rc || (job->geom && !geom))
+	{
+		job->failed = true;
+		if (rc)
+			job->rasterizer->freeContext(rc);
+		return;
+	}
+
+	while (!job->failed)
+	{
+		// Tiles are handed out in row order, so neighbouring workers tend to
+		// touch the same chunky mesh nodes.
+		const int idx = job->next.fetch_add(1);
+		if (idx >= job->ntiles)
+			break;
+
+		const int tx = idx % job->tw;
+		const int ty = idx / job->tw;
+
+		float* verts = job->verts;
+		int nverts = job->nverts;
+		rcChunkyTriMesh* chunkyMesh = job->chunkyMesh;
+		if (geom)
+		{
+			if (!geom->gather(*job->geom, *job->cfg, tx, ty, idx))
+			{
+				job->failed = true;
+				break;
+			}
+			if (!geom->mesh.ntris)
+				continue;
+			verts = &geom->verts[0];
+			nverts = (int)geom->verts.size() / 3;
+			chunkyMesh = &geom->mesh;
+		}
+
+		RasterizedTile* tile = &job->results[idx];
+		if (job->manifest)
+		{
+			unsigned long long hash;
+			if (!BakeManifest::hashTile(job->configHash, *job->cfg
+				, verts, nverts, chunkyMesh, tx, ty, &hash))
+			{
+				job->failed = true;
+				break;
+			}
+			job->hashes[idx] = hash;
+			if (job->manifest->reuse(tx, ty, hash, tile))
+			{
+				job->reused++;
+				continue;
+			}
+		}
+
+		const int nlayers = job->rasterizer->rasterizeTileLayers(job->pCtx, rc
+			, tx, ty
+			, job->cfg, tile->layers, MAX_LAYERS
+			, verts, nverts, chunkyMesh
+			, job->filterLowHangingObstacles, job->filterLedgeSpans, job->filterWalkableLowHeightSpans
+			, job->buildTileCacheLayer);
+		if (nlayers < 0)
+		{
+			// Not the same as an empty tile.  The build fails, so nothing
+			// about this tile is saved to the manifest.
+			job->failed = true;
+			break;
+		}
+		tile->nlayers = nlayers;
+	}
+
+	delete geom;
+	job->rasterizer->freeContext(rc);
+}
+
+static dtStatus buildTileCache(
 	void *pCtx,
 	float *verts, int nverts, int vertsPerPoly,
 	int *tris, int ntris, int trisPerChunk,
@@ -168,20 +1052,10 @@ dtStatus handleBuild(
 	float regionMinSize, float regionMergeSize,
 	float detailSampleDist, float detailSampleMaxError,
 	dtTileCache **pTileCache, dtNavMesh **pNavMesh, dtNavMeshQuery **pNavQuery,
-	dtStatus (*rasterizeTileLayers)(
-		void *pCtx,
-		int tx, int ty,
-		rcConfig *cfg,
-		TileCacheData* tiles, int maxTiles,
-		float *verts, int nverts,
-		rcChunkyTriMesh *chunkyMesh,
-		bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
-		bool (*buildTileCacheLayer)(
-			int tx, int ty, int i,
-			const float *bmin, const float *bmax,
-			int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
-			unsigned char *heights, unsigned char *areas, unsigned char *cons,
-			TileCacheData *tile)))
+	RasterizeTileLayersFunc rasterizeTileLayers,
+	const TileRasterizer* rasterizer, int threadCount,
+	int maxObstacles, int compression, rcnTileCacheBuildStats* stats,
+	const rcnGeomSource* source, const char* chunkyMeshCachePath, const char* manifestPath)
 {
 	/*
 	if (!m_geom || !m_geom->getMesh())
@@ -222,19 +1096,36 @@ dtStatus handleBuild(
 	tcparams.walkableClimb = agentMaxClimb;
 	tcparams.maxSimplificationError = edgeMaxError;
 	tcparams.maxTiles = tw * th*EXPECTED_LAYERS_PER_TILE;
-	tcparams.maxObstacles = 128;
+	tcparams.maxObstacles = maxObstacles;
+
+	dtTileCacheCompressor* compressor = &Compressor::instance;
+	BuildTileCacheLayerFunc buildLayer = buildTileCacheLayer;
+	if (compression == RCN_TILECACHE_COMPRESSION_LZ)
+	{
+		compressor = &LZCompressor::instance;
+		buildLayer = buildTileCacheLayerLZ;
+	}
+	else if (compression != RCN_TILECACHE_COMPRESSION_NONE)
+		return DT_FAILURE | DT_INVALID_PARAM;
 
-	dtFreeTileCache(*pTileCache);
+	freeTileCache(*pTileCache);
+	*pTileCache = 0;
+
+	LinearAllocator* talloc = LinearAllocator::create(TILECACHE_ALLOC_PAGE_SIZE);
+	if (!talloc)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
 
 	*pTileCache = dtAllocTileCache();
 	dtTileCache *tileCache = *pTileCache;
 	if (!tileCache)
 	{
 		//m_ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not allocate tile cache.");
+		LinearAllocator::destroy(talloc);
 		return DT_FAILURE | DT_OUT_OF_MEMORY;
 	}
 
-	dtStatus status = tileCache->init(&tcparams, &LinearAllocator::instance, &Compressor::instance, &MeshProcess::instance);
+	// Note: The tile cache owns the allocator from here on.  (See freeTileCache.)
+	dtStatus status = tileCache->init(&tcparams, talloc, compressor, &MeshProcess::instance);
 	if (dtStatusFailed(status))
 	{
 		//m_ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Could not init tile cache.");
@@ -311,22 +1202,124 @@ dtStatus handleBuild(
 	int cacheCompressedSize = 0;
 	int cacheRawSize = 0;
 
+	// Streamed builds never see the whole mesh.  Each tile gathers its own
+	// triangles from the chunks that overlap it.
 	rcChunkyTriMesh chunkyTriMesh;
-	if (!rcCreateChunkyTriMesh(verts, tris, ntris, trisPerChunk, &chunkyTriMesh)) {
+	bool chunkyMeshMapped = false;
+	int tilesReused = 0;
+	GeomChunkCache geomCache;
+	if (source)
+	{
+		if (!rasterizer)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		geomCache.init(source, cfg, tw, th);
+	}
+	else if (chunkyMeshCachePath)
+	{
+		// Partitioning a large mesh is a noticeable part of a rebake, and
+		// the input rarely changes between bakes.  Map the previous result
+		// when the input still matches.  Failing to save just costs the next
+		// build the same partitioning again.
+		const unsigned long long inputHash =
+			rcHashChunkyTriMeshInput(verts, nverts, tris, ntris, trisPerChunk);
+		chunkyMeshMapped = rcMapChunkyTriMesh(chunkyMeshCachePath, inputHash, &chunkyTriMesh);
+		if (!chunkyMeshMapped)
+		{
+			if (!rcCreateChunkyTriMesh(verts, tris, ntris, trisPerChunk, &chunkyTriMesh))
+				return DT_FAILURE;
+			rcSaveChunkyTriMesh(&chunkyTriMesh, inputHash, chunkyMeshCachePath);
+		}
+	}
+	else if (!rcCreateChunkyTriMesh(verts, tris, ntris, trisPerChunk, &chunkyTriMesh)) {
 		return DT_FAILURE;
 	}
 
-	for (int y = 0; y < th; ++y)
+	if (rasterizer)
 	{
-		for (int x = 0; x < tw; ++x)
+		// Rasterize the tiles on the worker threads, then commit the layers
+		// to the tile cache in grid order so the result does not depend on
+		// the thread schedule.
+		const int ntiles = tw * th;
+		RasterizedTile* results = (RasterizedTile*)dtAlloc(sizeof(RasterizedTile)*ntiles, DT_ALLOC_TEMP);
+		if (!results)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		memset(results, 0, sizeof(RasterizedTile)*ntiles);
+
+		TileRasterizeJob job;
+		job.pCtx = pCtx;
+		job.rasterizer = rasterizer;
+		job.cfg = &cfg;
+		job.verts = verts;
+		job.nverts = nverts;
+		job.chunkyMesh = &chunkyTriMesh;
+		job.filterLowHangingObstacles = filterLowHangingObstacles;
+		job.filterLedgeSpans = filterLedgeSpans;
+		job.filterWalkableLowHeightSpans = filterWalkableLowHeightSpans;
+		job.buildTileCacheLayer = buildLayer;
+		job.geom = source ? &geomCache : 0;
+		job.manifest = 0;
+		job.configHash = 0;
+		job.hashes = 0;
+		job.reused = 0;
+		job.tw = tw;
+		job.ntiles = ntiles;
+		job.results = results;
+		job.next = 0;
+		job.failed = false;
+
+		// Streamed builds never hold the whole mesh, so they can't hash
+		// tiles up front.  They always rebuild everything.
+		BakeManifest manifest;
+		std::vector<unsigned long long> hashes;
+		if (manifestPath && !source)
 		{
-			TileCacheData tiles[MAX_LAYERS];
-			memset(tiles, 0, sizeof(tiles));
-			int ntiles = rasterizeTileLayers(pCtx, x, y, &cfg, tiles, MAX_LAYERS, verts, nverts, &chunkyTriMesh, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans, buildTileCacheLayer);
+			job.configHash = BakeManifest::hashConfig(cfg, compression
+				, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans);
+			manifest.load(manifestPath, job.configHash);
+			hashes.resize(ntiles);
+			job.manifest = &manifest;
+			job.hashes = &hashes[0];
+		}
+
+		if (threadCount <= 0)
+			threadCount = (int)std::thread::hardware_concurrency();
+		threadCount = dtClamp(threadCount, 1, ntiles > 0 ? ntiles : 1);
+
+		// The calling thread acts as one of the workers.
+		std::vector<std::thread> workers;
+		for (int i = 1; i < threadCount; ++i)
+			workers.push_back(std::thread(rasterizeTileWorker, &job));
+		rasterizeTileWorker(&job);
+		for (size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();
+
+		if (job.failed)
+		{
+			// The mapped mesh may be what failed.  Partition the input
+			// again next time.
+			if (chunkyMeshMapped)
+				remove(chunkyMeshCachePath);
+
+			for (int t = 0; t < ntiles; ++t)
+			{
+				for (int i = 0; i < results[t].nlayers; ++i)
+					dtFree(results[t].layers[i].data);
+			}
+			dtFree(results);
+			return DT_FAILURE;
+		}
+
+		// Save before the layers are handed to the tile cache.  A failed
+		// save just means a full rebuild next time.
+		if (job.manifest)
+			BakeManifest::save(manifestPath, tw, th, job.configHash, job.hashes, results);
+		tilesReused = job.reused;
 
-			for (int i = 0; i < ntiles; ++i)
+		for (int t = 0; t < ntiles; ++t)
+		{
+			for (int i = 0; i < results[t].nlayers; ++i)
 			{
-				TileCacheData* tile = &tiles[i];
+				TileCacheData* tile = &results[t].layers[i];
 				status = tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);
 				if (dtStatusFailed(status))
 				{
@@ -340,6 +1333,36 @@ dtStatus handleBuild(
 				cacheRawSize += calcLayerBufferSize(tcparams.width, tcparams.height);
 			}
 		}
+
+		dtFree(results);
+	}
+	else
+	{
+		for (int y = 0; y < th; ++y)
+		{
+			for (int x = 0; x < tw; ++x)
+			{
+				TileCacheData tiles[MAX_LAYERS];
+				memset(tiles, 0, sizeof(tiles));
+				int ntiles = rasterizeTileLayers(pCtx, x, y, &cfg, tiles, MAX_LAYERS, verts, nverts, &chunkyTriMesh, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans, buildLayer);
+
+				for (int i = 0; i < ntiles; ++i)
+				{
+					TileCacheData* tile = &tiles[i];
+					status = tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);
+					if (dtStatusFailed(status))
+					{
+						dtFree(tile->data);
+						tile->data = 0;
+						continue;
+					}
+
+					cacheLayerCount++;
+					cacheCompressedSize += tile->dataSize;
+					cacheRawSize += calcLayerBufferSize(tcparams.width, tcparams.height);
+				}
+			}
+		}
 	}
 
 	// Build initial meshes
@@ -363,10 +1386,565 @@ dtStatus handleBuild(
 	}
 	//printf("navmeshMemUsage = %.1f kB", navmeshMemUsage / 1024.0f);
 
+	if (stats)
+	{
+		stats->layerCount = cacheLayerCount;
+		stats->compressedSize = cacheCompressedSize;
+		stats->rawSize = cacheRawSize;
+		stats->navmeshSize = navmeshMemUsage;
+		stats->inputPeakSize = (int)dtMin(geomCache.peakSize, (long long)0x7fffffff);
+		stats->inputChunkLoads = geomCache.loads;
+		stats->chunkyMeshMapped = chunkyMeshMapped ? 1 : 0;
+		stats->tilesReused = tilesReused;
+	}
+
 	/*
 	if (m_tool)
 	m_tool->init(this);
 	initToolStates(this);
 	*/
 	return DT_SUCCESS;
-}
\ No newline at end of file
+}
+
+dtStatus handleBuild(
+	void *pCtx,
+	float *verts, int nverts, int vertsPerPoly,
+	int *tris, int ntris, int trisPerChunk,
+	bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+	const float *bmin, const float *bmax,
+	float cellSize, float cellHeight,
+	float tileSize,
+	float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+	float edgeMaxLen, float edgeMaxError,
+	float regionMinSize, float regionMergeSize,
+	float detailSampleDist, float detailSampleMaxError,
+	dtTileCache **pTileCache, dtNavMesh **pNavMesh, dtNavMeshQuery **pNavQuery,
+	RasterizeTileLayersFunc rasterizeTileLayers)
+{
+	return buildTileCache(pCtx
+		, verts, nverts, vertsPerPoly
+		, tris, ntris, trisPerChunk
+		, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans
+		, bmin, bmax
+		, cellSize, cellHeight
+		, tileSize
+		, agentMaxSlope, agentMaxClimb, agentRadius, agentHeight
+		, edgeMaxLen, edgeMaxError
+		, regionMinSize, regionMergeSize
+		, detailSampleDist, detailSampleMaxError
+		, pTileCache, pNavMesh, pNavQuery
+		, rasterizeTileLayers, 0, 1
+		, DEFAULT_MAX_OBSTACLES, RCN_TILECACHE_COMPRESSION_NONE, 0, 0, 0, 0);
+}
+
+// Rebuilds tile cache tiles on a background thread.
+//
+// sync() runs on the thread that owns the tile cache.  It commits finished
+// tiles to the navigation mesh, then hands the next dirty tiles to the worker
+// along with a copy of the obstacles that touch them.  The worker only reads
+// the compressed tiles, so queries and crowd updates can use the navigation
+// mesh while it builds.  Obstacle requests are processed once every
+// dispatched tile has been committed, which keeps the obstacle states the same
+// as with dtTileCache::update.
+struct TileCacheWorker
+{
+	struct Job
+	{
+		dtCompressedTileRef ref;
+		std::vector<dtTileCacheObstacle> obstacles;
+		unsigned char* navData;
+		int navDataSize;
+		dtStatus status;
+	};
+
+	dtTileCache* tileCache;
+	LinearAllocator* talloc;
+	int maxJobs;
+
+	// Owner thread only.
+	int inFlight;
+	std::vector<Job*> freeJobs;
+
+	std::mutex lock;
+	std::condition_variable wake;
+	std::deque<Job*> todo;
+	std::deque<Job*> done;
+	bool quit;
+
+	std::thread thread;
+
+	TileCacheWorker(dtTileCache* tc, LinearAllocator* alloc, const int maxJobs)
+		: tileCache(tc)
+		, talloc(alloc)
+		, maxJobs(maxJobs)
+		, inFlight(0)
+		, quit(false)
+	{
+	}
+
+	~TileCacheWorker()
+	{
+		stop();
+		freeJobList(todo);
+		freeJobList(done);
+		for (size_t i = 0; i < freeJobs.size(); ++i)
+			delete freeJobs[i];
+		LinearAllocator::destroy(talloc);
+	}
+
+	static void freeJobList(std::deque<Job*>& jobs)
+	{
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			dtFree(jobs[i]->navData);
+			delete jobs[i];
+		}
+		jobs.clear();
+	}
+
+	void stop()
+	{
+		if (!thread.joinable())
+			return;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			quit = true;
+		}
+		wake.notify_one();
+		thread.join();
+	}
+
+	// Stops the thread, then builds and commits the tiles it did not get to.
+	dtStatus finish(dtNavMesh* navmesh)
+	{
+		stop();
+
+		while (!todo.empty())
+		{
+			Job* job = todo.front();
+			todo.pop_front();
+			build(job);
+			done.push_back(job);
+		}
+
+		return commit(navmesh, 0);
+	}
+
+	void build(Job* job)
+	{
+		job->status = tileCache->buildNavMeshTileData(job->ref, talloc
+			, job->obstacles.empty() ? 0 : &job->obstacles[0], (int)job->obstacles.size()
+			, &job->navData, &job->navDataSize);
+	}
+
+	void run()
+	{
+		for (;;)
+		{
+			Job* job;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				wake.wait(guard, [this] { return quit || !todo.empty(); });
+				if (quit)
+					return;
+				job = todo.front();
+				todo.pop_front();
+			}
+
+			build(job);
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				done.push_back(job);
+			}
+		}
+	}
+
+	// Commits up to maxCommits finished tiles. (All if maxCommits <= 0.)
+	dtStatus commit(dtNavMesh* navmesh, const int maxCommits)
+	{
+		dtStatus status = DT_SUCCESS;
+
+		for (int i = 0; maxCommits <= 0 || i < maxCommits; ++i)
+		{
+			Job* job;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if (done.empty())
+					break;
+				job = done.front();
+				done.pop_front();
+			}
+
+			if (dtStatusFailed(job->status))
+			{
+				dtFree(job->navData);
+				status = job->status;
+			}
+			else
+			{
+				const dtStatus commitStatus = tileCache->commitNavMeshTile(job->ref
+					, job->navData, job->navDataSize, navmesh);
+				if (dtStatusFailed(commitStatus))
+					status = commitStatus;
+			}
+			job->navData = 0;
+			job->navDataSize = 0;
+
+			tileCache->finishTileUpdate(job->ref);
+			freeJobs.push_back(job);
+			inFlight--;
+		}
+
+		return status;
+	}
+
+	dtStatus sync(dtNavMesh* navmesh, const int maxCommits, int* pendingTiles)
+	{
+		dtStatus status = commit(navmesh, maxCommits);
+
+		// Obstacle requests can only be applied while no tile is being
+		// rebuilt.  So no new tiles are dispatched while requests are queued,
+		// and the in-flight ones drain.
+		if (inFlight == 0)
+			tileCache->processObstacleRequests();
+
+		// Dispatch dirty tiles.
+		const int maxObstacles = tileCache->getParams()->maxObstacles;
+		dtCompressedTileRef ref;
+		while (inFlight < maxJobs
+			&& tileCache->getPendingRequestCount() == 0
+			&& tileCache->popTileUpdate(&ref))
+		{
+			Job* job;
+			if (freeJobs.empty())
+			{
+				job = new(std::nothrow) Job();
+				if (!job)
+				{
+					// Rebuild on this thread instead.
+					status = tileCache->buildNavMeshTile(ref, navmesh);
+					tileCache->finishTileUpdate(ref);
+					continue;
+				}
+			}
+			else
+			{
+				job = freeJobs.back();
+				freeJobs.pop_back();
+			}
+
+			job->ref = ref;
+			job->obstacles.resize(maxObstacles);
+			job->obstacles.resize(tileCache->getTileObstacles(ref
+				, job->obstacles.empty() ? 0 : &job->obstacles[0], maxObstacles));
+			job->navData = 0;
+			job->navDataSize = 0;
+			job->status = DT_SUCCESS;
+			inFlight++;
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				todo.push_back(job);
+			}
+			wake.notify_one();
+		}
+
+		if (pendingTiles)
+		{
+			*pendingTiles = inFlight
+				+ tileCache->getPendingTileCount()
+				+ tileCache->getPendingRequestCount();
+		}
+
+		return status;
+	}
+};
+
+extern "C"
+{
+	// Same as handleBuild, but rasterizes the tile grid on threadCount
+	// threads.  (One thread per hardware core if threadCount <= 0.)
+	// The rasterizer comes from nmtcGetTileRasterizer().
+	// maxObstacles is the number of obstacles that can exist at once.
+	// compression is a rcnTileCacheCompression value.  stats is optional.
+	// If chunkyMeshCachePath is set, the partitioned input mesh is mapped from
+	// that file when it matches the input, and saved to it otherwise.
+	// If manifestPath is set, only the tiles whose input changed since the
+	// build that wrote the manifest are rasterized.  (See BakeManifest.)
+	EXPORT_API dtStatus dttcBuildParallel(
+		void *pCtx,
+		float *verts, int nverts, int vertsPerPoly,
+		int *tris, int ntris, int trisPerChunk,
+		bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+		const float *bmin, const float *bmax,
+		float cellSize, float cellHeight,
+		float tileSize,
+		float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+		float edgeMaxLen, float edgeMaxError,
+		float regionMinSize, float regionMergeSize,
+		float detailSampleDist, float detailSampleMaxError,
+		dtTileCache **pTileCache, dtNavMesh **pNavMesh, dtNavMeshQuery **pNavQuery,
+		const TileRasterizer* rasterizer, int threadCount,
+		int maxObstacles, int compression, rcnTileCacheBuildStats* stats,
+		const char* chunkyMeshCachePath, const char* manifestPath)
+	{
+		if (!rasterizer)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		return buildTileCache(pCtx
+			, verts, nverts, vertsPerPoly
+			, tris, ntris, trisPerChunk
+			, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans
+			, bmin, bmax
+			, cellSize, cellHeight
+			, tileSize
+			, agentMaxSlope, agentMaxClimb, agentRadius, agentHeight
+			, edgeMaxLen, edgeMaxError
+			, regionMinSize, regionMergeSize
+			, detailSampleDist, detailSampleMaxError
+			, pTileCache, pNavMesh, pNavQuery
+			, 0, rasterizer, threadCount
+			, maxObstacles, compression, stats, 0, chunkyMeshCachePath, manifestPath);
+	}
+
+	// Same as dttcBuildParallel, but reads the input geometry a chunk at a
+	// time from source, so the whole mesh is never in memory.  bmin and bmax
+	// are the bounds of the tile grid.  (See dtgsGetBounds.)
+	EXPORT_API dtStatus dttcBuildStreamed(
+		void *pCtx,
+		const rcnGeomSource* source, int vertsPerPoly,
+		bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+		const float *bmin, const float *bmax,
+		float cellSize, float cellHeight,
+		float tileSize,
+		float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+		float edgeMaxLen, float edgeMaxError,
+		float regionMinSize, float regionMergeSize,
+		float detailSampleDist, float detailSampleMaxError,
+		dtTileCache **pTileCache, dtNavMesh **pNavMesh, dtNavMeshQuery **pNavQuery,
+		const TileRasterizer* rasterizer, int threadCount,
+		int maxObstacles, int compression, rcnTileCacheBuildStats* stats)
+	{
+		if (!source || !source->loadChunk || (source->nchunks && !source->chunks)
+			|| !rasterizer)
+		{
+			return DT_FAILURE | DT_INVALID_PARAM;
+		}
+
+		return buildTileCache(pCtx
+			, 0, 0, vertsPerPoly
+			, 0, 0, 0
+			, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans
+			, bmin, bmax
+			, cellSize, cellHeight
+			, tileSize
+			, agentMaxSlope, agentMaxClimb, agentRadius, agentHeight
+			, edgeMaxLen, edgeMaxError
+			, regionMinSize, regionMergeSize
+			, detailSampleDist, detailSampleMaxError
+			, pTileCache, pNavMesh, pNavQuery
+			, 0, rasterizer, threadCount
+			, maxObstacles, compression, stats, source, 0, 0);
+	}
+
+	// dttcBuildStreamed for a file opened with dtgsOpen.
+	EXPORT_API dtStatus dttcBuildFromFile(
+		void *pCtx,
+		const rcnGeomFile* file, int vertsPerPoly,
+		bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+		const float *bmin, const float *bmax,
+		float cellSize, float cellHeight,
+		float tileSize,
+		float agentMaxSlope, float agentMaxClimb, float agentRadius, float agentHeight,
+		float edgeMaxLen, float edgeMaxError,
+		float regionMinSize, float regionMergeSize,
+		float detailSampleDist, float detailSampleMaxError,
+		dtTileCache **pTileCache, dtNavMesh **pNavMesh, dtNavMeshQuery **pNavQuery,
+		const TileRasterizer* rasterizer, int threadCount,
+		int maxObstacles, int compression, rcnTileCacheBuildStats* stats)
+	{
+		if (!file)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		return dttcBuildStreamed(pCtx
+			, rcnGetGeomFileSource(file), vertsPerPoly
+			, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans
+			, bmin, bmax
+			, cellSize, cellHeight
+			, tileSize
+			, agentMaxSlope, agentMaxClimb, agentRadius, agentHeight
+			, edgeMaxLen, edgeMaxError
+			, regionMinSize, regionMergeSize
+			, detailSampleDist, detailSampleMaxError
+			, pTileCache, pNavMesh, pNavQuery
+			, rasterizer, threadCount
+			, maxObstacles, compression, stats);
+	}
+
+	EXPORT_API void dttcFree(dtTileCache* tileCache)
+	{
+		freeTileCache(tileCache);
+	}
+
+	// Gets the tile rebuild allocator usage.  high is the largest amount of
+	// memory a single tile rebuild has used, capacity the memory currently
+	// reserved.  [Units: Bytes]
+	EXPORT_API void dttcGetAllocatorUsage(dtTileCache* tileCache
+		, int* high
+		, int* capacity)
+	{
+		if (!tileCache)
+			return;
+
+		LinearAllocator* talloc = (LinearAllocator*)tileCache->getAlloc();
+		if (!talloc)
+			return;
+
+		if (high)
+			*high = (int)dtMax(talloc->high, talloc->used);
+		if (capacity)
+			*capacity = (int)talloc->capacity;
+	}
+
+	EXPORT_API dtStatus dttcAddObstacle(dtTileCache* tileCache
+		, const float* pos
+		, float radius
+		, float height
+		, dtObstacleRef* result)
+	{
+		if (!tileCache || !pos)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return tileCache->addObstacle(pos, radius, height, result);
+	}
+
+	EXPORT_API dtStatus dttcAddBoxObstacle(dtTileCache* tileCache
+		, const float* bmin
+		, const float* bmax
+		, dtObstacleRef* result)
+	{
+		if (!tileCache || !bmin || !bmax)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return tileCache->addBoxObstacle(bmin, bmax, result);
+	}
+
+	EXPORT_API dtStatus dttcAddOrientedBoxObstacle(dtTileCache* tileCache
+		, const float* center
+		, const float* halfExtents
+		, float yRadians
+		, dtObstacleRef* result)
+	{
+		if (!tileCache || !center || !halfExtents)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return tileCache->addBoxObstacle(center, halfExtents, yRadians, result);
+	}
+
+	EXPORT_API dtStatus dttcRemoveObstacle(dtTileCache* tileCache
+		, dtObstacleRef ref)
+	{
+		if (!tileCache)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return tileCache->removeObstacle(ref);
+	}
+
+	// Processes obstacle requests and rebuilds the affected tiles until the
+	// cache is up to date or a budget runs out.  At least one tile is
+	// rebuilt per call.  A budget <= 0 is unlimited.
+	// pendingTiles is set to the rebuilds (plus unprocessed obstacle
+	// requests) left for later calls.  Optional.
+	EXPORT_API dtStatus dttcUpdate(dtTileCache* tileCache
+		, dtNavMesh* navmesh
+		, int maxTiles
+		, int maxMicroseconds
+		, int* pendingTiles)
+	{
+		if (!tileCache || !navmesh)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		typedef std::chrono::steady_clock Clock;
+		const Clock::time_point start = Clock::now();
+
+		dtStatus status = DT_SUCCESS;
+		bool upToDate = false;
+		int ntiles = 0;
+		while (!upToDate)
+		{
+			status = tileCache->update(0, navmesh, &upToDate);
+			if (dtStatusFailed(status))
+				break;
+
+			ntiles++;
+			if (maxTiles > 0 && ntiles >= maxTiles)
+				break;
+			if (maxMicroseconds > 0 && std::chrono::duration_cast<std::chrono::microseconds>(
+				Clock::now() - start).count() >= maxMicroseconds)
+			{
+				break;
+			}
+		}
+
+		if (pendingTiles)
+		{
+			*pendingTiles = tileCache->getPendingTileCount()
+				+ tileCache->getPendingRequestCount();
+		}
+
+		return status;
+	}
+
+	// Starts rebuilding the tiles of a tile cache on a background thread.
+	// Use dttcwSync instead of dttcUpdate while the worker exists, and free
+	// the worker before the tile cache.  maxJobs is the number of tiles that
+	// can be rebuilding between syncs.
+	EXPORT_API TileCacheWorker* dttcwAlloc(dtTileCache* tileCache, int maxJobs)
+	{
+		if (!tileCache || maxJobs < 1)
+			return 0;
+
+		LinearAllocator* talloc = LinearAllocator::create(TILECACHE_ALLOC_PAGE_SIZE);
+		if (!talloc)
+			return 0;
+
+		TileCacheWorker* worker = new(std::nothrow) TileCacheWorker(tileCache, talloc, maxJobs);
+		if (!worker)
+		{
+			LinearAllocator::destroy(talloc);
+			return 0;
+		}
+
+		worker->thread = std::thread(&TileCacheWorker::run, worker);
+
+		return worker;
+	}
+
+	// Finishes the tiles the worker has started, commits them to navmesh,
+	// then frees the worker.  If navmesh is null the started tiles are
+	// discarded, which is only safe when the tile cache is about to be freed.
+	EXPORT_API dtStatus dttcwFree(TileCacheWorker* worker, dtNavMesh* navmesh)
+	{
+		if (!worker)
+			return DT_SUCCESS;
+
+		dtStatus status = DT_SUCCESS;
+		if (navmesh)
+			status = worker->finish(navmesh);
+
+		delete worker;
+
+		return status;
+	}
+
+	// Commits up to maxCommits finished tiles to the navigation mesh
+	// (all if maxCommits <= 0) and hands dirty tiles to the worker.
+	// pendingTiles is set to the tiles still rebuilding or queued, plus
+	// unprocessed obstacle requests.  Optional.
+	EXPORT_API dtStatus dttcwSync(TileCacheWorker* worker
+		, dtNavMesh* navmesh
+		, int maxCommits
+		, int* pendingTiles)
+	{
+		if (!worker || !navmesh)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return worker->sync(navmesh, maxCommits, pendingTiles);
+	}
+}
@@ -0,0 +1,297 @@
+#include "GeomStream.h"
+#include "DetourCommon.h"
+#include "DetourEx.h"
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <mutex>
+#include <vector>
+
+// File layout: header, chunk data (vertices then triangles, per chunk), then
+// the chunk table.  The table is written last so chunks can be appended
+// without knowing how many there will be.
+static const int GEOM_FILE_MAGIC = 'R'<<24 | 'C'<<16 | 'G'<<8 | 'S';
+static const int GEOM_FILE_VERSION = 1;
+
+struct GeomFileHeader
+{
+	int magic;
+	int version;
+	int nchunks;
+	int reserved;
+	long long tableOffset;
+};
+
+struct GeomFileChunk
+{
+	rcnGeomChunk info;
+	long long offset;
+};
+
+static int seekFile(FILE* fp, const long long offset)
+{
+#if _MSC_VER
+	return _fseeki64(fp, offset, SEEK_SET);
+#else
+	return fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+}
+
+struct rcnGeomFileWriter
+{
+	FILE* fp;
+	std::vector<GeomFileChunk> chunks;
+	long long offset;
+	bool failed;
+};
+
+struct rcnGeomFile
+{
+	FILE* fp;
+	std::mutex lock;	// Guards the file position.
+	std::vector<rcnGeomChunk> chunks;
+	std::vector<long long> offsets;
+	rcnGeomSource source;
+};
+
+static bool loadFileChunk(void* user, int chunk, float* verts, int* tris)
+{
+	rcnGeomFile* file = (rcnGeomFile*)user;
+	const rcnGeomChunk& info = file->chunks[chunk];
+
+	{
+		std::lock_guard<std::mutex> guard(file->lock);
+		if (seekFile(file->fp, file->offsets[chunk]) != 0
+			|| fread(verts, sizeof(float)*3, info.nverts, file->fp) != (size_t)info.nverts
+			|| fread(tris, sizeof(int)*3, info.ntris, file->fp) != (size_t)info.ntris)
+		{
+			return false;
+		}
+	}
+
+	// Don't trust the file with the rasterizer's memory.
+	for (int i = 0; i < info.ntris*3; ++i)
+	{
+		if (tris[i] < 0 || tris[i] >= info.nverts)
+			return false;
+	}
+
+	return true;
+}
+
+const rcnGeomSource* rcnGetGeomFileSource(const rcnGeomFile* file)
+{
+	return file ? &file->source : 0;
+}
+
+extern "C"
+{
+	// Creates a chunked geometry file, replacing any existing file.
+	EXPORT_API rcnGeomFileWriter* dtgsCreateWriter(const char* path)
+	{
+		if (!path)
+			return 0;
+
+		rcnGeomFileWriter* writer = new(std::nothrow) rcnGeomFileWriter();
+		if (!writer)
+			return 0;
+
+		writer->fp = fopen(path, "wb");
+		if (!writer->fp)
+		{
+			delete writer;
+			return 0;
+		}
+
+		// Reserve room for the header.  It is written on close.
+		GeomFileHeader header;
+		memset(&header, 0, sizeof(header));
+		writer->failed = fwrite(&header, sizeof(header), 1, writer->fp) != 1;
+		writer->offset = sizeof(header);
+
+		return writer;
+	}
+
+	// Appends a chunk.  Triangle indices are local to the chunk.
+	EXPORT_API dtStatus dtgsWriteChunk(rcnGeomFileWriter* writer
+		, const float* verts
+		, const int nverts
+		, const int* tris
+		, const int ntris)
+	{
+		if (!writer || !verts || !tris || nverts <= 0 || ntris <= 0)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		if (writer->failed)
+			return DT_FAILURE;
+
+		for (int i = 0; i < ntris*3; ++i)
+		{
+			if (tris[i] < 0 || tris[i] >= nverts)
+				return DT_FAILURE | DT_INVALID_PARAM;
+		}
+
+		GeomFileChunk chunk;
+		dtVcopy(chunk.info.bmin, verts);
+		dtVcopy(chunk.info.bmax, verts);
+		for (int i = 1; i < nverts; ++i)
+		{
+			dtVmin(chunk.info.bmin, &verts[i*3]);
+			dtVmax(chunk.info.bmax, &verts[i*3]);
+		}
+		chunk.info.nverts = nverts;
+		chunk.info.ntris = ntris;
+		chunk.offset = writer->offset;
+
+		if (fwrite(verts, sizeof(float)*3, nverts, writer->fp) != (size_t)nverts
+			|| fwrite(tris, sizeof(int)*3, ntris, writer->fp) != (size_t)ntris)
+		{
+			writer->failed = true;
+			return DT_FAILURE;
+		}
+
+		writer->offset += (long long)nverts*sizeof(float)*3 + (long long)ntris*sizeof(int)*3;
+		writer->chunks.push_back(chunk);
+
+		return DT_SUCCESS;
+	}
+
+	// Writes the chunk table, closes the file, and frees the writer.
+	EXPORT_API dtStatus dtgsCloseWriter(rcnGeomFileWriter* writer)
+	{
+		if (!writer)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		GeomFileHeader header;
+		header.magic = GEOM_FILE_MAGIC;
+		header.version = GEOM_FILE_VERSION;
+		header.nchunks = (int)writer->chunks.size();
+		header.reserved = 0;
+		header.tableOffset = writer->offset;
+
+		bool ok = !writer->failed;
+		if (ok && header.nchunks)
+		{
+			ok = fwrite(&writer->chunks[0], sizeof(GeomFileChunk), header.nchunks, writer->fp)
+				== (size_t)header.nchunks;
+		}
+		ok = ok && seekFile(writer->fp, 0) == 0
+			&& fwrite(&header, sizeof(header), 1, writer->fp) == 1;
+		ok = fclose(writer->fp) == 0 && ok;
+
+		delete writer;
+
+		return ok ? DT_SUCCESS : DT_FAILURE;
+	}
+
+	// Opens a file written by dtgsCreateWriter.  Chunks are read on demand.
+	EXPORT_API dtStatus dtgsOpen(const char* path, rcnGeomFile** result)
+	{
+		if (!path || !result)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		*result = 0;
+
+		FILE* fp = fopen(path, "rb");
+		if (!fp)
+			return DT_FAILURE;
+
+		GeomFileHeader header;
+		if (fread(&header, sizeof(header), 1, fp) != 1)
+		{
+			fclose(fp);
+			return DT_FAILURE;
+		}
+		if (header.magic != GEOM_FILE_MAGIC)
+		{
+			fclose(fp);
+			return DT_FAILURE | DT_WRONG_MAGIC;
+		}
+		if (header.version != GEOM_FILE_VERSION)
+		{
+			fclose(fp);
+			return DT_FAILURE | DT_WRONG_VERSION;
+		}
+		if (header.nchunks < 0)
+		{
+			fclose(fp);
+			return DT_FAILURE;
+		}
+
+		rcnGeomFile* file = new(std::nothrow) rcnGeomFile();
+		if (!file)
+		{
+			fclose(fp);
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+		file->fp = fp;
+
+		std::vector<GeomFileChunk> table(header.nchunks);
+		if (header.nchunks
+			&& (seekFile(fp, header.tableOffset) != 0
+				|| fread(&table[0], sizeof(GeomFileChunk), header.nchunks, fp) != (size_t)header.nchunks))
+		{
+			fclose(fp);
+			delete file;
+			return DT_FAILURE;
+		}
+
+		file->chunks.resize(header.nchunks);
+		file->offsets.resize(header.nchunks);
+		for (int i = 0; i < header.nchunks; ++i)
+		{
+			if (table[i].info.nverts <= 0 || table[i].info.ntris <= 0)
+			{
+				fclose(fp);
+				delete file;
+				return DT_FAILURE;
+			}
+			file->chunks[i] = table[i].info;
+			file->offsets[i] = table[i].offset;
+		}
+
+		file->source.chunks = header.nchunks ? &file->chunks[0] : 0;
+		file->source.nchunks = header.nchunks;
+		file->source.loadChunk = loadFileChunk;
+		file->source.user = file;
+
+		*result = file;
+
+		return DT_SUCCESS;
+	}
+
+	EXPORT_API void dtgsFree(rcnGeomFile* file)
+	{
+		if (!file)
+			return;
+		fclose(file->fp);
+		delete file;
+	}
+
+	EXPORT_API int dtgsGetChunkCount(const rcnGeomFile* file)
+	{
+		return file ? (int)file->chunks.size() : 0;
+	}
+
+	// Gets the bounds of all chunks.  (Zero if the file has none.)
+	EXPORT_API void dtgsGetBounds(const rcnGeomFile* file, float* bmin, float* bmax)
+	{
+		if (!file || !bmin || !bmax)
+			return;
+
+		if (file->chunks.empty())
+		{
+			dtVset(bmin, 0, 0, 0);
+			dtVset(bmax, 0, 0, 0);
+			return;
+		}
+
+		dtVcopy(bmin, file->chunks[0].bmin);
+		dtVcopy(bmax, file->chunks[0].bmax);
+		for (size_t i = 1; i < file->chunks.size(); ++i)
+		{
+			dtVmin(bmin, file->chunks[i].bmin);
+			dtVmax(bmax, file->chunks[i].bmax);
+		}
+	}
+}
@@ -0,0 +1,209 @@
+#include "LZCompressor.h"
+#include "DetourStatus.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LZ_USE_SSE2 1
+#endif
+
+static const int LZ_MIN_MATCH = 4;
+static const int LZ_MAX_OFFSET = 0xffff;
+static const int LZ_HASH_LOG = 12;
+static const int LZ_HASH_SIZE = 1 << LZ_HASH_LOG;
+
+LZCompressor LZCompressor::instance;
+
+inline unsigned int lzRead32(const unsigned char* p)
+{
+	unsigned int v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline int lzHash(const unsigned int v)
+{
+	return (int)((v * 2654435761u) >> (32 - LZ_HASH_LOG));
+}
+
+// Copies 16 bytes.  May read and write past the logical end of a run, so the
+// caller must make sure both buffers have the room.
+inline void lzCopy16(unsigned char* dst, const unsigned char* src)
+{
+#ifdef LZ_USE_SSE2
+	_mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#else
+	memcpy(dst, src, 16);
+#endif
+}
+
+static unsigned char* lzWriteLength(unsigned char* op, int len)
+{
+	while (len >= 255)
+	{
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char)len;
+	return op;
+}
+
+static bool lzReadLength(const unsigned char* in, const int n, int& ip, int& len)
+{
+	unsigned char b;
+	do
+	{
+		if (ip >= n)
+			return false;
+		b = in[ip++];
+		len += b;
+	}
+	while (b == 255);
+	return true;
+}
+
+static unsigned char* lzWriteLiterals(unsigned char* op, unsigned char token
+	, const unsigned char* lit, const int litLen)
+{
+	*op++ = token;
+	if (litLen >= 15)
+		op = lzWriteLength(op, litLen - 15);
+	memcpy(op, lit, litLen);
+	return op + litLen;
+}
+
+int LZCompressor::maxCompressedSize(const int bufferSize)
+{
+	// Worst case is a single literal run.
+	return bufferSize + bufferSize / 255 + 16;
+}
+
+dtStatus LZCompressor::compress(const unsigned char* buffer, const int bufferSize,
+	unsigned char* compressed, const int maxCompressedSize, int* compressedSize)
+{
+	if ((!buffer && bufferSize) || !compressed || !compressedSize || bufferSize < 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	if (maxCompressedSize < LZCompressor::maxCompressedSize(bufferSize))
+		return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+	int table[LZ_HASH_SIZE];
+	memset(table, 0xff, sizeof(table));
+
+	unsigned char* op = compressed;
+	int ip = 0;
+	int anchor = 0;
+
+	while (ip + LZ_MIN_MATCH <= bufferSize)
+	{
+		const unsigned int v = lzRead32(&buffer[ip]);
+		const int h = lzHash(v);
+		const int ref = table[h];
+		table[h] = ip;
+
+		if (ref < 0 || ip - ref > LZ_MAX_OFFSET || lzRead32(&buffer[ref]) != v)
+		{
+			ip++;
+			continue;
+		}
+
+		int len = LZ_MIN_MATCH;
+		while (ip + len < bufferSize && buffer[ref + len] == buffer[ip + len])
+			len++;
+
+		const int litLen = ip - anchor;
+		const int matchLen = len - LZ_MIN_MATCH;
+		const unsigned char token = (unsigned char)(((litLen < 15 ? litLen : 15) << 4)
+			| (matchLen < 15 ? matchLen : 15));
+
+		op = lzWriteLiterals(op, token, &buffer[anchor], litLen);
+
+		const int offset = ip - ref;
+		*op++ = (unsigned char)(offset & 0xff);
+		*op++ = (unsigned char)(offset >> 8);
+		if (matchLen >= 15)
+			op = lzWriteLength(op, matchLen - 15);
+
+		ip += len;
+		anchor = ip;
+	}
+
+	// Trailing literals. (Always present, possibly empty, to terminate the stream.)
+	const int litLen = bufferSize - anchor;
+	op = lzWriteLiterals(op, (unsigned char)((litLen < 15 ? litLen : 15) << 4)
+		, &buffer[anchor], litLen);
+
+	*compressedSize = (int)(op - compressed);
+
+	return DT_SUCCESS;
+}
+
+dtStatus LZCompressor::decompress(const unsigned char* compressed, const int compressedSize,
+	unsigned char* buffer, const int maxBufferSize, int* bufferSize)
+{
+	if (!compressed || !buffer || !bufferSize)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	int ip = 0;
+	int op = 0;
+
+	while (ip < compressedSize)
+	{
+		const unsigned char token = compressed[ip++];
+
+		int litLen = token >> 4;
+		if (litLen == 15 && !lzReadLength(compressed, compressedSize, ip, litLen))
+			return DT_FAILURE | DT_INVALID_PARAM;
+		if (ip + litLen > compressedSize)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		if (op + litLen > maxBufferSize)
+			return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+		memcpy(&buffer[op], &compressed[ip], litLen);
+		ip += litLen;
+		op += litLen;
+
+		if (ip >= compressedSize)
+			break;  // Trailing literals.
+
+		if (ip + 2 > compressedSize)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		const int offset = compressed[ip] | (compressed[ip + 1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		int len = token & 15;
+		if (len == 15 && !lzReadLength(compressed, compressedSize, ip, len))
+			return DT_FAILURE | DT_INVALID_PARAM;
+		len += LZ_MIN_MATCH;
+		if (op + len > maxBufferSize)
+			return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+		unsigned char* dst = &buffer[op];
+		const unsigned char* src = dst - offset;
+
+		if (offset == 1)
+		{
+			// Runs of a single value are by far the most common match.
+			memset(dst, *src, len);
+		}
+		else if (offset >= 16 && op + len + 16 <= maxBufferSize)
+		{
+			// Source and destination never overlap within a 16 byte block,
+			// so the match can be copied a block at a time.
+			for (int i = 0; i < len; i += 16)
+				lzCopy16(dst + i, src + i);
+		}
+		else
+		{
+			for (int i = 0; i < len; ++i)
+				dst[i] = src[i];
+		}
+
+		op += len;
+	}
+
+	*bufferSize = op;
+
+	return DT_SUCCESS;
+}
@@ -0,0 +1,656 @@
+#include "NavHierarchy.h"
+#include "DetourCommon.h"
+#include "DetourEx.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <queue>
+#include <unordered_map>
+
+static const unsigned short NO_ENTRANCE = 0xffff;
+
+// Caps the polygons per entrance, so a long border gets several entrances
+// rather than one that paths have to detour through.
+static const int MAX_ENTRANCE_POLYS = 8;
+
+static const int MAX_NEIGHBOUR_LAYERS = 32;
+static const int MAX_SEGMENT_PATH = 1024;
+static const int REFINE_TILES = 4;	// Tiles per refinement search.
+static const float H_SCALE = 0.999f; // Search heuristic scale, as in dtNavMeshQuery.
+
+// dtQueryFilter's polygon test and cost are inline in DetourNavMeshQuery.cpp,
+// so they are repeated here for the default, non-virtual filter.
+static inline bool passFilter(const dtQueryFilter& filter, const dtPoly* poly)
+{
+	return (poly->flags & filter.getIncludeFlags()) != 0 && (poly->flags & filter.getExcludeFlags()) == 0;
+}
+
+static inline float getCost(const dtQueryFilter& filter, const float* pa, const float* pb, const dtPoly* poly)
+{
+	return dtVdist(pa, pb) * filter.getAreaCost(poly->getArea());
+}
+
+static void getPolyCenter(const dtNavMesh* nav, const dtPolyRef ref, float* center)
+{
+	const dtMeshTile* tile = 0;
+	const dtPoly* poly = 0;
+	nav->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+	dtCalcPolyCenter(center, poly->verts, poly->vertCount, tile->verts);
+}
+
+// Gets the first usable link from the polygon into another tile, or zero.
+static dtPolyRef findCrossLink(const dtNavMesh* nav, const dtQueryFilter& filter
+	, const dtMeshTile* tile, const dtPoly* poly, const unsigned int toTile)
+{
+	for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+	{
+		const dtPolyRef ref = tile->links[k].ref;
+		if (!ref || nav->decodePolyIdTile(ref) != toTile)
+			continue;
+
+		const dtMeshTile* ntile = 0;
+		const dtPoly* npoly = 0;
+		nav->getTileAndPolyByRefUnsafe(ref, &ntile, &npoly);
+		if (passFilter(filter, npoly))
+			return ref;
+	}
+	return 0;
+}
+
+NavHierarchy::NavHierarchy()
+	: m_nav(0)
+{
+}
+
+NavHierarchy::~NavHierarchy()
+{
+}
+
+dtStatus NavHierarchy::init(const dtNavMesh* nav, const dtQueryFilter* filter)
+{
+	if (!nav || !filter)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	m_nav = nav;
+	m_filter = *filter;
+	m_clusters.assign(nav->getMaxTiles(), Cluster());
+
+	for (int i = 0; i < nav->getMaxTiles(); ++i)
+		buildCluster(i);
+
+	return DT_SUCCESS;
+}
+
+dtStatus NavHierarchy::update(int* rebuiltCount)
+{
+	if (rebuiltCount)
+		*rebuiltCount = 0;
+
+	if (!m_nav)
+		return DT_FAILURE;
+
+	const int maxTiles = m_nav->getMaxTiles();
+	std::vector<char> dirty(maxTiles, 0);
+	const dtMeshTile* neighbours[MAX_NEIGHBOUR_LAYERS];
+
+	for (int i = 0; i < maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		const bool exists = tile && tile->header;
+		const Cluster& cluster = m_clusters[i];
+		if (exists == cluster.built && (!exists || (tile->salt == cluster.salt
+			&& tile->polyRevision == cluster.polyRevision)))
+		{
+			continue;
+		}
+
+		dirty[i] = 1;
+
+		// The links of the neighbours change with the tile, including the
+		// diagonal ones for off-mesh connections.  Their entrances also
+		// depend on which of its polygons pass the filter.
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			if (pass == 0 ? !cluster.built : !exists)
+				continue;
+			const int x = pass == 0 ? cluster.x : tile->header->x;
+			const int y = pass == 0 ? cluster.y : tile->header->y;
+			for (int dy = -1; dy <= 1; ++dy)
+			{
+				for (int dx = -1; dx <= 1; ++dx)
+				{
+					const int n = m_nav->getTilesAt(x+dx, y+dy, neighbours, MAX_NEIGHBOUR_LAYERS);
+					for (int j = 0; j < n; ++j)
+						dirty[m_nav->decodePolyIdTile(m_nav->getTileRef(neighbours[j]))] = 1;
+				}
+			}
+		}
+	}
+
+	int count = 0;
+	for (int i = 0; i < maxTiles; ++i)
+	{
+		if (!dirty[i])
+			continue;
+		buildCluster(i);
+		count++;
+	}
+
+	if (rebuiltCount)
+		*rebuiltCount = count;
+
+	return DT_SUCCESS;
+}
+
+bool NavHierarchy::isCurrent(const unsigned int tileIndex) const
+{
+	if (tileIndex >= m_clusters.size() || !m_clusters[tileIndex].built)
+		return false;
+	const dtMeshTile* tile = m_nav->getTile((int)tileIndex);
+	const Cluster& cluster = m_clusters[tileIndex];
+	return tile && tile->header && tile->salt == cluster.salt
+		&& tile->polyRevision == cluster.polyRevision;
+}
+
+// Dijkstra over the polygons of one tile.  Polygons are entered at their
+// centers, except for the start.
+void NavHierarchy::searchTile(const dtMeshTile* tile, const int start, const float* startPos
+	, std::vector<float>& dist) const
+{
+	const int npolys = tile->header->polyCount;
+	const dtPolyRef base = m_nav->getPolyRefBase(tile);
+	const unsigned int it = m_nav->decodePolyIdTile(base);
+
+	std::vector<float> centers(npolys*3);
+	for (int i = 0; i < npolys; ++i)
+		dtCalcPolyCenter(&centers[i*3], tile->polys[i].verts, tile->polys[i].vertCount, tile->verts);
+
+	dist.assign(npolys, FLT_MAX);
+
+	typedef std::pair<float, int> Item;
+	std::priority_queue<Item, std::vector<Item>, std::greater<Item> > open;
+	dist[start] = 0;
+	open.push(Item(0.0f, start));
+
+	while (!open.empty())
+	{
+		const Item top = open.top();
+		open.pop();
+		const int i = top.second;
+		if (top.first > dist[i])
+			continue;
+
+		const dtPoly* poly = &tile->polys[i];
+		const float* pa = i == start ? startPos : &centers[i*3];
+
+		for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+		{
+			const dtPolyRef nref = tile->links[k].ref;
+			if (!nref || m_nav->decodePolyIdTile(nref) != it)
+				continue;
+
+			const int j = (int)m_nav->decodePolyIdPoly(nref);
+			const dtPoly* npoly = &tile->polys[j];
+			if (!passFilter(m_filter, npoly))
+				continue;
+
+			const float cost = top.first + getCost(m_filter, pa, &centers[j*3], poly);
+			if (cost < dist[j])
+			{
+				dist[j] = cost;
+				open.push(Item(cost, j));
+			}
+		}
+	}
+}
+
+void NavHierarchy::buildCluster(const int tileIndex)
+{
+	Cluster& cluster = m_clusters[tileIndex];
+	cluster.built = false;
+	cluster.entrances.clear();
+	cluster.costs.clear();
+	cluster.polyEntrance.clear();
+
+	const dtMeshTile* tile = m_nav->getTile(tileIndex);
+	if (!tile || !tile->header)
+		return;
+
+	cluster.built = true;
+	cluster.salt = tile->salt;
+	cluster.polyRevision = tile->polyRevision;
+	cluster.x = tile->header->x;
+	cluster.y = tile->header->y;
+
+	const int npolys = tile->header->polyCount;
+	const dtPolyRef base = m_nav->getPolyRefBase(tile);
+	const unsigned int it = m_nav->decodePolyIdTile(base);
+	cluster.polyEntrance.assign(npolys, NO_ENTRANCE);
+
+	// The tiles this one links into.
+	std::vector<unsigned int> neighbours;
+	for (int i = 0; i < npolys; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+		if (!passFilter(m_filter, poly))
+			continue;
+		for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+		{
+			const dtPolyRef ref = tile->links[k].ref;
+			if (!ref)
+				continue;
+			const unsigned int nt = m_nav->decodePolyIdTile(ref);
+			if (nt != it && std::find(neighbours.begin(), neighbours.end(), nt) == neighbours.end())
+				neighbours.push_back(nt);
+		}
+	}
+
+	// Group the polygons that link into each neighbour into entrances of
+	// connected polygons.
+	std::vector<char> border(npolys);
+	std::vector<char> assigned(npolys);
+	std::vector<int> group;
+	for (size_t n = 0; n < neighbours.size(); ++n)
+	{
+		for (int i = 0; i < npolys; ++i)
+		{
+			const dtPoly* poly = &tile->polys[i];
+			border[i] = passFilter(m_filter, poly)
+				&& findCrossLink(m_nav, m_filter, tile, poly, neighbours[n]) != 0;
+			assigned[i] = 0;
+		}
+
+		for (int seed = 0; seed < npolys; ++seed)
+		{
+			if (!border[seed] || assigned[seed])
+				continue;
+
+			group.clear();
+			group.push_back(seed);
+			assigned[seed] = 1;
+			for (size_t h = 0; h < group.size(); ++h)
+			{
+				const dtPoly* poly = &tile->polys[group[h]];
+				for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+				{
+					if ((int)group.size() >= MAX_ENTRANCE_POLYS)
+						break;
+					const dtPolyRef ref = tile->links[k].ref;
+					if (!ref || m_nav->decodePolyIdTile(ref) != it)
+						continue;
+					const int j = (int)m_nav->decodePolyIdPoly(ref);
+					if (border[j] && !assigned[j])
+					{
+						assigned[j] = 1;
+						group.push_back(j);
+					}
+				}
+			}
+
+			if (cluster.entrances.size() >= NO_ENTRANCE)
+				continue;
+
+			// Place the entrance on the polygon closest to the middle of the group.
+			float centers[MAX_ENTRANCE_POLYS*3];
+			float mid[3] = { 0, 0, 0 };
+			for (size_t g = 0; g < group.size(); ++g)
+			{
+				const dtPoly* poly = &tile->polys[group[g]];
+				dtCalcPolyCenter(&centers[g*3], poly->verts, poly->vertCount, tile->verts);
+				dtVadd(mid, mid, &centers[g*3]);
+			}
+			dtVscale(mid, mid, 1.0f / (float)group.size());
+
+			int best = 0;
+			for (size_t g = 1; g < group.size(); ++g)
+			{
+				if (dtVdistSqr(&centers[g*3], mid) < dtVdistSqr(&centers[best*3], mid))
+					best = (int)g;
+			}
+
+			Entrance entrance;
+			entrance.ref = base | (dtPolyRef)group[best];
+			entrance.cross = findCrossLink(m_nav, m_filter, tile, &tile->polys[group[best]], neighbours[n]);
+			dtVcopy(entrance.pos, &centers[best*3]);
+
+			const unsigned short index = (unsigned short)cluster.entrances.size();
+			cluster.entrances.push_back(entrance);
+			for (size_t g = 0; g < group.size(); ++g)
+			{
+				if (cluster.polyEntrance[group[g]] == NO_ENTRANCE)
+					cluster.polyEntrance[group[g]] = index;
+			}
+		}
+	}
+
+	// The cost from each entrance to every other, without leaving the tile.
+	const int nent = (int)cluster.entrances.size();
+	cluster.costs.assign(nent*nent, FLT_MAX);
+	std::vector<float> dist;
+	for (int a = 0; a < nent; ++a)
+	{
+		const Entrance& entrance = cluster.entrances[a];
+		searchTile(tile, (int)m_nav->decodePolyIdPoly(entrance.ref), entrance.pos, dist);
+		for (int b = 0; b < nent; ++b)
+			cluster.costs[a*nent+b] = dist[m_nav->decodePolyIdPoly(cluster.entrances[b].ref)];
+	}
+}
+
+int NavHierarchy::getNodeCount() const
+{
+	int count = 0;
+	for (size_t i = 0; i < m_clusters.size(); ++i)
+		count += (int)m_clusters[i].entrances.size();
+	return count;
+}
+
+// Appends the path from the polygon to the target.  Returns false if the
+// target was not reached.
+static bool appendSegment(const dtNavMeshQuery* query
+	, const dtPolyRef from, const dtPolyRef to
+	, const float* fromPos, const float* toPos
+	, const dtQueryFilter* filter
+	, std::vector<dtPolyRef>& segment
+	, std::vector<dtPolyRef>& result)
+{
+	int count = 0;
+	const dtStatus status = query->findPath(from, to, fromPos, toPos, filter
+		, &segment[0], &count, (int)segment.size());
+	if (dtStatusFailed(status) || count == 0)
+		return false;
+
+	const int first = !result.empty() && result.back() == segment[0] ? 1 : 0;
+	result.insert(result.end(), segment.begin() + first, segment.begin() + count);
+
+	return segment[count-1] == to && !dtStatusDetail(status, DT_BUFFER_TOO_SMALL);
+}
+
+dtStatus NavHierarchy::findPath(dtNavMeshQuery* query
+	, dtPolyRef startRef, dtPolyRef endRef
+	, const float* startPos, const float* endPos
+	, const dtQueryFilter* filter
+	, dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	if (!pathCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	*pathCount = 0;
+
+	if (!m_nav || !query || !startPos || !endPos || !filter || !path || maxPath <= 0
+		|| !m_nav->isValidPolyRef(startRef) || !m_nav->isValidPolyRef(endRef))
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
+	const unsigned int st = m_nav->decodePolyIdTile(startRef);
+	const unsigned int et = m_nav->decodePolyIdTile(endRef);
+
+	// Nearby tiles are cheap to search directly, and tiles that changed since
+	// the last update have to be.
+	if (!isCurrent(st) || !isCurrent(et)
+		|| (abs(m_clusters[st].x - m_clusters[et].x) <= 1 && abs(m_clusters[st].y - m_clusters[et].y) <= 1))
+	{
+		return query->findPath(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+	}
+
+	std::vector<float> startDist;
+	std::vector<float> endDist;
+	searchTile(m_nav->getTile((int)st), (int)m_nav->decodePolyIdPoly(startRef), startPos, startDist);
+	searchTile(m_nav->getTile((int)et), (int)m_nav->decodePolyIdPoly(endRef), endPos, endDist);
+
+	// A* over the entrances, from the ones the start can reach to the ones
+	// that can reach the end.
+	struct Node
+	{
+		unsigned int tile;
+		unsigned short entrance;
+		bool closed;
+		int parent;
+		float g;
+	};
+
+	std::vector<Node> nodes;
+	std::unordered_map<unsigned long long, int> lookup;
+	typedef std::pair<float, int> Item;
+	std::priority_queue<Item, std::vector<Item>, std::greater<Item> > open;
+
+	float goalCost = FLT_MAX;
+	int goalParent = -1;
+
+	// Adds or improves an entrance node.  (Nodes are reopened when improved.)
+	auto relax = [&](const unsigned int tile, const unsigned short entrance, const float g, const int parent)
+	{
+		const unsigned long long key = ((unsigned long long)tile << 16) | entrance;
+		std::unordered_map<unsigned long long, int>::iterator found = lookup.find(key);
+		int idx;
+		if (found == lookup.end())
+		{
+			idx = (int)nodes.size();
+			Node n;
+			n.tile = tile;
+			n.entrance = entrance;
+			n.closed = false;
+			n.parent = parent;
+			n.g = g;
+			nodes.push_back(n);
+			lookup[key] = idx;
+		}
+		else
+		{
+			idx = found->second;
+			if (g >= nodes[idx].g)
+				return;
+			nodes[idx].g = g;
+			nodes[idx].parent = parent;
+			nodes[idx].closed = false;
+		}
+		const float* pos = m_clusters[tile].entrances[entrance].pos;
+		open.push(Item(g + dtVdist(pos, endPos)*H_SCALE, idx));
+	};
+
+	const Cluster& startCluster = m_clusters[st];
+	for (size_t e = 0; e < startCluster.entrances.size(); ++e)
+	{
+		const float d = startDist[m_nav->decodePolyIdPoly(startCluster.entrances[e].ref)];
+		if (d < FLT_MAX)
+			relax(st, (unsigned short)e, d, -1);
+	}
+
+	while (!open.empty())
+	{
+		const Item top = open.top();
+		open.pop();
+		if (top.first >= goalCost)
+			break;
+
+		const int idx = top.second;
+		if (nodes[idx].closed)
+			continue;
+		nodes[idx].closed = true;
+
+		const unsigned int t = nodes[idx].tile;
+		const unsigned short e = nodes[idx].entrance;
+		const float g = nodes[idx].g;
+		const Cluster& cluster = m_clusters[t];
+		const Entrance& entrance = cluster.entrances[e];
+		const int nent = (int)cluster.entrances.size();
+
+		if (t == et)
+		{
+			const float d = endDist[m_nav->decodePolyIdPoly(entrance.ref)];
+			if (d < FLT_MAX && g + d < goalCost)
+			{
+				goalCost = g + d;
+				goalParent = idx;
+			}
+		}
+
+		for (int e2 = 0; e2 < nent; ++e2)
+		{
+			const float c = cluster.costs[e*nent+e2];
+			if (e2 != e && c < FLT_MAX)
+				relax(t, (unsigned short)e2, g + c, idx);
+		}
+
+		const unsigned int u = m_nav->decodePolyIdTile(entrance.cross);
+		if (!entrance.cross || !isCurrent(u) || !m_nav->isValidPolyRef(entrance.cross))
+			continue;
+		const unsigned short e3 = m_clusters[u].polyEntrance[m_nav->decodePolyIdPoly(entrance.cross)];
+		if (e3 == NO_ENTRANCE)
+			continue;
+
+		const dtMeshTile* tile = 0;
+		const dtPoly* poly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(entrance.ref, &tile, &poly);
+		const float c = getCost(m_filter, entrance.pos, m_clusters[u].entrances[e3].pos, poly);
+		relax(u, e3, g + c, idx);
+	}
+
+	// No route through the graph.  Let the plain search find the best partial path.
+	if (goalParent < 0)
+		return query->findPath(startRef, endRef, startPos, endPos, filter, path, pathCount, maxPath);
+
+	std::vector<int> route;
+	for (int i = goalParent; i >= 0; i = nodes[i].parent)
+		route.push_back(i);
+	std::reverse(route.begin(), route.end());
+
+	// The polygons the route crosses into other tiles at.
+	std::vector<dtPolyRef> crossings;
+	for (size_t k = 0; k + 1 < route.size(); ++k)
+	{
+		const Node& node = nodes[route[k]];
+		if (nodes[route[k+1]].tile != node.tile)
+			crossings.push_back(m_clusters[node.tile].entrances[node.entrance].cross);
+	}
+
+	// Refine a few tiles at a time, from crossing to crossing.  The search
+	// picks its own way through the tiles in between, which keeps the path
+	// from bending through every entrance.
+	std::vector<dtPolyRef> segment(MAX_SEGMENT_PATH);
+	std::vector<dtPolyRef> result;
+	dtPolyRef cur = startRef;
+	float curPos[3];
+	dtVcopy(curPos, startPos);
+	bool reached = true;
+
+	for (size_t k = REFINE_TILES - 1; k < crossings.size() && reached; k += REFINE_TILES)
+	{
+		float pos[3];
+		getPolyCenter(m_nav, crossings[k], pos);
+		reached = appendSegment(query, cur, crossings[k], curPos, pos, filter, segment, result);
+		cur = crossings[k];
+		dtVcopy(curPos, pos);
+	}
+	if (reached)
+		reached = appendSegment(query, cur, endRef, curPos, endPos, filter, segment, result);
+
+	if (result.empty())
+		return DT_FAILURE;
+
+	// Segments can double back near the entrances.  Cut out the loops.
+	std::vector<dtPolyRef> out;
+	std::unordered_map<dtPolyRef, int> seen;
+	for (size_t i = 0; i < result.size(); ++i)
+	{
+		std::unordered_map<dtPolyRef, int>::iterator found = seen.find(result[i]);
+		if (found == seen.end())
+		{
+			seen[result[i]] = (int)out.size();
+			out.push_back(result[i]);
+			continue;
+		}
+		const int keep = found->second + 1;
+		for (size_t j = keep; j < out.size(); ++j)
+			seen.erase(out[j]);
+		out.resize(keep);
+	}
+
+	dtStatus status = DT_SUCCESS;
+	if (!reached)
+		status |= DT_PARTIAL_RESULT;
+
+	int count = (int)out.size();
+	if (count > maxPath)
+	{
+		count = maxPath;
+		status |= DT_BUFFER_TOO_SMALL;
+	}
+	memcpy(path, &out[0], sizeof(dtPolyRef)*count);
+	*pathCount = count;
+
+	return status;
+}
+
+extern "C"
+{
+	// Builds the hierarchy for every tile in the mesh.  The filter decides
+	// which polygons the graph uses and its costs.
+	EXPORT_API dtStatus dtnhAlloc(dtNavMesh* navmesh
+		, const dtQueryFilter* filter
+		, NavHierarchy** result)
+	{
+		if (!navmesh || !filter || !result)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		NavHierarchy* hierarchy = new(std::nothrow) NavHierarchy();
+		if (!hierarchy)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+		dtStatus status = hierarchy->init(navmesh, filter);
+		if (dtStatusFailed(status))
+		{
+			delete hierarchy;
+			return status;
+		}
+
+		*result = hierarchy;
+
+		return DT_SUCCESS;
+	}
+
+	EXPORT_API void dtnhFree(NavHierarchy* hierarchy)
+	{
+		delete hierarchy;
+	}
+
+	// Rebuilds the tiles added or removed since the last update, and their
+	// neighbours.
+	EXPORT_API dtStatus dtnhUpdate(NavHierarchy* hierarchy, int* rebuiltCount)
+	{
+		if (!hierarchy)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return hierarchy->update(rebuiltCount);
+	}
+
+	EXPORT_API int dtnhGetNodeCount(NavHierarchy* hierarchy)
+	{
+		return hierarchy ? hierarchy->getNodeCount() : 0;
+	}
+
+	EXPORT_API dtStatus dtnhFindPath(NavHierarchy* hierarchy
+		, dtNavMeshQuery* query
+		, rcnNavmeshPoint startPos
+		, rcnNavmeshPoint endPos
+		, const dtQueryFilter* filter
+		, dtPolyRef* path
+		, int* pathCount
+		, const int maxPath)
+	{
+		if (!hierarchy)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		return hierarchy->findPath(query
+			, startPos.polyRef
+			, endPos.polyRef
+			, &startPos.point[0]
+			, &endPos.point[0]
+			, filter
+			, path
+			, pathCount
+			, maxPath);
+	}
+}
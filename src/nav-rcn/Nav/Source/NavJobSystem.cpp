@@ -0,0 +1,98 @@
+#include "NavJobSystem.h"
+#include "DetourCommon.h"
+
+NavJobSystem::NavJobSystem(const int minParallelCount)
+	: m_minParallelCount(minParallelCount)
+	, m_job(0)
+	, m_ctx(0)
+	, m_count(0)
+	, m_chunk(1)
+	, m_generation(0)
+	, m_running(0)
+	, m_quit(false)
+{
+	m_next = 0;
+}
+
+NavJobSystem::~NavJobSystem()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_quit = true;
+	}
+	m_start.notify_all();
+	for (size_t i = 0; i < m_threads.size(); ++i)
+		m_threads[i].join();
+}
+
+void NavJobSystem::startThreads(const int threadCount)
+{
+	for (int i = 1; i < threadCount; ++i)
+		m_threads.push_back(std::thread(&NavJobSystem::workerMain, this, i));
+}
+
+void NavJobSystem::run(JobFunc job, void* ctx, const int count)
+{
+	if (count <= 0)
+		return;
+
+	// Small batches are not worth waking the workers for.
+	if (m_threads.empty() || count < m_minParallelCount)
+	{
+		job(ctx, 0, count, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_job = job;
+		m_ctx = ctx;
+		m_count = count;
+		m_chunk = dtMax(1, count / (getThreadCount() * 8));
+		m_next = 0;
+		m_running = (int)m_threads.size();
+		m_generation++;
+	}
+	m_start.notify_all();
+
+	work(0);
+
+	std::unique_lock<std::mutex> guard(m_lock);
+	m_finished.wait(guard, [this] { return m_running == 0; });
+}
+
+void NavJobSystem::work(const int thread)
+{
+	for (;;)
+	{
+		const int begin = m_next.fetch_add(m_chunk);
+		if (begin >= m_count)
+			break;
+		m_job(m_ctx, begin, dtMin(begin + m_chunk, m_count), thread);
+	}
+}
+
+void NavJobSystem::workerMain(const int thread)
+{
+	unsigned int generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(m_lock);
+			m_start.wait(guard, [&] { return m_quit || m_generation != generation; });
+			if (m_quit)
+				return;
+			generation = m_generation;
+		}
+
+		work(thread);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			last = --m_running == 0;
+		}
+		if (last)
+			m_finished.notify_one();
+	}
+}
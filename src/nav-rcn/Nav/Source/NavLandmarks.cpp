@@ -0,0 +1,545 @@
+#include "NavLandmarks.h"
+#include "DetourCommon.h"
+#include "DetourNode.h"
+#include "DetourEx.h"
+#include <float.h>
+#include <string.h>
+#include <new>
+
+static const int NAV_LANDMARKS_MAGIC = 'N'<<24 | 'A'<<16 | 'V'<<8 | 'L';
+static const int NAV_LANDMARKS_VERSION = 1;
+
+struct NavLandmarksHeader
+{
+	int magic;
+	int version;
+	int maxLandmarks;
+	int landmarkCount;
+	int tableCount;
+};
+
+struct NavLandmarksTableHeader
+{
+	dtTileRef tileRef;
+	int polyCount;
+};
+
+// dtQueryFilter's polygon test is inline in DetourNavMeshQuery.cpp, so it is
+// repeated here for the default, non-virtual filter.
+static inline bool passFilter(const dtQueryFilter& filter, const dtPoly* poly)
+{
+	return (poly->flags & filter.getIncludeFlags()) != 0 && (poly->flags & filter.getExcludeFlags()) == 0;
+}
+
+// Runs a Dijkstra search over the whole mesh from the center of the polygon.
+// The costs are the ones dtNavMeshQuery::findPath uses.
+static int searchFrom(const dtNavMeshQuery* query, const dtNavMesh* nav, const dtQueryFilter* filter
+	, const dtPolyRef ref, std::vector<dtPolyRef>& refs, std::vector<float>& costs)
+{
+	const dtMeshTile* tile = 0;
+	const dtPoly* poly = 0;
+	nav->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+
+	float center[3];
+	dtCalcPolyCenter(center, poly->verts, poly->vertCount, tile->verts);
+
+	int count = 0;
+	query->findPolysAroundCircle(ref, center, FLT_MAX, filter
+		, &refs[0], 0, &costs[0], &count, (int)refs.size());
+	return count;
+}
+
+// Sets the most a move between two points in each polygon can cost.  The table
+// costs are to a single point in the polygon, so the bound gives this up for
+// both the polygon and the goal.  (This does not make it a strict lower bound.
+// See NavLandmarks.)
+static void buildSlack(const dtMeshTile* tile, const dtQueryFilter& filter, std::vector<float>& slack)
+{
+	slack.resize(tile->header->polyCount);
+	for (int i = 0; i < tile->header->polyCount; ++i)
+	{
+		const dtPoly* poly = &tile->polys[i];
+
+		float center[3];
+		dtCalcPolyCenter(center, poly->verts, poly->vertCount, tile->verts);
+
+		float radius = 0;
+		for (int j = 0; j < poly->vertCount; ++j)
+			radius = dtMax(radius, dtVdist(center, &tile->verts[poly->verts[j]*3]));
+
+		slack[i] = 2*radius*filter.getAreaCost(poly->getArea());
+	}
+}
+
+NavLandmarks::NavLandmarks()
+	: m_nav(0)
+	, m_maxLandmarks(0)
+{
+}
+
+NavLandmarks::~NavLandmarks()
+{
+}
+
+dtStatus NavLandmarks::init(const dtNavMesh* nav, const dtQueryFilter* filter, const int landmarkCount)
+{
+	if (!nav || !filter || landmarkCount <= 0 || landmarkCount >= DT_MAX_HEURISTIC_GOAL)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	m_nav = nav;
+	m_filter = *filter;
+	m_maxLandmarks = landmarkCount;
+	m_landmarks.clear();
+
+	return build();
+}
+
+dtStatus NavLandmarks::update(int* changedCount)
+{
+	if (changedCount)
+		*changedCount = 0;
+
+	if (!m_nav)
+		return DT_FAILURE;
+
+	// The costs through a changed tile can change anywhere on the mesh, so
+	// any change means searching again from every landmark.
+	int count = 0;
+	for (int i = 0; i < m_nav->getMaxTiles(); ++i)
+	{
+		if (!isCurrent(i))
+			count++;
+	}
+
+	if (!count)
+		return DT_SUCCESS;
+
+	const dtStatus status = build();
+
+	if (changedCount)
+		*changedCount = count;
+
+	return status;
+}
+
+bool NavLandmarks::isCurrent(const int tileIndex) const
+{
+	const dtMeshTile* tile = m_nav->getTile(tileIndex);
+	const bool exists = tile && tile->header;
+	const TileTable& table = m_tables[tileIndex];
+	return exists == table.built && (!exists || tile->salt == table.salt);
+}
+
+dtStatus NavLandmarks::build()
+{
+	const int maxTiles = m_nav->getMaxTiles();
+	m_tables.assign(maxTiles, TileTable());
+
+	int polyCount = 0;
+	for (int i = 0; i < maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		if (!tile || !tile->header)
+			continue;
+
+		TileTable& table = m_tables[i];
+		table.built = true;
+		table.salt = tile->salt;
+		table.costs.assign(tile->header->polyCount * m_maxLandmarks, FLT_MAX);
+		buildSlack(tile, m_filter, table.slack);
+		polyCount += tile->header->polyCount;
+	}
+
+	// Landmarks that are still on the mesh are kept.
+	std::vector<dtPolyRef> landmarks;
+	for (size_t i = 0; i < m_landmarks.size(); ++i)
+	{
+		if (m_nav->isValidPolyRef(m_landmarks[i]))
+			landmarks.push_back(m_landmarks[i]);
+	}
+	m_landmarks.clear();
+
+	if (!polyCount)
+		return DT_SUCCESS;
+
+	dtNavMeshQuery* query = dtAllocNavMeshQuery();
+	if (!query)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	dtStatus status = query->init(m_nav, dtMin(polyCount + 1, (1 << DT_NODE_PARENT_BITS) - 1));
+	if (dtStatusFailed(status))
+	{
+		dtFreeNavMeshQuery(query);
+		return status;
+	}
+
+	std::vector<dtPolyRef> refs(polyCount);
+	std::vector<float> costs(polyCount);
+
+	if (landmarks.empty())
+	{
+		// The first landmark is the polygon farthest from a start in the
+		// largest island, so the landmarks aren't spent on small ones.
+		std::vector<int> offsets(maxTiles, 0);
+		int usable = 0;
+		for (int i = 0, offset = 0; i < maxTiles; ++i)
+		{
+			offsets[i] = offset;
+			const dtMeshTile* tile = m_nav->getTile(i);
+			if (!tile || !tile->header)
+				continue;
+			offset += tile->header->polyCount;
+			for (int j = 0; j < tile->header->polyCount; ++j)
+			{
+				if (passFilter(m_filter, &tile->polys[j]))
+					usable++;
+			}
+		}
+
+		std::vector<char> reached(polyCount, 0);
+		int bestCount = 0;
+		dtPolyRef first = 0;
+		for (int i = 0; i < maxTiles && bestCount < usable; ++i)
+		{
+			const dtMeshTile* tile = m_nav->getTile(i);
+			if (!tile || !tile->header)
+				continue;
+			for (int j = 0; j < tile->header->polyCount && bestCount < usable; ++j)
+			{
+				if (reached[offsets[i] + j] || !passFilter(m_filter, &tile->polys[j]))
+					continue;
+
+				const int n = searchFrom(query, m_nav, &m_filter
+					, m_nav->getPolyRefBase(tile) | (dtPolyRef)j, refs, costs);
+				int farthest = 0;
+				for (int k = 0; k < n; ++k)
+				{
+					const unsigned int it = m_nav->decodePolyIdTile(refs[k]);
+					char& r = reached[offsets[it] + m_nav->decodePolyIdPoly(refs[k])];
+					if (!r && passFilter(m_filter, m_nav->getTile(it)->polys + m_nav->decodePolyIdPoly(refs[k])))
+						usable--;
+					r = 1;
+					if (costs[k] > costs[farthest])
+						farthest = k;
+				}
+				if (n > bestCount)
+				{
+					bestCount = n;
+					first = refs[farthest];
+				}
+			}
+		}
+
+		if (first)
+			landmarks.push_back(first);
+	}
+
+	for (int k = 0; k < m_maxLandmarks && k <= (int)landmarks.size(); ++k)
+	{
+		if (k == (int)landmarks.size())
+		{
+			// The next landmark is the polygon farthest from the ones so far.
+			dtPolyRef best = 0;
+			float bestCost = 0;
+			for (int i = 0; i < maxTiles; ++i)
+			{
+				const TileTable& table = m_tables[i];
+				if (!table.built)
+					continue;
+				const dtPolyRef base = m_nav->getPolyRefBase(m_nav->getTile(i));
+				const int npolys = (int)table.costs.size() / m_maxLandmarks;
+				for (int j = 0; j < npolys; ++j)
+				{
+					const float* c = &table.costs[j*m_maxLandmarks];
+					float nearest = FLT_MAX;
+					for (int l = 0; l < k; ++l)
+						nearest = dtMin(nearest, c[l]);
+					if (nearest != FLT_MAX && nearest > bestCost)
+					{
+						bestCost = nearest;
+						best = base | (dtPolyRef)j;
+					}
+				}
+			}
+			if (!best)
+				break;
+			landmarks.push_back(best);
+		}
+
+		const int n = searchFrom(query, m_nav, &m_filter, landmarks[k], refs, costs);
+		for (int i = 0; i < n; ++i)
+		{
+			TileTable& table = m_tables[m_nav->decodePolyIdTile(refs[i])];
+			table.costs[m_nav->decodePolyIdPoly(refs[i])*m_maxLandmarks + k] = costs[i];
+		}
+	}
+
+	dtFreeNavMeshQuery(query);
+
+	m_landmarks.swap(landmarks);
+
+	return DT_SUCCESS;
+}
+
+const float* NavLandmarks::getCosts(dtPolyRef ref, float* slack) const
+{
+	const unsigned int it = m_nav->decodePolyIdTile(ref);
+	if (it >= m_tables.size())
+		return 0;
+
+	const TileTable& table = m_tables[it];
+	if (!table.built || table.salt != m_nav->decodePolyIdSalt(ref))
+		return 0;
+
+	const unsigned int ip = m_nav->decodePolyIdPoly(ref);
+	if (ip >= table.slack.size())
+		return 0;
+
+	*slack = table.slack[ip];
+	return &table.costs[ip * m_maxLandmarks];
+}
+
+bool NavLandmarks::getGoal(dtPolyRef ref, float* goal) const
+{
+	float slack;
+	const float* costs = getCosts(ref, &slack);
+	if (!costs || m_landmarks.empty())
+		return false;
+
+	// The goal's slack follows its costs.
+	memcpy(goal, costs, sizeof(float)*m_landmarks.size());
+	goal[m_landmarks.size()] = slack;
+	return true;
+}
+
+float NavLandmarks::getLowerBound(dtPolyRef ref, const float* goal) const
+{
+	float slack;
+	const float* costs = getCosts(ref, &slack);
+	if (!costs)
+		return 0;
+
+	// Landmarks that can't reach both polygons say nothing.
+	float bound = 0;
+	for (size_t k = 0; k < m_landmarks.size(); ++k)
+	{
+		if (costs[k] == FLT_MAX || goal[k] == FLT_MAX)
+			continue;
+		bound = dtMax(bound, dtAbs(goal[k] - costs[k]));
+	}
+	return dtMax(0.0f, bound - slack - goal[m_landmarks.size()]);
+}
+
+dtStatus NavLandmarks::getRawData(unsigned char** data, int* dataSize) const
+{
+	if (!data || !dataSize)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	*data = 0;
+	*dataSize = 0;
+
+	if (!m_nav)
+		return DT_FAILURE;
+
+	NavLandmarksHeader header;
+	header.magic = NAV_LANDMARKS_MAGIC;
+	header.version = NAV_LANDMARKS_VERSION;
+	header.maxLandmarks = m_maxLandmarks;
+	header.landmarkCount = (int)m_landmarks.size();
+	header.tableCount = 0;
+
+	int totalSize = sizeof(NavLandmarksHeader) + sizeof(dtPolyRef)*header.landmarkCount;
+	for (int i = 0; i < (int)m_tables.size(); ++i)
+	{
+		if (!isCurrent(i) || !m_tables[i].built)
+			continue;
+		header.tableCount++;
+		totalSize += sizeof(NavLandmarksTableHeader) + sizeof(float)*(int)m_tables[i].costs.size();
+	}
+
+	unsigned char* result = (unsigned char*)dtAlloc(totalSize, DT_ALLOC_PERM);
+	if (!result)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	int pos = 0;
+	memcpy(&result[pos], &header, sizeof(NavLandmarksHeader));
+	pos += sizeof(NavLandmarksHeader);
+
+	if (header.landmarkCount)
+	{
+		memcpy(&result[pos], &m_landmarks[0], sizeof(dtPolyRef)*header.landmarkCount);
+		pos += sizeof(dtPolyRef)*header.landmarkCount;
+	}
+
+	for (int i = 0; i < (int)m_tables.size(); ++i)
+	{
+		const TileTable& table = m_tables[i];
+		if (!isCurrent(i) || !table.built)
+			continue;
+
+		NavLandmarksTableHeader tableHeader;
+		tableHeader.tileRef = m_nav->getTileRef(m_nav->getTile(i));
+		tableHeader.polyCount = (int)table.costs.size() / m_maxLandmarks;
+		memcpy(&result[pos], &tableHeader, sizeof(NavLandmarksTableHeader));
+		pos += sizeof(NavLandmarksTableHeader);
+
+		const int size = sizeof(float)*(int)table.costs.size();
+		memcpy(&result[pos], &table.costs[0], size);
+		pos += size;
+	}
+
+	*data = result;
+	*dataSize = totalSize;
+
+	return DT_SUCCESS;
+}
+
+dtStatus NavLandmarks::initFromRawData(const dtNavMesh* nav, const dtQueryFilter* filter
+	, const unsigned char* data, const int dataSize)
+{
+	if (!nav || !filter || !data || dataSize < (int)sizeof(NavLandmarksHeader))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	NavLandmarksHeader header;
+	memcpy(&header, data, sizeof(NavLandmarksHeader));
+	int pos = sizeof(NavLandmarksHeader);
+
+	if (header.magic != NAV_LANDMARKS_MAGIC)
+		return DT_FAILURE | DT_WRONG_MAGIC;
+	if (header.version != NAV_LANDMARKS_VERSION)
+		return DT_FAILURE | DT_WRONG_VERSION;
+	if (header.maxLandmarks <= 0 || header.maxLandmarks >= DT_MAX_HEURISTIC_GOAL
+		|| header.landmarkCount < 0 || header.landmarkCount > header.maxLandmarks
+		|| header.tableCount < 0
+		|| dataSize - pos < (int)sizeof(dtPolyRef)*header.landmarkCount)
+	{
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
+	m_nav = nav;
+	m_filter = *filter;
+	m_maxLandmarks = header.maxLandmarks;
+	m_landmarks.resize(header.landmarkCount);
+	if (header.landmarkCount)
+		memcpy(&m_landmarks[0], &data[pos], sizeof(dtPolyRef)*header.landmarkCount);
+	pos += sizeof(dtPolyRef)*header.landmarkCount;
+
+	m_tables.assign(nav->getMaxTiles(), TileTable());
+
+	for (int i = 0; i < header.tableCount; ++i)
+	{
+		NavLandmarksTableHeader tableHeader;
+		if (dataSize - pos < (int)sizeof(NavLandmarksTableHeader))
+			return DT_FAILURE | DT_INVALID_PARAM;
+		memcpy(&tableHeader, &data[pos], sizeof(NavLandmarksTableHeader));
+		pos += sizeof(NavLandmarksTableHeader);
+
+		const int count = tableHeader.polyCount * m_maxLandmarks;
+		if (tableHeader.polyCount < 0 || dataSize - pos < (int)sizeof(float)*count)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		const dtMeshTile* tile = nav->getTileByRef(tableHeader.tileRef);
+		if (tile && tile->header && tile->header->polyCount == tableHeader.polyCount)
+		{
+			TileTable& table = m_tables[nav->decodePolyIdTile((dtPolyRef)tableHeader.tileRef)];
+			table.built = true;
+			table.salt = tile->salt;
+			table.costs.resize(count);
+			if (count)
+				memcpy(&table.costs[0], &data[pos], sizeof(float)*count);
+			buildSlack(tile, m_filter, table.slack);
+		}
+		pos += sizeof(float)*count;
+	}
+
+	return DT_SUCCESS;
+}
+
+extern "C"
+{
+	EXPORT_API dtStatus dtnlAlloc(dtNavMesh* navmesh
+		, const dtQueryFilter* filter
+		, const int landmarkCount
+		, NavLandmarks** result)
+	{
+		if (!navmesh || !filter || !result)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		NavLandmarks* landmarks = new(std::nothrow) NavLandmarks();
+		if (!landmarks)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+		dtStatus status = landmarks->init(navmesh, filter, landmarkCount);
+		if (dtStatusFailed(status))
+		{
+			delete landmarks;
+			return status;
+		}
+
+		*result = landmarks;
+
+		return DT_SUCCESS;
+	}
+
+	// Loads landmarks saved with dtnlGetRawData for a mesh loaded with
+	// dtnmBuildDTNavMeshFromRaw.
+	EXPORT_API dtStatus dtnlAllocFromRaw(dtNavMesh* navmesh
+		, const dtQueryFilter* filter
+		, const unsigned char* data
+		, const int dataSize
+		, NavLandmarks** result)
+	{
+		if (!navmesh || !filter || !result)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		NavLandmarks* landmarks = new(std::nothrow) NavLandmarks();
+		if (!landmarks)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+		dtStatus status = landmarks->initFromRawData(navmesh, filter, data, dataSize);
+		if (dtStatusFailed(status))
+		{
+			delete landmarks;
+			return status;
+		}
+
+		*result = landmarks;
+
+		return DT_SUCCESS;
+	}
+
+	EXPORT_API void dtnlFree(NavLandmarks* landmarks)
+	{
+		delete landmarks;
+	}
+
+	EXPORT_API dtStatus dtnlUpdate(NavLandmarks* landmarks, int* changedCount)
+	{
+		if (!landmarks)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return landmarks->update(changedCount);
+	}
+
+	EXPORT_API int dtnlGetLandmarkCount(NavLandmarks* landmarks)
+	{
+		return landmarks ? landmarks->getLandmarkCount() : 0;
+	}
+
+	// The data is freed with dtnmFreeBytes.
+	EXPORT_API dtStatus dtnlGetRawData(const NavLandmarks* landmarks
+		, unsigned char** resultData
+		, int* dataSize)
+	{
+		if (!landmarks)
+			return DT_FAILURE | DT_INVALID_PARAM;
+		return landmarks->getRawData(resultData, dataSize);
+	}
+
+	// Sets the landmarks used by the query's path searches.  (Null for none.)
+	EXPORT_API void dtqSetLandmarks(dtNavMeshQuery* query
+		, const NavLandmarks* landmarks)
+	{
+		if (query)
+			query->setHeuristic(landmarks);
+	}
+}
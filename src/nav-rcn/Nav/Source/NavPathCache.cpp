@@ -0,0 +1,338 @@
+#include "NavPathCache.h"
+#include "DetourEx.h"
+#include <string.h>
+#include <new>
+
+static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+static inline unsigned long long hashBytes(unsigned long long h, const void* data, const size_t size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i)
+	{
+		h ^= p[i];
+		h *= FNV_PRIME;
+	}
+	return h;
+}
+
+static unsigned long long hashFilter(const dtQueryFilter* filter)
+{
+	const unsigned short include = filter->getIncludeFlags();
+	const unsigned short exclude = filter->getExcludeFlags();
+
+	unsigned long long h = FNV_OFFSET;
+	h = hashBytes(h, &include, sizeof(include));
+	h = hashBytes(h, &exclude, sizeof(exclude));
+	for (int i = 0; i < DT_MAX_AREAS; ++i)
+	{
+		const float cost = filter->getAreaCost(i);
+		h = hashBytes(h, &cost, sizeof(cost));
+	}
+	return h;
+}
+
+size_t NavPathCache::KeyHash::operator()(const Key& k) const
+{
+	unsigned long long h = k.filter;
+	h = hashBytes(h, &k.startRef, sizeof(k.startRef));
+	h = hashBytes(h, &k.endRef, sizeof(k.endRef));
+	return (size_t)h;
+}
+
+NavPathCache::NavPathCache()
+	: m_nav(0)
+	, m_head(-1)
+	, m_tail(-1)
+	, m_hits(0)
+	, m_misses(0)
+{
+}
+
+NavPathCache::~NavPathCache()
+{
+}
+
+dtStatus NavPathCache::init(const dtNavMesh* nav, const int maxEntries)
+{
+	if (!nav || maxEntries <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	std::lock_guard<std::mutex> guard(m_lock);
+
+	m_nav = nav;
+	m_entries.assign(maxEntries, Entry());
+	m_free.resize(maxEntries);
+	for (int i = 0; i < maxEntries; ++i)
+		m_free[i] = maxEntries - 1 - i;
+	m_index.clear();
+	m_index.reserve(maxEntries);
+	m_head = -1;
+	m_tail = -1;
+	m_hits = 0;
+	m_misses = 0;
+
+	return DT_SUCCESS;
+}
+
+bool NavPathCache::isValid(const Entry& entry) const
+{
+	for (size_t i = 0; i < entry.tiles.size(); ++i)
+	{
+		const TileState& state = entry.tiles[i];
+		const dtMeshTile* tile = m_nav->getTile(state.index);
+		if (!tile->header || tile->salt != state.salt || tile->polyRevision != state.polyRevision)
+			return false;
+	}
+	return true;
+}
+
+void NavPathCache::unlink(const int i)
+{
+	Entry& entry = m_entries[i];
+	if (entry.prev != -1)
+		m_entries[entry.prev].next = entry.next;
+	else
+		m_head = entry.next;
+	if (entry.next != -1)
+		m_entries[entry.next].prev = entry.prev;
+	else
+		m_tail = entry.prev;
+}
+
+void NavPathCache::pushFront(const int i)
+{
+	Entry& entry = m_entries[i];
+	entry.prev = -1;
+	entry.next = m_head;
+	if (m_head != -1)
+		m_entries[m_head].prev = i;
+	else
+		m_tail = i;
+	m_head = i;
+}
+
+void NavPathCache::remove(const int i)
+{
+	unlink(i);
+	m_index.erase(m_entries[i].key);
+	m_entries[i].path.clear();
+	m_entries[i].tiles.clear();
+	m_free.push_back(i);
+}
+
+dtStatus NavPathCache::findPath(dtNavMeshQuery* query
+	, dtPolyRef startRef, dtPolyRef endRef
+	, const float* startPos, const float* endPos
+	, const dtQueryFilter* filter
+	, dtPolyRef* path, int* pathCount, const int maxPath)
+{
+	if (!m_nav || !query || !filter || !path || !pathCount || maxPath <= 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	*pathCount = 0;
+
+	Key key;
+	key.startRef = startRef;
+	key.endRef = endRef;
+	key.filter = hashFilter(filter);
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+
+		std::unordered_map<Key, int, KeyHash>::iterator it = m_index.find(key);
+		if (it != m_index.end())
+		{
+			const int i = it->second;
+			if (isValid(m_entries[i]))
+			{
+				unlink(i);
+				pushFront(i);
+				m_hits++;
+
+				const std::vector<dtPolyRef>& cached = m_entries[i].path;
+				dtStatus status = DT_SUCCESS;
+				int count = (int)cached.size();
+				if (count > maxPath)
+				{
+					count = maxPath;
+					status |= DT_BUFFER_TOO_SMALL;
+				}
+				memcpy(path, &cached[0], sizeof(dtPolyRef)*count);
+				*pathCount = count;
+
+				return status;
+			}
+			remove(i);
+		}
+		m_misses++;
+	}
+
+	const dtStatus status = query->findPath(startRef, endRef, startPos, endPos, filter
+		, path, pathCount, maxPath);
+
+	if (dtStatusFailed(status)
+		|| (status & (DT_PARTIAL_RESULT | DT_BUFFER_TOO_SMALL))
+		|| *pathCount == 0)
+	{
+		return status;
+	}
+
+	// Record the tiles before taking the lock.  Paths cross few tiles, so a
+	// linear search is enough to keep them unique.
+	std::vector<TileState> tiles;
+	for (int i = 0; i < *pathCount; ++i)
+	{
+		const int index = (int)m_nav->decodePolyIdTile(path[i]);
+		bool found = false;
+		for (int j = (int)tiles.size() - 1; j >= 0 && !found; --j)
+			found = tiles[j].index == index;
+		if (found)
+			continue;
+
+		const dtMeshTile* tile = m_nav->getTile(index);
+		TileState state;
+		state.index = index;
+		state.salt = tile->salt;
+		state.polyRevision = tile->polyRevision;
+		tiles.push_back(state);
+	}
+
+	std::lock_guard<std::mutex> guard(m_lock);
+
+	// Another thread may have stored the same path meanwhile.
+	std::unordered_map<Key, int, KeyHash>::iterator it = m_index.find(key);
+	if (it != m_index.end())
+		remove(it->second);
+
+	if (m_free.empty())
+		remove(m_tail);
+
+	const int i = m_free.back();
+	m_free.pop_back();
+
+	Entry& entry = m_entries[i];
+	entry.key = key;
+	entry.path.assign(path, path + *pathCount);
+	entry.tiles.swap(tiles);
+	pushFront(i);
+	m_index[key] = i;
+
+	return status;
+}
+
+void NavPathCache::clear()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	while (m_head != -1)
+		remove(m_head);
+}
+
+void NavPathCache::resetCounters()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_hits = 0;
+	m_misses = 0;
+}
+
+int NavPathCache::getHitCount() const
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_hits;
+}
+
+int NavPathCache::getMissCount() const
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_misses;
+}
+
+int NavPathCache::getEntryCount() const
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return (int)m_index.size();
+}
+
+extern "C"
+{
+	EXPORT_API dtStatus dtnpcAlloc(dtNavMesh* navmesh
+		, const int maxEntries
+		, NavPathCache** result)
+	{
+		if (!navmesh || !result)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		NavPathCache* cache = new(std::nothrow) NavPathCache();
+		if (!cache)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+		dtStatus status = cache->init(navmesh, maxEntries);
+		if (dtStatusFailed(status))
+		{
+			delete cache;
+			return status;
+		}
+
+		*result = cache;
+
+		return DT_SUCCESS;
+	}
+
+	EXPORT_API void dtnpcFree(NavPathCache* cache)
+	{
+		delete cache;
+	}
+
+	EXPORT_API dtStatus dtnpcFindPath(NavPathCache* cache
+		, dtNavMeshQuery* query
+		, rcnNavmeshPoint startPos
+		, rcnNavmeshPoint endPos
+		, const dtQueryFilter* filter
+		, dtPolyRef* path
+		, int* pathCount
+		, const int maxPath)
+	{
+		if (!cache)
+			return DT_FAILURE | DT_INVALID_PARAM;
+
+		return cache->findPath(query
+			, startPos.polyRef
+			, endPos.polyRef
+			, &startPos.point[0]
+			, &endPos.point[0]
+			, filter
+			, path
+			, pathCount
+			, maxPath);
+	}
+
+	EXPORT_API void dtnpcClear(NavPathCache* cache)
+	{
+		if (cache)
+			cache->clear();
+	}
+
+	// Gets the hit and miss counts since the cache was created or the
+	// counters were last reset.  Stale entries count as misses.
+	EXPORT_API void dtnpcGetCounters(const NavPathCache* cache
+		, int* hitCount
+		, int* missCount
+		, int* entryCount)
+	{
+		if (!cache)
+			return;
+		if (hitCount)
+			*hitCount = cache->getHitCount();
+		if (missCount)
+			*missCount = cache->getMissCount();
+		if (entryCount)
+			*entryCount = cache->getEntryCount();
+	}
+
+	EXPORT_API void dtnpcResetCounters(NavPathCache* cache)
+	{
+		if (cache)
+			cache->resetCounters();
+	}
+}
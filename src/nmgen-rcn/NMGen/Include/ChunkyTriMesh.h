@@ -27,16 +27,22 @@ struct rcChunkyTriMeshNode
 	int n;
 };
 
+struct rcChunkyTriMesh;
+
+/// Frees the nodes and triangles, or unmaps them if they were mapped.
+void rcFreeChunkyTriMeshData(rcChunkyTriMesh* cm);
+
 struct rcChunkyTriMesh
 {
-	inline rcChunkyTriMesh() : nodes(0), nnodes(0), tris(0), ntris(0), maxTrisPerChunk(0) {};
-	inline ~rcChunkyTriMesh() { delete [] nodes; delete [] tris; }
+	inline rcChunkyTriMesh() : nodes(0), nnodes(0), tris(0), ntris(0), maxTrisPerChunk(0), mapping(0) {};
+	inline ~rcChunkyTriMesh() { rcFreeChunkyTriMeshData(this); }
 
 	rcChunkyTriMeshNode* nodes;
 	int nnodes;
 	int* tris;
 	int ntris;
 	int maxTrisPerChunk;
+	void* mapping;	///< The file the nodes and triangles are mapped from, or null if allocated.
 
 private:
 	// Explicitly disabled copy constructor and copy assignment operator.
@@ -49,6 +55,26 @@ private:
 bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
 						   int trisPerChunk, rcChunkyTriMesh* cm);
 
+/// Hashes the input of rcCreateChunkyTriMesh, to check whether a saved mesh
+/// is still valid.
+unsigned long long rcHashChunkyTriMeshInput(const float* verts, int nverts,
+											const int* tris, int ntris, int trisPerChunk);
+
+/// Saves the mesh in a relocatable format that rcMapChunkyTriMesh can map
+/// without copying.
+bool rcSaveChunkyTriMesh(const rcChunkyTriMesh* cm, unsigned long long inputHash, const char* path);
+
+/// Maps a mesh saved by rcSaveChunkyTriMesh.  The nodes and triangles point
+/// into the mapped file until the mesh is destroyed.  Fails if the file is
+/// missing, invalid, or was saved for different input.  Only the nodes are
+/// checked here.  (See rcCheckChunkyTriMeshChunk.)
+bool rcMapChunkyTriMesh(const char* path, unsigned long long inputHash, rcChunkyTriMesh* cm);
+
+/// Checks that the triangles of a chunk only index the first nverts vertices.
+/// The triangles of a mapped mesh must be checked before they are used.
+/// (Always true for a mesh that was not mapped.)
+bool rcCheckChunkyTriMeshChunk(const rcChunkyTriMesh* cm, int chunk, int nverts);
+
 /// Returns the chunk indices which overlap the input rectable.
 int rcGetChunksOverlappingRect(const rcChunkyTriMesh* cm, float bmin[2], float bmax[2], int* ids, const int maxIds);
 
@@ -0,0 +1,54 @@
+#ifndef CAI_NMG_JOBSYSTEM_H
+#define CAI_NMG_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Recast.h"
+
+// A fixed pool of worker threads for rcContext::parallelFor.
+//
+// The calling thread works too, so a pool of N threads runs N - 1 workers.
+// Items are handed out one at a time, in increasing order, as the Recast
+// jobs require.
+//
+// Only one run happens at a time.  A run started while another one is in
+// progress is processed on the calling thread.
+class nmgJobSystem
+{
+public:
+    explicit nmgJobSystem(const int threadCount);
+    ~nmgJobSystem();
+
+    // The number of threads that run jobs, including the calling thread.
+    int getThreadCount() const { return (int)mThreads.size() + 1; }
+
+    // Runs job over the items [0, count) and returns when all are done.
+    void run(rcParallelForFunc job, void* data, const int count);
+
+private:
+    // Explicitly disabled copy constructor and copy assignment operator.
+    nmgJobSystem(const nmgJobSystem&);
+    nmgJobSystem& operator=(const nmgJobSystem&);
+
+    void work();
+    void workerMain();
+
+    std::vector<std::thread> mThreads;
+    std::mutex mRunLock;
+    std::mutex mLock;
+    std::condition_variable mStart;
+    std::condition_variable mFinished;
+
+    rcParallelForFunc mJob;
+    void* mData;
+    int mCount;
+    std::atomic<int> mNext;
+    unsigned int mGeneration;
+    int mRunning;
+    bool mQuit;
+};
+
+#endif
@@ -22,6 +22,9 @@
 #ifndef CAI_NMG_EX_H
 #define CAI_NMG_EX_H
 
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include "Recast.h"
 
 #if _MSC_VER    // TRUE for Microsoft compiler.
@@ -44,36 +47,136 @@ static const unsigned char NMG_ALLOC_TYPE_LOCAL = 1;
 // owner object.  It should only be freed by that object.
 static const unsigned char NMG_ALLOC_TYPE_MANAGED_LOCAL = 2;
 
+class nmgJobSystem;
+struct nmgProfileThread;
+struct nmgLogThread;
+
+// Formats for nmgBuildContext::getProfileReport.
+// Note: Keep in sync with the managed ProfileReportFormat enum.
+enum nmgProfileReportFormat
+{
+    NMG_PROFILE_JSON = 0,
+    NMG_PROFILE_CSV = 1,
+};
+
 class nmgBuildContext 
     : public rcContext
 {
 public:
-    static const int MAX_MESSAGES = 1024;
-    static const int MESSAGE_POOL_SIZE = 65536;
-
     nmgBuildContext();
     virtual ~nmgBuildContext();
-	
+
+    // The message getters merge the per-thread logs in the order the
+    // messages were logged.  Messages still being logged by other threads
+    // may be missing.  Messages are copied out, so they may be read while
+    // other threads log.
     int getMessageCount() const;
-    const char* getMessage(const int i) const;
 
+    // Copies message i, truncated to fit and null terminated.  Returns the
+    // length of the whole message, or -1 if i is out of range.
+    int getMessage(const int i, char* buffer, const int bufferSize) const;
+
+    // The messages, each null terminated, one after the other.
+    // getMessagePool copies as much of the pool as fits and returns the
+    // number of messages in it.  (Including a truncated last message.)
     int getMessagePoolLength() const;
-    const char* getMessagePool() const;
+    int getMessagePool(char* buffer, const int bufferSize) const;
 
     bool getLogEnabled() const { return m_logEnabled; }
 
+    // Sets the number of threads the build steps can use, including the
+    // calling thread.  (One per hardware core if threadCount <= 0.)
+    // Returns false if out of memory.
+    bool setThreadCount(int threadCount);
+
+    // Enables the per-stage timers and memory peaks.  Enabling clears the
+    // previous profile.  Memory is only tracked while a context has its
+    // profile enabled.  Only call between builds.
+    void setProfileEnabled(bool state);
+    bool getProfileEnabled() const { return m_timerEnabled; }
+
+    // Attributes the stage times and memory of the calling thread to a tile
+    // until endTile.  (See nmgTileProfileScope.)
+    void beginTile(int tx, int ty);
+    void endTile();
+
+    // Writes the profile in a nmgProfileReportFormat.  Returns the length
+    // of the whole report.  The buffer gets as much as fits, null terminated.
+    int getProfileReport(int format, char* buffer, int bufferSize) const;
+
 protected:
     virtual void doResetLog();
     virtual void doLog(const rcLogCategory category
         , const char* msg
         , const int len);
+    virtual void doParallelFor(rcParallelForFunc func
+        , void* data
+        , const int count);
+    virtual int doGetThreadCount() const;
+    virtual void doResetTimers();
+    virtual void doStartTimer(const rcTimerLabel label);
+    virtual void doStopTimer(const rcTimerLabel label);
+    virtual int doGetAccumulatedTime(const rcTimerLabel label) const;
+
+private:
+    // Each thread appends its messages to its own chain of blocks and
+    // publishes them with a release store, so logging never takes a lock
+    // after a thread's first message.  The readers merge the chains by
+    // sequence number.  The lock guards the list of threads and the merged
+    // copy.  (Same thread lookup as the profile.)  Resets must not overlap
+    // with logging.
+    mutable std::mutex mLogLock;
+    std::vector<nmgLogThread*> mLogThreads;
+    unsigned int mLogId;
+    std::atomic<unsigned int> mLogSequence;
+
+    // The merged messages and their offsets into the pool.
+    mutable std::vector<char> mMergedPool;
+    mutable std::vector<int> mMergedMessages;
+
+    nmgLogThread* getLogThread();
+    void clearLog();
+    void mergeLog() const;
+
+    nmgJobSystem* mJobs;
+
+    // The timers of each thread that has used the context, so tile builds
+    // on several threads don't share timer state.  The lock only guards
+    // the list.  Each thread finds its own entry through a thread local
+    // cache keyed on mProfileId.
+    mutable std::mutex mProfileLock;
+    std::vector<nmgProfileThread*> mProfileThreads;
+    unsigned int mProfileId;
+
+    // True while the context holds an rcSetMemoryTracking(true) call.
+    bool mMemoryTracked;
+
+    nmgProfileThread* getProfileThread();
+    void clearProfile();
+};
+
+// Profiles a tile build on the calling thread for the lifetime of the scope.
+class nmgTileProfileScope
+{
+public:
+    nmgTileProfileScope(nmgBuildContext* ctx, int tx, int ty)
+        : mCtx(ctx->getProfileEnabled() ? ctx : 0)
+    {
+        if (mCtx)
+            mCtx->beginTile(tx, ty);
+    }
+
+    ~nmgTileProfileScope()
+    {
+        if (mCtx)
+            mCtx->endTile();
+    }
 
 private:
-    const char* mMessages[MAX_MESSAGES];
-    int mMessageCount;
+    nmgTileProfileScope(const nmgTileProfileScope&);
+    nmgTileProfileScope& operator=(const nmgTileProfileScope&);
 
-    char mTextPool[MESSAGE_POOL_SIZE];
-    int mTextPoolSize;
+    nmgBuildContext* mCtx;
 };
 
 template<class T> inline bool nmgSloppyEquals(T a, T b) 
@@ -158,4 +261,37 @@ struct rcConfig
 	float detailSampleMaxError;
 };
 
+struct rcChunkyTriMesh;
+
+/// Callback used to compress a rasterized layer into tile cache format.
+typedef bool (*BuildTileCacheLayerFunc)(
+	int tx, int ty, int i,
+	const float *bmin, const float *bmax,
+	int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
+	unsigned char *heights, unsigned char *areas, unsigned char *cons,
+	TileCacheData *tile);
+
+/// Entry points used by multi-threaded tile cache builds.
+///
+/// Each worker allocates its own rasterization context and reuses it for
+/// every tile it processes.  The context is opaque to the caller.
+/// pCtx is the build context given to the tile cache build.
+/// rasterizeTileLayers returns the number of layers, or -1 if the tile
+/// could not be built.
+/// @note Keep this layout in sync with the copy in DetourTileCacheEx.cpp.
+struct TileRasterizer
+{
+	void* (*allocContext)();
+	void (*freeContext)(void* rc);
+	int (*rasterizeTileLayers)(
+		nmgBuildContext *pCtx, void *rc,
+		int tx, int ty,
+		rcConfig *cfg,
+		TileCacheData* tiles, int maxTiles,
+		float *verts, int nverts,
+		rcChunkyTriMesh *chunkyMesh,
+		bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+		BuildTileCacheLayerFunc buildTileCacheLayer);
+};
+
 #endif
@@ -19,73 +19,687 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <new>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
 #include "NMGen.h"
+#include "JobSystem.h"
+#include "RecastAlloc.h"
 
-void nmgTransferMessages(const nmgBuildContext* context
-    , unsigned char* messageBuffer
-    , int messageBufferSize)
+// Stage names for the profile report.  Indexed by rcTimerLabel.
+static const char* const sTimerNames[RC_MAX_TIMERS] =
 {
-    if (context && context->getMessageCount() > 0)
+    "TOTAL",
+    "TEMP",
+    "RASTERIZE_TRIANGLES",
+    "BUILD_COMPACTHEIGHTFIELD",
+    "BUILD_CONTOURS",
+    "BUILD_CONTOURS_TRACE",
+    "BUILD_CONTOURS_SIMPLIFY",
+    "FILTER_BORDER",
+    "FILTER_WALKABLE",
+    "MEDIAN_AREA",
+    "FILTER_LOW_OBSTACLES",
+    "BUILD_POLYMESH",
+    "MERGE_POLYMESH",
+    "ERODE_AREA",
+    "MARK_BOX_AREA",
+    "MARK_CYLINDER_AREA",
+    "MARK_CONVEXPOLY_AREA",
+    "BUILD_DISTANCEFIELD",
+    "BUILD_DISTANCEFIELD_DIST",
+    "BUILD_DISTANCEFIELD_BLUR",
+    "BUILD_REGIONS",
+    "BUILD_REGIONS_WATERSHED",
+    "BUILD_REGIONS_EXPAND",
+    "BUILD_REGIONS_FLOOD",
+    "BUILD_REGIONS_FILTER",
+    "BUILD_LAYERS",
+    "BUILD_POLYMESHDETAIL",
+    "MERGE_POLYMESHDETAIL",
+};
+
+// Times are kept in nanoseconds and reported in microseconds.
+static inline long long profileNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct nmgProfileTimer
+{
+    long long start;
+    long long total;
+    long long max;
+    int calls;
+};
+
+struct nmgProfileTile
+{
+    int tx;
+    int ty;
+    int thread;
+    long long wall;
+    long long peakMemory;
+    long long times[RC_MAX_TIMERS];
+};
+
+struct nmgProfileThread
+{
+    int index;
+    nmgProfileTimer timers[RC_MAX_TIMERS];
+
+    // The tile in progress.  Stage times are taken as the difference from
+    // the totals at the start of the tile.
+    bool inTile;
+    nmgProfileTile tile;
+    long long tileStart;
+    long long tileBase[RC_MAX_TIMERS];
+
+    std::thread::id owner;
+    std::vector<nmgProfileTile> tiles;
+};
+
+// Log entries are a header, then the null terminated text, padded to the
+// header alignment.
+struct nmgLogEntry
+{
+    unsigned int sequence;
+    int size;   // Text length, including the terminator.
+};
+
+static const int LOG_BLOCK_SIZE = 16 * 1024;
+
+// The block space taken by an entry with the given text size.
+static inline int logEntrySize(const int textSize)
+{
+    const int align = (int)sizeof(nmgLogEntry);
+    return ((int)sizeof(nmgLogEntry) + textSize + align - 1) & ~(align - 1);
+}
+
+struct nmgLogBlock
+{
+    std::atomic<nmgLogBlock*> next;
+    std::atomic<int> used;  // Bytes published to readers.
+    int capacity;
+
+    char* data() { return (char*)(this + 1); }
+};
+
+struct nmgLogThread
+{
+    std::thread::id owner;
+    nmgLogBlock* head;
+    nmgLogBlock* tail;  // Only touched by the owner.
+};
+
+static nmgLogBlock* allocLogBlock(int capacity)
+{
+    void* mem = ::operator new(sizeof(nmgLogBlock) + capacity, std::nothrow);
+    if (!mem)
+        return 0;
+    nmgLogBlock* block = new(mem) nmgLogBlock();
+    block->next.store(0, std::memory_order_relaxed);
+    block->used.store(0, std::memory_order_relaxed);
+    block->capacity = capacity;
+    return block;
+}
+
+static void freeLogThread(nmgLogThread* thread)
+{
+    nmgLogBlock* block = thread->head;
+    while (block)
     {
-        int size = (messageBufferSize < context->getMessagePoolLength()
-            ? messageBufferSize : context->getMessagePoolLength());
-        memcpy(messageBuffer, context->getMessagePool(), size);
+        nmgLogBlock* next = block->next.load(std::memory_order_relaxed);
+        block->~nmgLogBlock();
+        ::operator delete(block);
+        block = next;
     }
+    delete thread;
+}
+
+// Each thread finds its profile and log entries in a context through a
+// small cache, so alternating between a few contexts doesn't go back to
+// the context's lock.  Ids are never reused, so a stale cache entry can't
+// match a new profile or log, even one in a context allocated at the same
+// address.
+static const int THREAD_CACHE_SIZE = 4;
+
+struct nmgThreadCache
+{
+    unsigned int ids[THREAD_CACHE_SIZE];
+    void* entries[THREAD_CACHE_SIZE];
+    int next;
+};
+
+static std::atomic<unsigned int> sNextThreadCacheId(1);
+static thread_local nmgThreadCache tThreadCache;
+
+static void* findThreadCache(unsigned int id)
+{
+    for (int i = 0; i < THREAD_CACHE_SIZE; ++i)
+    {
+        if (tThreadCache.ids[i] == id)
+            return tThreadCache.entries[i];
+    }
+    return 0;
+}
+
+static void addThreadCache(unsigned int id, void* entry)
+{
+    const int i = tThreadCache.next;
+    tThreadCache.ids[i] = id;
+    tThreadCache.entries[i] = entry;
+    tThreadCache.next = (i + 1) % THREAD_CACHE_SIZE;
 }
 
 nmgBuildContext::nmgBuildContext()
-    : rcContext(false), mMessageCount(0), mTextPoolSize(0)
+    : rcContext(false)
+    , mLogId(sNextThreadCacheId++)
+    , mLogSequence(0)
+    , mJobs(0)
+    , mProfileId(sNextThreadCacheId++)
+    , mMemoryTracked(false)
 {
     m_logEnabled = true;
 }
 
 nmgBuildContext::~nmgBuildContext()
 {
+    clearLog();
+    clearProfile();
+    if (mMemoryTracked)
+        rcSetMemoryTracking(false);
+    delete mJobs;
+}
+
+bool nmgBuildContext::setThreadCount(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = rcMax(1, (int)std::thread::hardware_concurrency());
+
+    delete mJobs;
+    mJobs = 0;
+
+    if (threadCount == 1)
+        return true;
+
+    mJobs = new(std::nothrow) nmgJobSystem(threadCount);
+    return mJobs != 0;
+}
+
+void nmgBuildContext::doParallelFor(rcParallelForFunc func
+    , void* data
+    , const int count)
+{
+    if (mJobs)
+        mJobs->run(func, data, count);
+    else
+        func(data, 0, count);
+}
+
+int nmgBuildContext::doGetThreadCount() const
+{
+    return mJobs ? mJobs->getThreadCount() : 1;
+}
+
+void nmgBuildContext::setProfileEnabled(bool state)
+{
+    if (state != mMemoryTracked)
+    {
+        rcSetMemoryTracking(state);
+        mMemoryTracked = state;
+    }
+    if (state)
+        clearProfile();
+    m_timerEnabled = state;
+}
+
+void nmgBuildContext::clearProfile()
+{
+    std::lock_guard<std::mutex> lock(mProfileLock);
+    for (size_t i = 0; i < mProfileThreads.size(); ++i)
+        delete mProfileThreads[i];
+    mProfileThreads.clear();
+    mProfileId = sNextThreadCacheId++;
+
+    rcMemoryStats mem;
+    rcGetMemoryStats(&mem, true);
+}
+
+nmgProfileThread* nmgBuildContext::getProfileThread()
+{
+    nmgProfileThread* thread = (nmgProfileThread*)findThreadCache(mProfileId);
+    if (thread)
+        return thread;
+
+    const std::thread::id owner = std::this_thread::get_id();
+
+    std::lock_guard<std::mutex> lock(mProfileLock);
+    for (size_t i = 0; i < mProfileThreads.size() && !thread; ++i)
+    {
+        if (mProfileThreads[i]->owner == owner)
+            thread = mProfileThreads[i];
+    }
+
+    if (!thread)
+    {
+        thread = new(std::nothrow) nmgProfileThread();
+        if (!thread)
+            return 0;
+        memset(thread->timers, 0, sizeof(thread->timers));
+        thread->inTile = false;
+        thread->owner = owner;
+        thread->index = (int)mProfileThreads.size();
+        mProfileThreads.push_back(thread);
+    }
+
+    addThreadCache(mProfileId, thread);
+
+    return thread;
+}
+
+void nmgBuildContext::doResetTimers()
+{
+    clearProfile();
+}
+
+void nmgBuildContext::doStartTimer(const rcTimerLabel label)
+{
+    nmgProfileThread* thread = getProfileThread();
+    if (thread)
+        thread->timers[label].start = profileNow();
+}
+
+void nmgBuildContext::doStopTimer(const rcTimerLabel label)
+{
+    nmgProfileThread* thread = getProfileThread();
+    if (!thread)
+        return;
+
+    nmgProfileTimer& timer = thread->timers[label];
+    const long long elapsed = profileNow() - timer.start;
+    timer.total += elapsed;
+    timer.max = rcMax(timer.max, elapsed);
+    timer.calls++;
+}
+
+int nmgBuildContext::doGetAccumulatedTime(const rcTimerLabel label) const
+{
+    std::lock_guard<std::mutex> lock(mProfileLock);
+    long long total = 0;
+    int calls = 0;
+    for (size_t i = 0; i < mProfileThreads.size(); ++i)
+    {
+        total += mProfileThreads[i]->timers[label].total;
+        calls += mProfileThreads[i]->timers[label].calls;
+    }
+    return calls ? (int)rcMin(total / 1000, (long long)0x7fffffff) : -1;
+}
+
+void nmgBuildContext::beginTile(int tx, int ty)
+{
+    nmgProfileThread* thread = getProfileThread();
+    if (!thread)
+        return;
+
+    thread->inTile = true;
+    thread->tile.tx = tx;
+    thread->tile.ty = ty;
+    thread->tile.thread = thread->index;
+    for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        thread->tileBase[i] = thread->timers[i].total;
+
+    rcMemoryStats mem;
+    rcGetThreadMemoryStats(&mem, true);
+    thread->tile.peakMemory = -mem.current;	// Made relative in endTile.
+    thread->tileStart = profileNow();
+}
+
+void nmgBuildContext::endTile()
+{
+    nmgProfileThread* thread = getProfileThread();
+    if (!thread || !thread->inTile)
+        return;
+
+    nmgProfileTile& tile = thread->tile;
+    tile.wall = profileNow() - thread->tileStart;
+    for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        tile.times[i] = thread->timers[i].total - thread->tileBase[i];
+
+    rcMemoryStats mem;
+    rcGetThreadMemoryStats(&mem, false);
+    tile.peakMemory += mem.peak;
+
+    thread->tiles.push_back(tile);
+    thread->inTile = false;
+}
+
+static void appendf(std::string& out, const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len > 0)
+        out.append(line, rcMin(len, (int)sizeof(line) - 1));
+}
+
+static bool compareTiles(const nmgProfileTile& a, const nmgProfileTile& b)
+{
+    return a.ty != b.ty ? a.ty < b.ty : a.tx < b.tx;
+}
+
+int nmgBuildContext::getProfileReport(int format, char* buffer, int bufferSize) const
+{
+    std::lock_guard<std::mutex> lock(mProfileLock);
+
+    const int nthreads = (int)mProfileThreads.size();
+
+    nmgProfileTimer totals[RC_MAX_TIMERS];
+    memset(totals, 0, sizeof(totals));
+    std::vector<nmgProfileTile> tiles;
+    for (int t = 0; t < nthreads; ++t)
+    {
+        const nmgProfileThread* thread = mProfileThreads[t];
+        for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        {
+            totals[i].total += thread->timers[i].total;
+            totals[i].max = rcMax(totals[i].max, thread->timers[i].max);
+            totals[i].calls += thread->timers[i].calls;
+        }
+        tiles.insert(tiles.end(), thread->tiles.begin(), thread->tiles.end());
+    }
+    std::sort(tiles.begin(), tiles.end(), compareTiles);
+
+    rcMemoryStats mem;
+    rcGetMemoryStats(&mem, false);
+
+    std::string out;
+    if (format == NMG_PROFILE_CSV)
+    {
+        // One table.  The scope column says which columns are used.
+        out += "scope,tx,ty,thread,stage,calls,totalUs,maxUs,peakMemory\n";
+        appendf(out, "build,,,,,,,,%lld\n", mem.peak);
+        for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        {
+            if (!totals[i].calls)
+                continue;
+            appendf(out, "stage,,,,%s,%d,%lld,%lld,\n", sTimerNames[i]
+                , totals[i].calls, totals[i].total / 1000, totals[i].max / 1000);
+        }
+        for (int t = 0; t < nthreads; ++t)
+        {
+            const nmgProfileTimer* timers = mProfileThreads[t]->timers;
+            for (int i = 0; i < RC_MAX_TIMERS; ++i)
+            {
+                if (!timers[i].calls)
+                    continue;
+                appendf(out, "thread,,,%d,%s,%d,%lld,%lld,\n", t, sTimerNames[i]
+                    , timers[i].calls, timers[i].total / 1000, timers[i].max / 1000);
+            }
+        }
+        for (size_t n = 0; n < tiles.size(); ++n)
+        {
+            const nmgProfileTile& tile = tiles[n];
+            appendf(out, "tile,%d,%d,%d,,,%lld,,%lld\n", tile.tx, tile.ty, tile.thread
+                , tile.wall / 1000, tile.peakMemory);
+            for (int i = 0; i < RC_MAX_TIMERS; ++i)
+            {
+                if (!tile.times[i])
+                    continue;
+                appendf(out, "tile,%d,%d,%d,%s,,%lld,,\n", tile.tx, tile.ty, tile.thread
+                    , sTimerNames[i], tile.times[i] / 1000);
+            }
+        }
+    }
+    else
+    {
+        appendf(out, "{\n  \"threads\": %d,\n  \"peakMemory\": %lld,\n  \"stages\": [", nthreads, mem.peak);
+        bool first = true;
+        for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        {
+            if (!totals[i].calls)
+                continue;
+            appendf(out, "%s\n    { \"name\": \"%s\", \"calls\": %d, \"totalUs\": %lld, \"maxUs\": %lld, \"threadUs\": ["
+                , first ? "" : ",", sTimerNames[i], totals[i].calls, totals[i].total / 1000, totals[i].max / 1000);
+            for (int t = 0; t < nthreads; ++t)
+                appendf(out, "%s%lld", t ? ", " : "", mProfileThreads[t]->timers[i].total / 1000);
+            out += "] }";
+            first = false;
+        }
+        out += "\n  ],\n  \"tiles\": [";
+        for (size_t n = 0; n < tiles.size(); ++n)
+        {
+            const nmgProfileTile& tile = tiles[n];
+            appendf(out, "%s\n    { \"tx\": %d, \"ty\": %d, \"thread\": %d, \"wallUs\": %lld, \"peakMemory\": %lld, \"stagesUs\": {"
+                , n ? "," : "", tile.tx, tile.ty, tile.thread, tile.wall / 1000, tile.peakMemory);
+            first = true;
+            for (int i = 0; i < RC_MAX_TIMERS; ++i)
+            {
+                if (!tile.times[i])
+                    continue;
+                appendf(out, "%s \"%s\": %lld", first ? "" : ",", sTimerNames[i], tile.times[i] / 1000);
+                first = false;
+            }
+            out += " } }";
+        }
+        out += "\n  ]\n}\n";
+    }
+
+    if (buffer && bufferSize > 0)
+    {
+        const int n = rcMin((int)out.size(), bufferSize - 1);
+        memcpy(buffer, out.c_str(), n);
+        buffer[n] = '\0';
+    }
+
+    return (int)out.size();
+}
+
+void nmgBuildContext::clearLog()
+{
+    std::lock_guard<std::mutex> lock(mLogLock);
+    for (size_t i = 0; i < mLogThreads.size(); ++i)
+        freeLogThread(mLogThreads[i]);
+    mLogThreads.clear();
+    mLogId = sNextThreadCacheId++;
+    mLogSequence.store(0, std::memory_order_relaxed);
+    mMergedPool.clear();
+    mMergedMessages.clear();
+}
+
+nmgLogThread* nmgBuildContext::getLogThread()
+{
+    nmgLogThread* thread = (nmgLogThread*)findThreadCache(mLogId);
+    if (thread)
+        return thread;
+
+    const std::thread::id owner = std::this_thread::get_id();
+
+    std::lock_guard<std::mutex> lock(mLogLock);
+    for (size_t i = 0; i < mLogThreads.size() && !thread; ++i)
+    {
+        if (mLogThreads[i]->owner == owner)
+            thread = mLogThreads[i];
+    }
+
+    if (!thread)
+    {
+        nmgLogBlock* block = allocLogBlock(LOG_BLOCK_SIZE);
+        if (!block)
+            return 0;
+        thread = new(std::nothrow) nmgLogThread();
+        if (!thread)
+        {
+            block->~nmgLogBlock();
+            ::operator delete(block);
+            return 0;
+        }
+        thread->owner = owner;
+        thread->head = block;
+        thread->tail = block;
+        mLogThreads.push_back(thread);
+    }
+
+    addThreadCache(mLogId, thread);
+
+    return thread;
+}
+
+void nmgBuildContext::mergeLog() const
+{
+    struct Message
+    {
+        unsigned int sequence;
+        const char* text;
+        int size;
+
+        bool operator<(const Message& other) const { return sequence < other.sequence; }
+    };
+
+    // Only the published part of each block is read.  A block is never
+    // written again once its thread has moved on to the next one.
+    std::vector<Message> messages;
+    for (size_t t = 0; t < mLogThreads.size(); ++t)
+    {
+        for (nmgLogBlock* block = mLogThreads[t]->head; block; )
+        {
+            const int used = block->used.load(std::memory_order_acquire);
+            const char* data = block->data();
+            for (int offset = 0; offset < used; )
+            {
+                nmgLogEntry entry;
+                memcpy(&entry, data + offset, sizeof(entry));
+                Message message;
+                message.sequence = entry.sequence;
+                message.text = data + offset + sizeof(entry);
+                message.size = entry.size;
+                messages.push_back(message);
+                offset += logEntrySize(entry.size);
+            }
+            block = block->next.load(std::memory_order_acquire);
+        }
+    }
+
+    // Messages are only ever added, so an unchanged count means an
+    // unchanged log.
+    if (messages.size() == mMergedMessages.size())
+        return;
+
+    std::sort(messages.begin(), messages.end());
+
+    mMergedPool.clear();
+    mMergedMessages.clear();
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        mMergedMessages.push_back((int)mMergedPool.size());
+        mMergedPool.insert(mMergedPool.end(), messages[i].text, messages[i].text + messages[i].size);
+    }
 }
 
 void nmgBuildContext::doResetLog()
 {
-    mMessageCount = 0;
-    mTextPoolSize = 0;
+    clearLog();
 }
 
-void nmgBuildContext::doLog(const rcLogCategory category
+void nmgBuildContext::doLog(const rcLogCategory /*category*/
     , const char* message
     , const int messageLength)
 {
-    // Design Note: The category is ignored.
+    // Design Note: Categories below the log category have already been
+    // dropped by rcContext::log, before formatting.
 
     // Process early exits.
-    if (!getLogEnabled()
-        ||  messageLength == 0
-        || mMessageCount >= MAX_MESSAGES)
+    if (!getLogEnabled() || messageLength <= 0)
+        return;
+
+    nmgLogThread* thread = getLogThread();
+    if (!thread)
         return;
-    int remainingSpace = MESSAGE_POOL_SIZE - mTextPoolSize;
-    if (remainingSpace < 1)
-	    return;
 
-    // Store message
-    const int realLength = rcMin(messageLength+1, remainingSpace-1);
-    char* pEntry = &mTextPool[mTextPoolSize];
-    memcpy(pEntry, message, realLength);
-    pEntry[realLength-1] = '\0';
-    mTextPoolSize += realLength;
-    mMessages[mMessageCount++] = pEntry;
+    const int size = logEntrySize(messageLength + 1);
+
+    nmgLogBlock* block = thread->tail;
+    int used = block->used.load(std::memory_order_relaxed);
+    if (used + size > block->capacity)
+    {
+        nmgLogBlock* next = allocLogBlock(rcMax(LOG_BLOCK_SIZE, size));
+        if (!next)
+            return;
+        block->next.store(next, std::memory_order_release);
+        thread->tail = next;
+        block = next;
+        used = 0;
+    }
+
+    nmgLogEntry entry;
+    entry.sequence = mLogSequence.fetch_add(1, std::memory_order_relaxed);
+    entry.size = messageLength + 1;
+
+    char* dest = block->data() + used;
+    memcpy(dest, &entry, sizeof(entry));
+    memcpy(dest + sizeof(entry), message, messageLength);
+    dest[sizeof(entry) + messageLength] = '\0';
+
+    block->used.store(used + size, std::memory_order_release);
 }
 
 int nmgBuildContext::getMessageCount() const
 {
-    return mMessageCount;
+    std::lock_guard<std::mutex> lock(mLogLock);
+    mergeLog();
+    return (int)mMergedMessages.size();
+}
+
+int nmgBuildContext::getMessage(const int i, char* buffer, const int bufferSize) const
+{
+    std::lock_guard<std::mutex> lock(mLogLock);
+    mergeLog();
+    if (i < 0 || i >= (int)mMergedMessages.size())
+        return -1;
+
+    const char* message = &mMergedPool[mMergedMessages[i]];
+    const int length = (int)strlen(message);
+    if (buffer && bufferSize > 0)
+    {
+        const int size = rcMin(length, bufferSize - 1);
+        memcpy(buffer, message, size);
+        buffer[size] = '\0';
+    }
+    return length;
 }
 
-const char* nmgBuildContext::getMessage(const int i) const
+int nmgBuildContext::getMessagePoolLength() const
 {
-    return mMessages[i];
+    std::lock_guard<std::mutex> lock(mLogLock);
+    mergeLog();
+    return (int)mMergedPool.size();
 }
 
-int nmgBuildContext::getMessagePoolLength() const { return mTextPoolSize; }
-const char* nmgBuildContext::getMessagePool() const { return mTextPool; }
+int nmgBuildContext::getMessagePool(char* buffer, const int bufferSize) const
+{
+    std::lock_guard<std::mutex> lock(mLogLock);
+    mergeLog();
+    if (!buffer || bufferSize <= 0 || mMergedPool.empty())
+        return 0;
+
+    const int size = rcMin((int)mMergedPool.size(), bufferSize);
+    memcpy(buffer, &mMergedPool[0], size);
+
+    // The messages that start within the copied part.
+    int count = 0;
+    while (count < (int)mMergedMessages.size() && mMergedMessages[count] < size)
+        count++;
+    return count;
+}
 
 extern "C"
 {
@@ -102,6 +716,20 @@ extern "C"
             delete context;
     }
 
+    EXPORT_API bool nmbcSetThreadCount(nmgBuildContext* context, int threadCount)
+    {
+        if (context)
+            return context->setThreadCount(threadCount);
+        return false;
+    }
+
+    EXPORT_API int nmbcGetThreadCount(nmgBuildContext* context)
+    {
+        if (context)
+            return context->getThreadCount();
+        return 0;
+    }
+
     EXPORT_API void nmbcEnableLog(nmgBuildContext* context, bool state)
     {
         if (context)
@@ -129,20 +757,68 @@ extern "C"
         return context->getMessageCount();
     }
 
+    // The length of the message pool, so a caller can size the buffer for
+    // nmbcGetMessagePool.
+    EXPORT_API int nmbcGetMessagePoolLength(const nmgBuildContext* context)
+    {
+        if (!context)
+            return 0;
+
+        return context->getMessagePoolLength();
+    }
+
     EXPORT_API int nmbcGetMessagePool(nmgBuildContext* context
         , unsigned char* messageBuffer
         , const int bufferSize)
     {
         if (!context)
             return 0;
-        nmgTransferMessages(context, messageBuffer, bufferSize);
-        return context->getMessageCount();
+        return context->getMessagePool((char*)messageBuffer, bufferSize);
+    }
+
+    EXPORT_API void nmbcEnableProfile(nmgBuildContext* context, bool state)
+    {
+        if (context)
+            context->setProfileEnabled(state);
+    }
+
+    EXPORT_API bool nmbcGetProfileEnabled(nmgBuildContext* context)
+    {
+        if (context)
+            return context->getProfileEnabled();
+        return false;
+    }
+
+    // Returns the length of the whole report, so a caller can size the
+    // buffer with a first call.  (Zero if there is no context.)
+    EXPORT_API int nmbcGetProfileReport(nmgBuildContext* context
+        , int format
+        , char* buffer
+        , const int bufferSize)
+    {
+        if (!context)
+            return 0;
+        return context->getProfileReport(format, buffer, bufferSize);
+    }
+
+    EXPORT_API void nmbcSetLogCategory(nmgBuildContext* context, int category)
+    {
+        if (context)
+            context->setLogCategory((rcLogCategory)category);
+    }
+
+    EXPORT_API int nmbcGetLogCategory(nmgBuildContext* context)
+    {
+        if (context)
+            return context->getLogCategory();
+        return RC_LOG_PROGRESS;
     }
 
     EXPORT_API void nmbcLog(nmgBuildContext* context
+        , int category
         , const char* message)
     {
         if (context && message)
-            context->log(RC_LOG_PROGRESS, message);
+            context->log((rcLogCategory)category, "%s", message);
     }
 }
\ No newline at end of file
@@ -19,7 +19,18 @@
 #include "ChunkyTriMesh.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <new>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 struct BoundsItem
 {
@@ -200,6 +211,260 @@ bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
 	return true;
 }
 
+// File layout: header, nodes, then triangles.  Everything is stored in the
+// in-memory layout so the nodes and triangles can be used straight from the
+// mapped file.
+static const int CHUNKY_FILE_MAGIC = 'R'<<24 | 'C'<<16 | 'C'<<8 | 'M';
+static const int CHUNKY_FILE_VERSION = 1;
+
+struct ChunkyFileHeader
+{
+	int magic;
+	int version;
+	int nnodes;
+	int ntris;
+	int maxTrisPerChunk;
+	int reserved;
+	unsigned long long inputHash;
+};
+
+struct ChunkyFileMapping
+{
+	void* data;
+	size_t size;
+};
+
+static inline unsigned long long hashWords(unsigned long long h, const void* data, size_t size)
+{
+	// FNV-1a over 32-bit words.  The input is always a multiple of four bytes.
+	// (memcpy keeps the float loads legal under strict aliasing.)
+	const unsigned char* p = (const unsigned char*)data;
+	const size_t n = size / 4;
+	for (size_t i = 0; i < n; ++i)
+	{
+		unsigned int w;
+		memcpy(&w, p + i*4, sizeof(w));
+		h ^= w;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+unsigned long long rcHashChunkyTriMeshInput(const float* verts, int nverts,
+											const int* tris, int ntris, int trisPerChunk)
+{
+	const int counts[3] = { nverts, ntris, trisPerChunk };
+	unsigned long long h = 14695981039346656037ULL;
+	h = hashWords(h, counts, sizeof(counts));
+	h = hashWords(h, verts, sizeof(float)*3*(size_t)nverts);
+	h = hashWords(h, tris, sizeof(int)*3*(size_t)ntris);
+	return h;
+}
+
+bool rcSaveChunkyTriMesh(const rcChunkyTriMesh* cm, unsigned long long inputHash, const char* path)
+{
+	if (!cm || !cm->nodes || !cm->tris || !path)
+		return false;
+
+	ChunkyFileHeader header;
+	header.magic = CHUNKY_FILE_MAGIC;
+	header.version = CHUNKY_FILE_VERSION;
+	header.nnodes = cm->nnodes;
+	header.ntris = cm->ntris;
+	header.maxTrisPerChunk = cm->maxTrisPerChunk;
+	header.reserved = 0;
+	header.inputHash = inputHash;
+
+	FILE* fp = fopen(path, "wb");
+	if (!fp)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(cm->nodes, sizeof(rcChunkyTriMeshNode), cm->nnodes, fp) == (size_t)cm->nnodes
+		&& fwrite(cm->tris, sizeof(int)*3, cm->ntris, fp) == (size_t)cm->ntris;
+	ok = fclose(fp) == 0 && ok;
+
+	// Don't leave a truncated file behind to be rejected on every load.
+	if (!ok)
+		remove(path);
+
+	return ok;
+}
+
+static void* mapFile(const char* path, size_t& size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0
+		, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0
+		|| (unsigned long long)fileSize.QuadPart > (size_t)-1)
+	{
+		CloseHandle(file);
+		return 0;
+	}
+
+	HANDLE section = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+	if (!section)
+		return 0;
+
+	// The view keeps the section alive.
+	void* data = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(section);
+
+	size = (size_t)fileSize.QuadPart;
+	return data;
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return 0;
+	}
+
+	// The mapping keeps the file alive.
+	void* data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return 0;
+
+	size = (size_t)st.st_size;
+	return data;
+#endif
+}
+
+static void unmapFile(void* data, size_t size)
+{
+#ifdef _WIN32
+	(void)size;
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
+void rcFreeChunkyTriMeshData(rcChunkyTriMesh* cm)
+{
+	ChunkyFileMapping* mapping = (ChunkyFileMapping*)cm->mapping;
+	if (mapping)
+	{
+		unmapFile(mapping->data, mapping->size);
+		delete mapping;
+	}
+	else
+	{
+		delete [] cm->nodes;
+		delete [] cm->tris;
+	}
+	cm->nodes = 0;
+	cm->tris = 0;
+	cm->mapping = 0;
+}
+
+// The nodes feed straight into the queries, so check the file can't send one
+// outside its arrays.  Checking every triangle index would read the whole
+// file, so they are checked a chunk at a time as they are used.
+// (See rcCheckChunkyTriMeshChunk.)
+static bool validateChunkyFile(const ChunkyFileHeader* header, size_t size)
+{
+	if (header->nnodes <= 0 || header->ntris <= 0 || header->maxTrisPerChunk <= 0)
+		return false;
+
+	const unsigned long long expected = sizeof(ChunkyFileHeader)
+		+ (unsigned long long)header->nnodes*sizeof(rcChunkyTriMeshNode)
+		+ (unsigned long long)header->ntris*sizeof(int)*3;
+	if (expected != size)
+		return false;
+
+	const rcChunkyTriMeshNode* nodes = (const rcChunkyTriMeshNode*)(header + 1);
+	for (int i = 0; i < header->nnodes; ++i)
+	{
+		const rcChunkyTriMeshNode& node = nodes[i];
+		if (node.i >= 0)
+		{
+			if (node.n < 0 || node.n > header->maxTrisPerChunk
+				|| node.n > header->ntris - node.i)
+			{
+				return false;
+			}
+		}
+		else if (-node.i > header->nnodes - i)
+		{
+			// Escape index past the end of the tree.
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool rcCheckChunkyTriMeshChunk(const rcChunkyTriMesh* cm, int chunk, int nverts)
+{
+	if (!cm->mapping)
+		return true;
+
+	const rcChunkyTriMeshNode& node = cm->nodes[chunk];
+	const int* tris = &cm->tris[node.i*3];
+	for (int i = 0; i < node.n*3; ++i)
+	{
+		if (tris[i] < 0 || tris[i] >= nverts)
+			return false;
+	}
+
+	return true;
+}
+
+bool rcMapChunkyTriMesh(const char* path, unsigned long long inputHash, rcChunkyTriMesh* cm)
+{
+	if (!path || !cm)
+		return false;
+
+	size_t size = 0;
+	void* data = mapFile(path, size);
+	if (!data)
+		return false;
+
+	const ChunkyFileHeader* header = (const ChunkyFileHeader*)data;
+	if (size < sizeof(ChunkyFileHeader)
+		|| header->magic != CHUNKY_FILE_MAGIC
+		|| header->version != CHUNKY_FILE_VERSION
+		|| header->inputHash != inputHash
+		|| !validateChunkyFile(header, size))
+	{
+		unmapFile(data, size);
+		return false;
+	}
+
+	ChunkyFileMapping* mapping = new (std::nothrow) ChunkyFileMapping;
+	if (!mapping)
+	{
+		unmapFile(data, size);
+		return false;
+	}
+	mapping->data = data;
+	mapping->size = size;
+
+	rcFreeChunkyTriMeshData(cm);
+
+	// The mesh is never written after it is built, so the read-only pages are
+	// safe to hand out through the non-const members.
+	cm->nodes = (rcChunkyTriMeshNode*)(header + 1);
+	cm->nnodes = header->nnodes;
+	cm->tris = (int*)(cm->nodes + header->nnodes);
+	cm->ntris = header->ntris;
+	cm->maxTrisPerChunk = header->maxTrisPerChunk;
+	cm->mapping = mapping;
+
+	return true;
+}
 
 inline bool checkOverlapRect(const float amin[2], const float amax[2],
 							 const float bmin[2], const float bmax[2])
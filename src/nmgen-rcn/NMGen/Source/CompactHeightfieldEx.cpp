@@ -49,13 +49,23 @@ extern "C"
 	        rcFree(chf->spans);
 	        rcFree(chf->dist);
 	        rcFree(chf->areas);
+            rcFree(chf->cons);
             chf->cells = 0;
             chf->spans = 0;
             chf->dist = 0;
             chf->areas = 0;
+            chf->cons = 0;
         }
     }
 
+    EXPORT_API bool nmcfBuildSpanCons(nmgBuildContext* ctx
+        , rcCompactHeightfield* chf)
+    {
+        if (ctx && chf)
+            return rcBuildCompactSpanCons(ctx, *chf);
+        return false;
+    }
+
     EXPORT_API bool nmcfGetCellData(rcCompactHeightfield* chf
         , rcCompactCell* cells
         , const int cellsSize)
@@ -77,6 +77,36 @@ extern "C"
         rcFreeHeightField(hf);
     }
 
+    // Clears the field for a new build, keeping its span pools.  (And its
+    // column array when the cell count is unchanged.)
+    EXPORT_API bool nmhfResetField(rcHeightfield* hf
+        , const int width
+        , const int height
+        , const float* bmin
+        , const float* bmax
+        , const float cs
+        , const float ch)
+    {
+        if (!hf || !bmin || !bmax)
+            return false;
+
+        return rcResetHeightfield(0
+            , *hf
+            , width
+            , height
+            , bmin
+            , bmax
+            , cs
+            , ch);
+    }
+
+    EXPORT_API void nmhfGetAllocStats(rcHeightfieldAllocStats* stats
+        , const bool reset)
+    {
+        if (stats)
+            rcGetHeightfieldAllocStats(stats, reset);
+    }
+
     EXPORT_API bool nmhfRasterizeTriangle(nmgBuildContext* ctx
         , const float* v
         , const unsigned char area
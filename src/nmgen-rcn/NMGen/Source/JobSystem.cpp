@@ -0,0 +1,90 @@
+#include "JobSystem.h"
+
+nmgJobSystem::nmgJobSystem(const int threadCount)
+    : mJob(0)
+    , mData(0)
+    , mCount(0)
+    , mGeneration(0)
+    , mRunning(0)
+    , mQuit(false)
+{
+    mNext = 0;
+    for (int i = 1; i < threadCount; ++i)
+        mThreads.push_back(std::thread(&nmgJobSystem::workerMain, this));
+}
+
+nmgJobSystem::~nmgJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        mQuit = true;
+    }
+    mStart.notify_all();
+    for (size_t i = 0; i < mThreads.size(); ++i)
+        mThreads[i].join();
+}
+
+void nmgJobSystem::run(rcParallelForFunc job, void* data, const int count)
+{
+    if (count <= 0)
+        return;
+
+    std::unique_lock<std::mutex> running(mRunLock, std::try_to_lock);
+    if (mThreads.empty() || count == 1 || !running.owns_lock())
+    {
+        job(data, 0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        mJob = job;
+        mData = data;
+        mCount = count;
+        mNext = 0;
+        mRunning = (int)mThreads.size();
+        mGeneration++;
+    }
+    mStart.notify_all();
+
+    work();
+
+    std::unique_lock<std::mutex> guard(mLock);
+    mFinished.wait(guard, [this] { return mRunning == 0; });
+}
+
+void nmgJobSystem::work()
+{
+    for (;;)
+    {
+        const int i = mNext.fetch_add(1);
+        if (i >= mCount)
+            break;
+        mJob(mData, i, i + 1);
+    }
+}
+
+void nmgJobSystem::workerMain()
+{
+    unsigned int generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> guard(mLock);
+            mStart.wait(guard, [&] { return mQuit || mGeneration != generation; });
+            if (mQuit)
+                return;
+            generation = mGeneration;
+        }
+
+        work();
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            last = --mRunning == 0;
+        }
+        if (last)
+            mFinished.notify_one();
+    }
+}
@@ -8,6 +8,7 @@ struct RasterizationContext
 	RasterizationContext() :
 		solid(0),
 		triareas(0),
+		maxTriareas(0),
 		lset(0),
 		chf(0),
 		ntiles(0)
@@ -17,41 +18,51 @@ struct RasterizationContext
 
 	~RasterizationContext()
 	{
+		purge();
 		rcFreeHeightField(solid);
 		delete[] triareas;
+	}
+
+	// Releases the per-tile build data.  The heightfield and triangle area
+	// buffer are kept so the context can be reused for the next tile.
+	void purge()
+	{
 		rcFreeHeightfieldLayerSet(lset);
+		lset = 0;
 		rcFreeCompactHeightfield(chf);
+		chf = 0;
 		for (int i = 0; i < MAX_LAYERS; ++i)
 		{
 			rcFree(tiles[i].data);
 			tiles[i].data = 0;
+			tiles[i].dataSize = 0;
 		}
+		ntiles = 0;
 	}
 
 	rcHeightfield* solid;
 	unsigned char* triareas;
+	int maxTriareas;
 	rcHeightfieldLayerSet* lset;
 	rcCompactHeightfield* chf;
 	TileCacheData tiles[MAX_LAYERS];
 	int ntiles;
 };
 
-int rasterizeTileLayers(
-	void *pCtx,
+// Returns the number of layers, or -1 if the tile could not be built.  (Zero
+// is an empty tile.)
+static int buildTileLayers(
+	void *pCtx, void *pRc,
 	int tx, int ty,
 	rcConfig *cfg,
 	TileCacheData* tiles, int maxTiles,
 	float *verts, int nverts,
 	rcChunkyTriMesh *chunkyMesh,
 	bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
-	bool (*buildTileCacheLayer)(
-		int tx, int ty, int i,
-		const float *bmin, const float *bmax,
-		int width, int height, int minx, int maxx, int miny, int maxy, int hmin, int hmax,
-		unsigned char *heights, unsigned char *areas, unsigned char *cons,
-		TileCacheData *tile))
+	BuildTileCacheLayerFunc buildTileCacheLayer)
 {
 	rcContext *m_ctx = (rcContext *)pCtx;
+	RasterizationContext& rc = *(RasterizationContext *)pRc;
 	/*
 	if (!m_geom || !m_geom->getMesh() || !m_geom->getChunkyMesh())
 	{
@@ -60,7 +71,7 @@ int rasterizeTileLayers(
 	}
 	*/
 	//FastLZCompressor comp;
-	RasterizationContext rc;
+	rc.purge();
 
 	//const float* verts = m_geom->getMesh()->getVerts();
 	//const int nverts = m_geom->getMesh()->getVertCount();
@@ -84,26 +95,34 @@ int rasterizeTileLayers(
 	tcfg.bmax[2] += tcfg.borderSize*tcfg.cs;
 
 	// Allocate voxel heightfield where we rasterize our input data to.
-	rc.solid = rcAllocHeightfield();
+	// (Reset rather than recreated, so its span pools carry over between tiles.)
+	if (!rc.solid)
+		rc.solid = rcAllocHeightfield();
 	if (!rc.solid)
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
-		return 0;
+		return -1;
 	}
-	if (!rcCreateHeightfield(m_ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch))
+	if (!rcResetHeightfield(m_ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch))
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
-		return 0;
+		return -1;
 	}
 
 	// Allocate array that can hold triangle flags.
 	// If you have multiple meshes you need to process, allocate
 	// and array which can hold the max number of triangles you need to process.
-	rc.triareas = new unsigned char[chunkyMesh->maxTrisPerChunk];
-	if (!rc.triareas)
+	if (rc.maxTriareas < chunkyMesh->maxTrisPerChunk)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", chunkyMesh->maxTrisPerChunk);
-		return 0;
+		delete[] rc.triareas;
+		rc.maxTriareas = 0;
+		rc.triareas = new unsigned char[chunkyMesh->maxTrisPerChunk];
+		if (!rc.triareas)
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", chunkyMesh->maxTrisPerChunk);
+			return -1;
+		}
+		rc.maxTriareas = chunkyMesh->maxTrisPerChunk;
 	}
 
 	float tbmin[2], tbmax[2];
@@ -120,6 +139,12 @@ int rasterizeTileLayers(
 
 	for (int i = 0; i < ncid; ++i)
 	{
+		if (!rcCheckChunkyTriMeshChunk(chunkyMesh, cid[i], nverts))
+		{
+			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Chunk %d has an invalid vertex index.", cid[i]);
+			return -1;
+		}
+
 		const rcChunkyTriMeshNode& node = chunkyMesh->nodes[cid[i]];
 		const int* tris = &chunkyMesh->tris[node.i * 3];
 		const int ntris = node.n;
@@ -129,7 +154,7 @@ int rasterizeTileLayers(
 			verts, nverts, tris, ntris, rc.triareas);
 
 		if (!rcRasterizeTriangles(m_ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb))
-			return 0;
+			return -1;
 	}
 
 	// Once all geometry is rasterized, we do initial pass of filtering to
@@ -147,19 +172,19 @@ int rasterizeTileLayers(
 	if (!rc.chf)
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
-		return 0;
+		return -1;
 	}
 	if (!rcBuildCompactHeightfield(m_ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf))
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
-		return 0;
+		return -1;
 	}
 
 	// Erode the walkable area by agent radius.
 	if (!rcErodeWalkableArea(m_ctx, tcfg.walkableRadius, *rc.chf))
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
-		return 0;
+		return -1;
 	}
 	/*
 	// (Optional) Mark areas.
@@ -175,12 +200,12 @@ int rasterizeTileLayers(
 	if (!rc.lset)
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
-		return 0;
+		return -1;
 	}
 	if (!rcBuildHeightfieldLayers(m_ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset))
 	{
 		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
-		return 0;
+		return -1;
 	}
 
 	rc.ntiles = 0;
@@ -224,7 +249,7 @@ int rasterizeTileLayers(
 			layer->width, layer->height, layer->minx, layer->maxx, layer->miny, layer->maxy, layer->hmin, layer->hmax,
 			layer->heights, layer->areas, layer->cons,
 			tile)) {
-			return 0;
+			return -1;
 		}
 	}
 
@@ -240,6 +265,69 @@ int rasterizeTileLayers(
 	return n;
 }
 
+static int rasterizeTileLayersWithContext(
+	nmgBuildContext *ctx, void *pRc,
+	int tx, int ty,
+	rcConfig *cfg,
+	TileCacheData* tiles, int maxTiles,
+	float *verts, int nverts,
+	rcChunkyTriMesh *chunkyMesh,
+	bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+	BuildTileCacheLayerFunc buildTileCacheLayer)
+{
+	nmgTileProfileScope profile(ctx, tx, ty);
+	rcScopedTimer timer(ctx, RC_TIMER_TOTAL);
+	return buildTileLayers(ctx, pRc, tx, ty, cfg, tiles, maxTiles
+		, verts, nverts, chunkyMesh
+		, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans
+		, buildTileCacheLayer);
+}
+
+int rasterizeTileLayers(
+	void *pCtx,
+	int tx, int ty,
+	rcConfig *cfg,
+	TileCacheData* tiles, int maxTiles,
+	float *verts, int nverts,
+	rcChunkyTriMesh *chunkyMesh,
+	bool filterLowHangingObstacles, bool filterLedgeSpans, bool filterWalkableLowHeightSpans,
+	BuildTileCacheLayerFunc buildTileCacheLayer)
+{
+	// This is handed out untyped by getRasterizeTileLayers.  The tile cache
+	// build only calls it with the context it was given, which comes from
+	// nmbcAllocateContext.
+	RasterizationContext rc;
+	return rasterizeTileLayersWithContext((nmgBuildContext *)pCtx, &rc, tx, ty, cfg, tiles, maxTiles
+		, verts, nverts, chunkyMesh
+		, filterLowHangingObstacles, filterLedgeSpans, filterWalkableLowHeightSpans
+		, buildTileCacheLayer);
+}
+
+static void* allocRasterizationContext()
+{
+	return new RasterizationContext();
+}
+
+static void freeRasterizationContext(void* rc)
+{
+	delete (RasterizationContext*)rc;
+}
+
+static TileRasterizer tileRasterizer =
+{
+	allocRasterizationContext,
+	freeRasterizationContext,
+	rasterizeTileLayersWithContext
+};
+
 void *getRasterizeTileLayers() {
 	return rasterizeTileLayers;
 }
+
+extern "C"
+{
+	EXPORT_API const TileRasterizer* nmtcGetTileRasterizer()
+	{
+		return &tileRasterizer;
+	}
+}
@@ -95,6 +95,9 @@ enum rcTimerLabel
 	RC_MAX_TIMERS
 };
 
+/// A job run by rcContext::parallelFor.  Processes the items [@p begin, @p end).
+typedef void (*rcParallelForFunc)(void* data, int begin, int end);
+
 /// Provides an interface for optional logging and performance tracking of the Recast 
 /// build process.
 /// @ingroup recast
@@ -104,13 +107,21 @@ public:
 
 	/// Contructor.
 	///  @param[in]		state	TRUE if the logging and performance timers should be enabled.  [Default: true]
-	inline rcContext(bool state = true) : m_logEnabled(state), m_timerEnabled(state) {}
+	inline rcContext(bool state = true) : m_logEnabled(state), m_timerEnabled(state), m_logCategory(RC_LOG_PROGRESS) {}
 	virtual ~rcContext() {}
 
 	/// Enables or disables logging.
 	///  @param[in]		state	TRUE if logging should be enabled.
 	inline void enableLog(bool state) { m_logEnabled = state; }
 
+	/// Sets the least severe category that is logged.  Other messages are dropped before they
+	/// are formatted.
+	///  @param[in]		category	The least severe category to log. [Default: #RC_LOG_PROGRESS]
+	inline void setLogCategory(const rcLogCategory category) { m_logCategory = category; }
+
+	/// Returns the least severe category that is logged.
+	inline rcLogCategory getLogCategory() const { return m_logCategory; }
+
 	/// Clears all log entries.
 	inline void resetLog() { if (m_logEnabled) doResetLog(); }
 
@@ -139,6 +150,15 @@ public:
 	///  @return The accumulated time of the timer, or -1 if timers are disabled or the timer has never been started.
 	inline int getAccumulatedTime(const rcTimerLabel label) const { return m_timerEnabled ? doGetAccumulatedTime(label) : -1; }
 
+	/// Runs a job over the items [0, @p count), on several threads if the context supports it.
+	///  @param[in]		func	The job.
+	///  @param[in]		data	The data passed to the job.
+	///  @param[in]		count	The number of items.
+	inline void parallelFor(rcParallelForFunc func, void* data, const int count) { if (count > 0) doParallelFor(func, data, count); }
+
+	/// Returns the number of threads #parallelFor can use, including the calling thread.
+	inline int getThreadCount() const { return doGetThreadCount(); }
+
 protected:
 
 	/// Clears all log entries.
@@ -165,12 +185,28 @@ protected:
 	///  @param[in]		label	The category of the timer.
 	///  @return The accumulated time of the timer, or -1 if timers are disabled or the timer has never been started.
 	virtual int doGetAccumulatedTime(const rcTimerLabel /*label*/) const { return -1; }
+
+	/// Runs a job over the items [0, @p count).  The default runs them in order on the calling thread.
+	///
+	/// Implementations must hand out items one at a time, in increasing order, and run each one
+	/// to completion on the thread that took it.  Some jobs wait on the progress of lower items.
+	/// The log may be used from any thread, the timers only from the calling thread.
+	///  @param[in]		func	The job.
+	///  @param[in]		data	The data passed to the job.
+	///  @param[in]		count	The number of items. [Limit: > 0]
+	virtual void doParallelFor(rcParallelForFunc func, void* data, const int count) { func(data, 0, count); }
+
+	/// Returns the number of threads #doParallelFor can use, including the calling thread.
+	virtual int doGetThreadCount() const { return 1; }
 	
 	/// True if logging is enabled.
 	bool m_logEnabled;
 
 	/// True if the performance timers are enabled.
 	bool m_timerEnabled;
+
+	/// The least severe category that is logged.
+	rcLogCategory m_logCategory;
 };
 
 /// A helper to first start a timer and then stop it when this helper goes out of scope.
@@ -279,6 +315,7 @@ struct rcCompactHeightfield
 	rcCompactSpan* spans;		///< Array of spans. [Size: #spanCount]
 	unsigned short* dist;		///< Array containing border distance data. [Size: #spanCount]
 	unsigned char* areas;		///< Array containing area id data. [Size: #spanCount]
+	unsigned int* cons;			///< Array containing a copy of the span connection data, or null. [Size: #spanCount] (See: #rcBuildCompactSpanCons)
 };
 
 /// Represents a heightfield layer within a layer set.
@@ -721,6 +758,22 @@ bool rcCreateHeightfield(rcContext* ctx, rcHeightfield& hf, int width, int heigh
 						 const float* bmin, const float* bmax,
 						 float cs, float ch);
 
+/// Clears a heightfield and sets it up for a new build, keeping its memory.
+///  @ingroup recast
+///  @param[in,out]	ctx		The build context to use during the operation.
+///  @param[in,out]	hf		An allocated heightfield, initialized or not.
+///  @param[in]		width	The width of the field along the x-axis. [Limit: >= 0] [Units: vx]
+///  @param[in]		height	The height of the field along the z-axis. [Limit: >= 0] [Units: vx]
+///  @param[in]		bmin	The minimum bounds of the field's AABB. [(x, y, z)] [Units: wu]
+///  @param[in]		bmax	The maximum bounds of the field's AABB. [(x, y, z)] [Units: wu]
+///  @param[in]		cs		The xz-plane cell size to use for the field. [Limit: > 0] [Units: wu]
+///  @param[in]		ch		The y-axis cell size to use for field. [Limit: > 0] [Units: wu]
+///  @returns True if the operation completed successfully.
+///  @see rcCreateHeightfield, rcGetHeightfieldAllocStats
+bool rcResetHeightfield(rcContext* ctx, rcHeightfield& hf, int width, int height,
+						const float* bmin, const float* bmax,
+						float cs, float ch);
+
 /// Sets the area id of all triangles with a slope below the specified value
 /// to #RC_WALKABLE_AREA.
 ///  @ingroup recast
@@ -877,6 +930,20 @@ int rcGetHeightFieldSpanCount(rcContext* ctx, rcHeightfield& hf);
 bool rcBuildCompactHeightfield(rcContext* ctx, const int walkableHeight, const int walkableClimb,
 							   rcHeightfield& hf, rcCompactHeightfield& chf);
 
+/// Copies the span connection data of the compact heightfield into a separate array.
+///  @ingroup recast
+///  @param[in,out]	ctx		The build context to use during the operation.
+///  @param[in,out]	chf		A populated compact heightfield.
+///  @returns True if the operation completed successfully.
+bool rcBuildCompactSpanCons(rcContext* ctx, rcCompactHeightfield& chf);
+
+/// Returns a new array holding the connection data of every span in the compact heightfield.
+///  @ingroup recast
+///  @param[in]		chf		A populated compact heightfield.
+///  @returns An array of size rcCompactHeightfield::spanCount, or null if out of memory.
+///  	Free it with #rcFree.
+unsigned int* rcCopyCompactSpanCons(const rcCompactHeightfield& chf);
+
 /// Erodes the walkable area within the heightfield by the specified radius. 
 ///  @ingroup recast
 ///  @param[in,out]	ctx		The build context to use during the operation.
@@ -1006,6 +1073,17 @@ inline int rcGetCon(const rcCompactSpan& s, int dir)
 	return (s.con >> shift) & 0x3f;
 }
 
+/// Gets neighbor connection data for the specified direction.
+///  @param[in]		con		The packed connection data of the span to check. (See: rcCompactHeightfield::cons)
+///  @param[in]		dir		The direction to check. [Limits: 0 <= value < 4]
+///  @return The neighbor connection data for the specified direction,
+///  	or #RC_NOT_CONNECTED if there is no connection.
+inline int rcGetCon(const unsigned int con, int dir)
+{
+	const unsigned int shift = (unsigned int)dir*6;
+	return (con >> shift) & 0x3f;
+}
+
 /// Gets the standard width (x-axis) offset for the specified direction.
 ///  @param[in]		dir		The direction. [Limits: 0 <= value < 4]
 ///  @return The width offset to apply to the current cell position to move
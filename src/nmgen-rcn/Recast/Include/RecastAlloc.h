@@ -58,6 +58,58 @@ void* rcAlloc(size_t size, rcAllocHint hint);
 /// @see rcAlloc
 void rcFree(void* ptr);
 
+/// Heightfield memory counters, summed over all heightfields since the last reset.
+/// Used to check that #rcResetHeightfield is keeping memory between builds.
+/// @see rcGetHeightfieldAllocStats
+struct rcHeightfieldAllocStats
+{
+	int poolsAllocated;		///< Span pools allocated.
+	int poolsReused;		///< Span pools kept for the next build by #rcResetHeightfield.
+	int columnsAllocated;	///< Span column arrays allocated.
+	int columnsReused;		///< Span column arrays kept for the next build by #rcResetHeightfield.
+};
+
+/// Gets the heightfield memory counters.  (Thread safe.)
+///  @param[out]	stats	The counters.
+///  @param[in]		reset	True if the counters should be set to zero after reading.
+void rcGetHeightfieldAllocStats(rcHeightfieldAllocStats* stats, bool reset);
+
+/// Adds to the heightfield memory counters.  (Used internally by Recast.  Thread safe.)
+void rcAddHeightfieldAllocStats(int poolsAllocated, int poolsReused,
+								int columnsAllocated, int columnsReused);
+
+/// Memory held through #rcAlloc.  Only the default allocator is tracked, and only while
+/// #rcSetMemoryTracking is on.
+/// @see rcGetMemoryStats, rcGetThreadMemoryStats
+struct rcMemoryStats
+{
+	long long current;	///< Bytes allocated now.
+	long long peak;		///< The most bytes allocated at once since the last peak reset.
+};
+
+/// Turns the memory counters on or off.  (Thread safe.)
+///
+/// The counters are off by default, so the default allocator is a plain malloc and free.
+/// Tracking is on while any caller has it enabled, so calls must be paired.  Turning it on
+/// from off sets the process counters to zero.  Blocks allocated while it was off still
+/// count when freed, so the current usage can go below zero.
+///  @param[in]		enabled		True to turn tracking on, false to undo an earlier call with true.
+void rcSetMemoryTracking(bool enabled);
+
+/// Gets the memory counters for the whole process.  (Thread safe.)
+///  @param[out]	stats		The counters.
+///  @param[in]		resetPeak	True if the peak should be set to the current usage after reading.
+void rcGetMemoryStats(rcMemoryStats* stats, bool resetPeak);
+
+/// Gets the memory counters for the calling thread.
+///
+/// A block counts against the thread that allocated or freed it, so a thread that frees
+/// memory allocated elsewhere can go negative.  The counters are meant for measuring the
+/// peak of a piece of work that runs on one thread.
+///  @param[out]	stats		The counters.
+///  @param[in]		resetPeak	True if the peak should be set to the current usage after reading.
+void rcGetThreadMemoryStats(rcMemoryStats* stats, bool resetPeak);
+
 
 /// A simple dynamic array of integers.
 class rcIntArray
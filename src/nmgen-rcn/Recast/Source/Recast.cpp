@@ -55,7 +55,7 @@ float rcSqrt(float x)
 /// @endcode
 void rcContext::log(const rcLogCategory category, const char* format, ...)
 {
-	if (!m_logEnabled)
+	if (!m_logEnabled || category < m_logCategory)
 		return;
 	static const int MSG_SIZE = 512;
 	char msg[MSG_SIZE];
@@ -123,6 +123,7 @@ void rcFreeCompactHeightfield(rcCompactHeightfield* chf)
 	rcFree(chf->spans);
 	rcFree(chf->dist);
 	rcFree(chf->areas);
+	rcFree(chf->cons);
 	rcFree(chf);
 }
 
@@ -240,6 +241,51 @@ bool rcCreateHeightfield(rcContext* ctx, rcHeightfield& hf, int width, int heigh
 	if (!hf.spans)
 		return false;
 	memset(hf.spans, 0, sizeof(rcSpan*)*hf.width*hf.height);
+	rcAddHeightfieldAllocStats(0, 0, 1, 0);
+	return true;
+}
+
+/// @par
+///
+/// Tile builds create a heightfield of the same size for every tile.  Resetting
+/// one heightfield instead of freeing and creating a new one per tile keeps the
+/// span column array (when the cell count is unchanged) and all span pools, so
+/// only the first tiles allocate.
+///
+/// @see rcAllocHeightfield, rcCreateHeightfield, rcHeightfield
+bool rcResetHeightfield(rcContext* ctx, rcHeightfield& hf, int width, int height,
+						const float* bmin, const float* bmax,
+						float cs, float ch)
+{
+	// Return every span to the free list.
+	hf.freelist = 0;
+	int npools = 0;
+	for (rcSpanPool* pool = hf.pools; pool; pool = pool->next)
+	{
+		for (int i = RC_SPANS_PER_POOL-1; i >= 0; --i)
+		{
+			pool->items[i].next = hf.freelist;
+			hf.freelist = &pool->items[i];
+		}
+		npools++;
+	}
+
+	if (!hf.spans || hf.width*hf.height != width*height)
+	{
+		rcFree(hf.spans);
+		hf.spans = 0;
+		rcAddHeightfieldAllocStats(0, npools, 0, 0);
+		return rcCreateHeightfield(ctx, hf, width, height, bmin, bmax, cs, ch);
+	}
+
+	hf.width = width;
+	hf.height = height;
+	rcVcopy(hf.bmin, bmin);
+	rcVcopy(hf.bmax, bmax);
+	hf.cs = cs;
+	hf.ch = ch;
+	memset(hf.spans, 0, sizeof(rcSpan*)*hf.width*hf.height);
+	rcAddHeightfieldAllocStats(0, npools, 0, 1);
 	return true;
 }
 
@@ -477,6 +523,44 @@ bool rcBuildCompactHeightfield(rcContext* ctx, const int walkableHeight, const i
 	return true;
 }
 
+unsigned int* rcCopyCompactSpanCons(const rcCompactHeightfield& chf)
+{
+	unsigned int* cons = (unsigned int*)rcAlloc(sizeof(unsigned int)*chf.spanCount, RC_ALLOC_TEMP);
+	if (!cons)
+		return 0;
+	for (int i = 0; i < chf.spanCount; ++i)
+		cons[i] = chf.spans[i].con;
+	return cons;
+}
+
+/// @par
+///
+/// rcCompactSpan keeps the connection data packed in with the span height and region,
+/// so passes that only walk the neighbor connections still stream the whole span.
+/// The split array is half the size.  #rcErodeWalkableArea, #rcBuildDistanceField
+/// and #rcBuildRegions use it when present, and otherwise build a temporary copy on
+/// every call.  Build it once when the field goes through several of those passes.
+///
+/// The array is a copy.  It must be rebuilt if the span connections change.
+///
+/// @see rcCompactHeightfield, rcBuildCompactHeightfield
+bool rcBuildCompactSpanCons(rcContext* ctx, rcCompactHeightfield& chf)
+{
+	rcAssert(ctx);
+
+	rcFree(chf.cons);
+	chf.cons = (unsigned int*)rcAlloc(sizeof(unsigned int)*chf.spanCount, RC_ALLOC_PERM);
+	if (!chf.cons)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildCompactSpanCons: Out of memory 'chf.cons' (%d)", chf.spanCount);
+		return false;
+	}
+	for (int i = 0; i < chf.spanCount; ++i)
+		chf.cons[i] = chf.spans[i].con;
+
+	return true;
+}
+
 /*
 static int getHeightfieldMemoryUsage(const rcHeightfield& hf)
 {
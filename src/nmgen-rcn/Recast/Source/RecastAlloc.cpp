@@ -18,16 +18,60 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
 
+static std::atomic<int> sMemoryTracking(0);
+static std::atomic<long long> sMemoryCurrent(0);
+static std::atomic<long long> sMemoryPeak(0);
+static thread_local long long tMemoryCurrent = 0;
+static thread_local long long tMemoryPeak = 0;
+
+// The block size is taken from the heap rather than a header, so blocks from
+// malloc (e.g. tile data from the Detour allocator) can still go to rcFree.
+static inline long long blockSize(void* ptr)
+{
+#if defined(_MSC_VER)
+	return (long long)_msize(ptr);
+#elif defined(__APPLE__)
+	return (long long)malloc_size(ptr);
+#else
+	return (long long)malloc_usable_size(ptr);
+#endif
+}
+
+static inline void trackMemory(const long long size)
+{
+	const long long current = sMemoryCurrent.fetch_add(size) + size;
+	long long peak = sMemoryPeak.load(std::memory_order_relaxed);
+	while (current > peak && !sMemoryPeak.compare_exchange_weak(peak, current))
+		;
+
+	tMemoryCurrent += size;
+	if (tMemoryCurrent > tMemoryPeak)
+		tMemoryPeak = tMemoryCurrent;
+}
+
 static void *rcAllocDefault(size_t size, rcAllocHint)
 {
-	return malloc(size);
+	void* ptr = malloc(size);
+	if (ptr && sMemoryTracking.load(std::memory_order_relaxed))
+		trackMemory(blockSize(ptr));
+	return ptr;
 }
 
 static void rcFreeDefault(void *ptr)
 {
+	if (sMemoryTracking.load(std::memory_order_relaxed))
+		trackMemory(-blockSize(ptr));
 	free(ptr);
 }
 
@@ -59,6 +103,67 @@ void rcFree(void* ptr)
 		sRecastFreeFunc(ptr);
 }
 
+static std::atomic<int> sPoolsAllocated(0);
+static std::atomic<int> sPoolsReused(0);
+static std::atomic<int> sColumnsAllocated(0);
+static std::atomic<int> sColumnsReused(0);
+
+void rcGetHeightfieldAllocStats(rcHeightfieldAllocStats* stats, bool reset)
+{
+	if (reset)
+	{
+		stats->poolsAllocated = sPoolsAllocated.exchange(0);
+		stats->poolsReused = sPoolsReused.exchange(0);
+		stats->columnsAllocated = sColumnsAllocated.exchange(0);
+		stats->columnsReused = sColumnsReused.exchange(0);
+	}
+	else
+	{
+		stats->poolsAllocated = sPoolsAllocated;
+		stats->poolsReused = sPoolsReused;
+		stats->columnsAllocated = sColumnsAllocated;
+		stats->columnsReused = sColumnsReused;
+	}
+}
+
+void rcAddHeightfieldAllocStats(int poolsAllocated, int poolsReused,
+								int columnsAllocated, int columnsReused)
+{
+	if (poolsAllocated)
+		sPoolsAllocated += poolsAllocated;
+	if (poolsReused)
+		sPoolsReused += poolsReused;
+	if (columnsAllocated)
+		sColumnsAllocated += columnsAllocated;
+	if (columnsReused)
+		sColumnsReused += columnsReused;
+}
+
+void rcSetMemoryTracking(bool enabled)
+{
+	if (!enabled)
+		sMemoryTracking--;
+	else if (sMemoryTracking++ == 0)
+	{
+		sMemoryCurrent = 0;
+		sMemoryPeak = 0;
+	}
+}
+
+void rcGetMemoryStats(rcMemoryStats* stats, bool resetPeak)
+{
+	stats->current = sMemoryCurrent;
+	stats->peak = resetPeak ? sMemoryPeak.exchange(stats->current) : sMemoryPeak.load();
+}
+
+void rcGetThreadMemoryStats(rcMemoryStats* stats, bool resetPeak)
+{
+	stats->current = tMemoryCurrent;
+	stats->peak = tMemoryPeak;
+	if (resetPeak)
+		tMemoryPeak = tMemoryCurrent;
+}
+
 /// @class rcIntArray
 ///
 /// While it is possible to pre-allocate a specific array size during 
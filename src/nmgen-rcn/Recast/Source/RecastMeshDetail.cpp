@@ -1161,28 +1161,51 @@ static unsigned char getTriFlags(const float* va, const float* vb, const float*
 	return flags;
 }
 
-/// @par
-///
-/// See the #rcConfig documentation for more information on the configuration parameters.
-///
-/// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcConfig
-bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
-						   const float sampleDist, const float sampleMaxError,
-						   rcPolyMeshDetail& dmesh)
+// The most batches rcBuildPolyMeshDetail splits the polygons into.
+static const int RC_MAX_DETAIL_BATCHES = 64;
+
+// The detail submeshes of a run of polygons.
+struct rcDetailBatch
 {
-	rcAssert(ctx);
-	
-	rcScopedTimer timer(ctx, RC_TIMER_BUILD_POLYMESHDETAIL);
-	
-	if (mesh.nverts == 0 || mesh.npolys == 0)
-		return true;
-	
+	inline rcDetailBatch() : verts(0), tris(0), nverts(0), ntris(0), ok(true) {}
+	inline ~rcDetailBatch() { rcFree(verts); rcFree(tris); }
+	int begin, end;
+	float* verts;
+	unsigned char* tris;
+	int nverts, ntris;
+	int vbase, tbase;	// The offsets of the batch in the final mesh.
+	bool ok;
+};
+
+struct rcDetailJob
+{
+	rcContext* ctx;
+	const rcPolyMesh* mesh;
+	const rcCompactHeightfield* chf;
+	const int* bounds;
+	float sampleDist;
+	float sampleMaxError;
+	int heightSearchRadius;
+	int maxhw, maxhh;
+	unsigned int* meshes;	// Per polygon.  Offsets are relative to the batch until compacted.
+	rcDetailBatch* batches;
+	float* verts;			// The final arrays, for the compaction.
+	unsigned char* tris;
+};
+
+// Builds the submeshes of one batch of polygons.  Each batch has its own scratch, so
+// the batches can be built in any order.
+static bool buildDetailBatch(const rcDetailJob& job, rcDetailBatch& batch)
+{
+	rcContext* ctx = job.ctx;
+	const rcPolyMesh& mesh = *job.mesh;
+	const rcCompactHeightfield& chf = *job.chf;
+	const int* bounds = job.bounds;
 	const int nvp = mesh.nvp;
 	const float cs = mesh.cs;
 	const float ch = mesh.ch;
 	const float* orig = mesh.bmin;
 	const int borderSize = mesh.borderSize;
-	const int heightSearchRadius = rcMax(1, (int)ceilf(mesh.maxEdgeError));
 	
 	rcIntArray edges(64);
 	rcIntArray tris(512);
@@ -1191,14 +1214,7 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 	float verts[256*3];
 	rcHeightPatch hp;
 	int nPolyVerts = 0;
-	int maxhw = 0, maxhh = 0;
 	
-	rcScopedDelete<int> bounds((int*)rcAlloc(sizeof(int)*mesh.npolys*4, RC_ALLOC_TEMP));
-	if (!bounds)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'bounds' (%d).", mesh.npolys*4);
-		return false;
-	}
 	rcScopedDelete<float> poly((float*)rcAlloc(sizeof(float)*nvp*3, RC_ALLOC_TEMP));
 	if (!poly)
 	{
@@ -1206,73 +1222,39 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		return false;
 	}
 	
-	// Find max size for a polygon area.
-	for (int i = 0; i < mesh.npolys; ++i)
-	{
-		const unsigned short* p = &mesh.polys[i*nvp*2];
-		int& xmin = bounds[i*4+0];
-		int& xmax = bounds[i*4+1];
-		int& ymin = bounds[i*4+2];
-		int& ymax = bounds[i*4+3];
-		xmin = chf.width;
-		xmax = 0;
-		ymin = chf.height;
-		ymax = 0;
-		for (int j = 0; j < nvp; ++j)
-		{
-			if(p[j] == RC_MESH_NULL_IDX) break;
-			const unsigned short* v = &mesh.verts[p[j]*3];
-			xmin = rcMin(xmin, (int)v[0]);
-			xmax = rcMax(xmax, (int)v[0]);
-			ymin = rcMin(ymin, (int)v[2]);
-			ymax = rcMax(ymax, (int)v[2]);
-			nPolyVerts++;
-		}
-		xmin = rcMax(0,xmin-1);
-		xmax = rcMin(chf.width,xmax+1);
-		ymin = rcMax(0,ymin-1);
-		ymax = rcMin(chf.height,ymax+1);
-		if (xmin >= xmax || ymin >= ymax) continue;
-		maxhw = rcMax(maxhw, xmax-xmin);
-		maxhh = rcMax(maxhh, ymax-ymin);
-	}
-	
-	hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxhw*maxhh, RC_ALLOC_TEMP);
+	hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*job.maxhw*job.maxhh, RC_ALLOC_TEMP);
 	if (!hp.data)
 	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", maxhw*maxhh);
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", job.maxhw*job.maxhh);
 		return false;
 	}
 	
-	dmesh.nmeshes = mesh.npolys;
-	dmesh.nverts = 0;
-	dmesh.ntris = 0;
-	dmesh.meshes = (unsigned int*)rcAlloc(sizeof(unsigned int)*dmesh.nmeshes*4, RC_ALLOC_PERM);
-	if (!dmesh.meshes)
+	for (int i = batch.begin; i < batch.end; ++i)
 	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.meshes' (%d).", dmesh.nmeshes*4);
-		return false;
+		const unsigned short* p = &mesh.polys[i*nvp*2];
+		for (int j = 0; j < nvp && p[j] != RC_MESH_NULL_IDX; ++j)
+			nPolyVerts++;
 	}
 	
 	int vcap = nPolyVerts+nPolyVerts/2;
 	int tcap = vcap*2;
 	
-	dmesh.nverts = 0;
-	dmesh.verts = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
-	if (!dmesh.verts)
+	batch.nverts = 0;
+	batch.verts = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
+	if (!batch.verts)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", vcap*3);
 		return false;
 	}
-	dmesh.ntris = 0;
-	dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
-	if (!dmesh.tris)
+	batch.ntris = 0;
+	batch.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
+	if (!batch.tris)
 	{
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", tcap*4);
 		return false;
 	}
 	
-	for (int i = 0; i < mesh.npolys; ++i)
+	for (int i = batch.begin; i < batch.end; ++i)
 	{
 		const unsigned short* p = &mesh.polys[i*nvp*2];
 		
@@ -1298,8 +1280,8 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		// Build detail mesh.
 		int nverts = 0;
 		if (!buildPolyDetail(ctx, poly, npoly,
-							 sampleDist, sampleMaxError,
-							 heightSearchRadius, chf, hp,
+							 job.sampleDist, job.sampleMaxError,
+							 job.heightSearchRadius, chf, hp,
 							 verts, nverts, tris,
 							 edges, samples))
 		{
@@ -1324,15 +1306,15 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		// Store detail submesh.
 		const int ntris = tris.size()/4;
 		
-		dmesh.meshes[i*4+0] = (unsigned int)dmesh.nverts;
-		dmesh.meshes[i*4+1] = (unsigned int)nverts;
-		dmesh.meshes[i*4+2] = (unsigned int)dmesh.ntris;
-		dmesh.meshes[i*4+3] = (unsigned int)ntris;
+		job.meshes[i*4+0] = (unsigned int)batch.nverts;
+		job.meshes[i*4+1] = (unsigned int)nverts;
+		job.meshes[i*4+2] = (unsigned int)batch.ntris;
+		job.meshes[i*4+3] = (unsigned int)ntris;
 		
 		// Store vertices, allocate more memory if necessary.
-		if (dmesh.nverts+nverts > vcap)
+		if (batch.nverts+nverts > vcap)
 		{
-			while (dmesh.nverts+nverts > vcap)
+			while (batch.nverts+nverts > vcap)
 				vcap += 256;
 			
 			float* newv = (float*)rcAlloc(sizeof(float)*vcap*3, RC_ALLOC_PERM);
@@ -1341,23 +1323,23 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 				ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'newv' (%d).", vcap*3);
 				return false;
 			}
-			if (dmesh.nverts)
-				memcpy(newv, dmesh.verts, sizeof(float)*3*dmesh.nverts);
-			rcFree(dmesh.verts);
-			dmesh.verts = newv;
+			if (batch.nverts)
+				memcpy(newv, batch.verts, sizeof(float)*3*batch.nverts);
+			rcFree(batch.verts);
+			batch.verts = newv;
 		}
 		for (int j = 0; j < nverts; ++j)
 		{
-			dmesh.verts[dmesh.nverts*3+0] = verts[j*3+0];
-			dmesh.verts[dmesh.nverts*3+1] = verts[j*3+1];
-			dmesh.verts[dmesh.nverts*3+2] = verts[j*3+2];
-			dmesh.nverts++;
+			batch.verts[batch.nverts*3+0] = verts[j*3+0];
+			batch.verts[batch.nverts*3+1] = verts[j*3+1];
+			batch.verts[batch.nverts*3+2] = verts[j*3+2];
+			batch.nverts++;
 		}
 		
 		// Store triangles, allocate more memory if necessary.
-		if (dmesh.ntris+ntris > tcap)
+		if (batch.ntris+ntris > tcap)
 		{
-			while (dmesh.ntris+ntris > tcap)
+			while (batch.ntris+ntris > tcap)
 				tcap += 256;
 			unsigned char* newt = (unsigned char*)rcAlloc(sizeof(unsigned char)*tcap*4, RC_ALLOC_PERM);
 			if (!newt)
@@ -1365,22 +1347,198 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 				ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'newt' (%d).", tcap*4);
 				return false;
 			}
-			if (dmesh.ntris)
-				memcpy(newt, dmesh.tris, sizeof(unsigned char)*4*dmesh.ntris);
-			rcFree(dmesh.tris);
-			dmesh.tris = newt;
+			if (batch.ntris)
+				memcpy(newt, batch.tris, sizeof(unsigned char)*4*batch.ntris);
+			rcFree(batch.tris);
+			batch.tris = newt;
 		}
 		for (int j = 0; j < ntris; ++j)
 		{
 			const int* t = &tris[j*4];
-			dmesh.tris[dmesh.ntris*4+0] = (unsigned char)t[0];
-			dmesh.tris[dmesh.ntris*4+1] = (unsigned char)t[1];
-			dmesh.tris[dmesh.ntris*4+2] = (unsigned char)t[2];
-			dmesh.tris[dmesh.ntris*4+3] = getTriFlags(&verts[t[0]*3], &verts[t[1]*3], &verts[t[2]*3], poly, npoly);
-			dmesh.ntris++;
+			batch.tris[batch.ntris*4+0] = (unsigned char)t[0];
+			batch.tris[batch.ntris*4+1] = (unsigned char)t[1];
+			batch.tris[batch.ntris*4+2] = (unsigned char)t[2];
+			batch.tris[batch.ntris*4+3] = getTriFlags(&verts[t[0]*3], &verts[t[1]*3], &verts[t[2]*3], poly, npoly);
+			batch.ntris++;
+		}
+	}
+	
+	return true;
+}
+
+static void buildDetailBatchJob(void* data, int begin, int end)
+{
+	const rcDetailJob& job = *(const rcDetailJob*)data;
+	for (int b = begin; b < end; ++b)
+		job.batches[b].ok = buildDetailBatch(job, job.batches[b]);
+}
+
+// Moves each batch to its place in the final arrays and makes its submesh offsets
+// absolute.
+static void compactDetailBatchJob(void* data, int begin, int end)
+{
+	const rcDetailJob& job = *(const rcDetailJob*)data;
+	for (int b = begin; b < end; ++b)
+	{
+		const rcDetailBatch& batch = job.batches[b];
+		if (batch.nverts)
+			memcpy(&job.verts[batch.vbase*3], batch.verts, sizeof(float)*3*batch.nverts);
+		if (batch.ntris)
+			memcpy(&job.tris[batch.tbase*4], batch.tris, sizeof(unsigned char)*4*batch.ntris);
+		for (int i = batch.begin; i < batch.end; ++i)
+		{
+			job.meshes[i*4+0] += (unsigned int)batch.vbase;
+			job.meshes[i*4+2] += (unsigned int)batch.tbase;
+		}
+	}
+}
+
+/// @par
+///
+/// See the #rcConfig documentation for more information on the configuration parameters.
+///
+/// The polygons are built in batches on the context's threads. (See: rcContext::parallelFor)
+/// Each batch has its own scratch and output, and the batches are then packed in polygon
+/// order, so the result does not depend on the thread count.
+///
+/// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcConfig
+bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
+						   const float sampleDist, const float sampleMaxError,
+						   rcPolyMeshDetail& dmesh)
+{
+	rcAssert(ctx);
+	
+	rcScopedTimer timer(ctx, RC_TIMER_BUILD_POLYMESHDETAIL);
+	
+	if (mesh.nverts == 0 || mesh.npolys == 0)
+		return true;
+	
+	const int nvp = mesh.nvp;
+	const int heightSearchRadius = rcMax(1, (int)ceilf(mesh.maxEdgeError));
+	
+	int maxhw = 0, maxhh = 0;
+	
+	rcScopedDelete<int> bounds((int*)rcAlloc(sizeof(int)*mesh.npolys*4, RC_ALLOC_TEMP));
+	if (!bounds)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'bounds' (%d).", mesh.npolys*4);
+		return false;
+	}
+	
+	// Find max size for a polygon area.
+	for (int i = 0; i < mesh.npolys; ++i)
+	{
+		const unsigned short* p = &mesh.polys[i*nvp*2];
+		int& xmin = bounds[i*4+0];
+		int& xmax = bounds[i*4+1];
+		int& ymin = bounds[i*4+2];
+		int& ymax = bounds[i*4+3];
+		xmin = chf.width;
+		xmax = 0;
+		ymin = chf.height;
+		ymax = 0;
+		for (int j = 0; j < nvp; ++j)
+		{
+			if(p[j] == RC_MESH_NULL_IDX) break;
+			const unsigned short* v = &mesh.verts[p[j]*3];
+			xmin = rcMin(xmin, (int)v[0]);
+			xmax = rcMax(xmax, (int)v[0]);
+			ymin = rcMin(ymin, (int)v[2]);
+			ymax = rcMax(ymax, (int)v[2]);
 		}
+		xmin = rcMax(0,xmin-1);
+		xmax = rcMin(chf.width,xmax+1);
+		ymin = rcMax(0,ymin-1);
+		ymax = rcMin(chf.height,ymax+1);
+		if (xmin >= xmax || ymin >= ymax) continue;
+		maxhw = rcMax(maxhw, xmax-xmin);
+		maxhh = rcMax(maxhh, ymax-ymin);
 	}
 	
+	dmesh.nmeshes = mesh.npolys;
+	dmesh.nverts = 0;
+	dmesh.ntris = 0;
+	dmesh.meshes = (unsigned int*)rcAlloc(sizeof(unsigned int)*dmesh.nmeshes*4, RC_ALLOC_PERM);
+	if (!dmesh.meshes)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.meshes' (%d).", dmesh.nmeshes*4);
+		return false;
+	}
+	
+	// Several batches per thread, since the cost of a polygon varies a lot.
+	const int nbatches = ctx->getThreadCount() > 1
+		? rcMin(rcMin(ctx->getThreadCount()*4, RC_MAX_DETAIL_BATCHES), mesh.npolys) : 1;
+	
+	rcDetailBatch batches[RC_MAX_DETAIL_BATCHES];
+	for (int b = 0; b < nbatches; ++b)
+	{
+		batches[b].begin = (int)((long long)mesh.npolys*b / nbatches);
+		batches[b].end = (int)((long long)mesh.npolys*(b+1) / nbatches);
+	}
+	
+	rcDetailJob job;
+	job.ctx = ctx;
+	job.mesh = &mesh;
+	job.chf = &chf;
+	job.bounds = bounds;
+	job.sampleDist = sampleDist;
+	job.sampleMaxError = sampleMaxError;
+	job.heightSearchRadius = heightSearchRadius;
+	job.maxhw = maxhw;
+	job.maxhh = maxhh;
+	job.meshes = dmesh.meshes;
+	job.batches = batches;
+	job.verts = 0;
+	job.tris = 0;
+	
+	if (nbatches == 1)
+	{
+		// Nothing to pack.  Hand the batch arrays over.
+		rcDetailBatch& batch = batches[0];
+		batch.ok = buildDetailBatch(job, batch);
+		if (!batch.ok)
+			return false;
+		dmesh.verts = batch.verts;
+		dmesh.nverts = batch.nverts;
+		dmesh.tris = batch.tris;
+		dmesh.ntris = batch.ntris;
+		batch.verts = 0;
+		batch.tris = 0;
+		return true;
+	}
+	
+	ctx->parallelFor(buildDetailBatchJob, &job, nbatches);
+	
+	int nverts = 0, ntris = 0;
+	for (int b = 0; b < nbatches; ++b)
+	{
+		if (!batches[b].ok)
+			return false;
+		batches[b].vbase = nverts;
+		batches[b].tbase = ntris;
+		nverts += batches[b].nverts;
+		ntris += batches[b].ntris;
+	}
+	
+	dmesh.verts = (float*)rcAlloc(sizeof(float)*rcMax(nverts, 1)*3, RC_ALLOC_PERM);
+	if (!dmesh.verts)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", nverts*3);
+		return false;
+	}
+	dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*rcMax(ntris, 1)*4, RC_ALLOC_PERM);
+	if (!dmesh.tris)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", ntris*4);
+		return false;
+	}
+	
+	job.verts = dmesh.verts;
+	job.tris = dmesh.tris;
+	ctx->parallelFor(compactDetailBatchJob, &job, nbatches);
+	dmesh.nverts = nverts;
+	dmesh.ntris = ntris;
+	
 	return true;
 }
 
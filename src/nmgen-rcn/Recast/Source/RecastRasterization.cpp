@@ -19,10 +19,20 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
 
+// Clip distances are computed for all eight clip vertices at once, as two
+// four-wide SSE2 operations, when SSE2 is available.
+// Define RC_RASTERIZATION_NO_SIMD to force the scalar path.
+#if !defined(RC_RASTERIZATION_NO_SIMD) \
+	&& (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define RC_RASTERIZATION_SSE2 1
+#endif
+
 inline bool overlapBounds(const float* amin, const float* amax, const float* bmin, const float* bmax)
 {
 	bool overlap = true;
@@ -50,6 +60,7 @@ static rcSpan* allocSpan(rcHeightfield& hf)
 		// Allocate memory for the new pool.
 		rcSpanPool* pool = (rcSpanPool*)rcAlloc(sizeof(rcSpanPool), RC_ALLOC_PERM);
 		if (!pool) return 0;
+		rcAddHeightfieldAllocStats(1, 0, 0, 0);
 
 		// Add the pool into the list of pools.
 		pool->next = hf.pools;
@@ -180,16 +191,59 @@ bool rcAddSpan(rcContext* ctx, rcHeightfield& hf, const int x, const int y,
 	return true;
 }
 
-// divides a convex polygons into two convex polygons on both sides of a line
-static void dividePoly(const float* in, int nin,
-					  float* out1, int* nout1,
-					  float* out2, int* nout2,
-					  float x, int axis)
+// Clip polygons are stored as separate x, y and z arrays so that the distances
+// to a clip line can be computed several vertices at a time.  A triangle clipped
+// to a single cell has at most 7 vertices.
+static const int RC_CLIP_MAX_VERTS = 8;
+
+struct rcClipPoly
+{
+	float v[3][RC_CLIP_MAX_VERTS];	///< The vertex coordinates. [(axis, vertex)]
+	int n;							///< The number of vertices.
+};
+
+// Computes the distance of each vertex to the line, and returns the vertices at
+// or below it in 'below' and the vertices on it in 'on' as bit masks.  The SSE2
+// path fills all RC_CLIP_MAX_VERTS distances and masks off the unused slots.
+inline void classifyPoly(const rcClipPoly& p, const float x, const int axis,
+						 float* d, int& below, int& on)
+{
+#ifdef RC_RASTERIZATION_SSE2
+	const __m128 line = _mm_set1_ps(x);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 d0 = _mm_sub_ps(line, _mm_loadu_ps(&p.v[axis][0]));
+	const __m128 d1 = _mm_sub_ps(line, _mm_loadu_ps(&p.v[axis][4]));
+	_mm_storeu_ps(d, d0);
+	_mm_storeu_ps(d+4, d1);
+	below = _mm_movemask_ps(_mm_cmpge_ps(d0, zero)) | (_mm_movemask_ps(_mm_cmpge_ps(d1, zero)) << 4);
+	on = _mm_movemask_ps(_mm_cmpeq_ps(d0, zero)) | (_mm_movemask_ps(_mm_cmpeq_ps(d1, zero)) << 4);
+#else
+	below = 0;
+	on = 0;
+	for (int i = 0; i < p.n; ++i)
+	{
+		d[i] = x - p.v[axis][i];
+		if (d[i] >= 0) below |= 1 << i;
+		if (d[i] == 0) on |= 1 << i;
+	}
+#endif
+	const int mask = (1 << p.n) - 1;
+	below &= mask;
+	on &= mask;
+}
+
+inline void copyVert(rcClipPoly& dst, const int i, const rcClipPoly& src, const int j)
 {
-	float d[12];
-	for (int i = 0; i < nin; ++i)
-		d[i] = x - in[i*3+axis];
+	dst.v[0][i] = src.v[0][j];
+	dst.v[1][i] = src.v[1][j];
+	dst.v[2][i] = src.v[2][j];
+}
 
+// divides a convex polygons into two convex polygons on both sides of a line
+// using the distances from classifyPoly().
+static void dividePoly(const rcClipPoly& in, const float* d, rcClipPoly& out1, rcClipPoly& out2)
+{
+	const int nin = in.n;
 	int m = 0, n = 0;
 	for (int i = 0, j = nin-1; i < nin; j=i, ++i)
 	{
@@ -198,22 +252,22 @@ static void dividePoly(const float* in, int nin,
 		if (ina != inb)
 		{
 			float s = d[j] / (d[j] - d[i]);
-			out1[m*3+0] = in[j*3+0] + (in[i*3+0] - in[j*3+0])*s;
-			out1[m*3+1] = in[j*3+1] + (in[i*3+1] - in[j*3+1])*s;
-			out1[m*3+2] = in[j*3+2] + (in[i*3+2] - in[j*3+2])*s;
-			rcVcopy(out2 + n*3, out1 + m*3);
+			out1.v[0][m] = in.v[0][j] + (in.v[0][i] - in.v[0][j])*s;
+			out1.v[1][m] = in.v[1][j] + (in.v[1][i] - in.v[1][j])*s;
+			out1.v[2][m] = in.v[2][j] + (in.v[2][i] - in.v[2][j])*s;
+			copyVert(out2, n, out1, m);
 			m++;
 			n++;
 			// add the i'th point to the right polygon. Do NOT add points that are on the dividing line
 			// since these were already added above
 			if (d[i] > 0)
 			{
-				rcVcopy(out1 + m*3, in + i*3);
+				copyVert(out1, m, in, i);
 				m++;
 			}
 			else if (d[i] < 0)
 			{
-				rcVcopy(out2 + n*3, in + i*3);
+				copyVert(out2, n, in, i);
 				n++;
 			}
 		}
@@ -222,27 +276,58 @@ static void dividePoly(const float* in, int nin,
 			// add the i'th point to the right polygon. Addition is done even for points on the dividing line
 			if (d[i] >= 0)
 			{
-				rcVcopy(out1 + m*3, in + i*3);
+				copyVert(out1, m, in, i);
 				m++;
 				if (d[i] != 0)
 					continue;
 			}
-			rcVcopy(out2 + n*3, in + i*3);
+			copyVert(out2, n, in, i);
 			n++;
 		}
 	}
 
-	*nout1 = m;
-	*nout2 = n;
+	out1.n = m;
+	out2.n = n;
 }
 
+// Splits the polygon at the line.  Polygons that lie entirely on one side of
+// the line are not copied: 'cell' is set to the part at or below the line,
+// 'rest' to the remainder.  (Either may point to 'in'.)  The results are the
+// same as dividing the polygon.
+inline void splitPoly(rcClipPoly*& in, rcClipPoly*& out1, rcClipPoly*& out2,
+					  const float x, const int axis,
+					  rcClipPoly*& cell, bool& last)
+{
+	float d[RC_CLIP_MAX_VERTS];
+	int below, on;
+	classifyPoly(*in, x, axis, d, below, on);
 
+	const int all = (1 << in->n) - 1;
+	last = false;
+	if (!below)
+	{
+		// Nothing at or below the line, the remainder is unchanged.
+		cell = 0;
+	}
+	else if (below == all && !on)
+	{
+		// Everything is below the line, nothing remains.
+		cell = in;
+		last = true;
+	}
+	else
+	{
+		dividePoly(*in, d, *out1, *out2);
+		rcSwap(in, out2);
+		cell = out1;
+	}
+}
 
 static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
 						 const unsigned char area, rcHeightfield& hf,
 						 const float* bmin, const float* bmax,
 						 const float cs, const float ics, const float ich,
-						 const int flagMergeThr)
+						 const int flagMergeThr, rcClipPoly* buf)
 {
 	const int w = hf.width;
 	const int h = hf.height;
@@ -268,56 +353,76 @@ static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
 	y1 = rcClamp(y1, 0, h-1);
 	
 	// Clip the triangle into all grid cells it touches.
-	float buf[7*3*4];
-	float *in = buf, *inrow = buf+7*3, *p1 = inrow+7*3, *p2 = p1+7*3;
+	rcClipPoly *in = &buf[0], *rest = &buf[1], *p1 = &buf[2], *p2 = &buf[3];
 
-	rcVcopy(&in[0], v0);
-	rcVcopy(&in[1*3], v1);
-	rcVcopy(&in[2*3], v2);
-	int nvrow, nvIn = 3;
+	for (int k = 0; k < 3; ++k)
+	{
+		in->v[k][0] = v0[k];
+		in->v[k][1] = v1[k];
+		in->v[k][2] = v2[k];
+	}
+	in->n = 3;
 	
 	for (int y = y0; y <= y1; ++y)
 	{
 		// Clip polygon to row. Store the remaining polygon as well
 		const float cz = bmin[2] + y*cs;
-		dividePoly(in, nvIn, inrow, &nvrow, p1, &nvIn, cz+cs, 2);
-		rcSwap(in, p1);
-		if (nvrow < 3) continue;
+		rcClipPoly* cell;
+		bool lastRow;
+		splitPoly(in, p1, rest, cz+cs, 2, cell, lastRow);
+		if (!cell || cell->n < 3)
+		{
+			if (lastRow) break;
+			continue;
+		}
 		
 		// find the horizontal bounds in the row
-		float minX = inrow[0], maxX = inrow[0];
-		for (int i=1; i<nvrow; ++i)
+		const float* rowx = cell->v[0];
+		float minX = rowx[0], maxX = rowx[0];
+		for (int i=1; i<cell->n; ++i)
 		{
-			if (minX > inrow[i*3])	minX = inrow[i*3];
-			if (maxX < inrow[i*3])	maxX = inrow[i*3];
+			if (minX > rowx[i])	minX = rowx[i];
+			if (maxX < rowx[i])	maxX = rowx[i];
 		}
 		int x0 = (int)((minX - bmin[0])*ics);
 		int x1 = (int)((maxX - bmin[0])*ics);
 		x0 = rcClamp(x0, 0, w-1);
 		x1 = rcClamp(x1, 0, w-1);
 
-		int nv, nv2 = nvrow;
+		// Clip the row using the buffers that do not hold the remaining polygon.
+		rcClipPoly* inrow = cell;
+		rcClipPoly* c1 = rest;
+		rcClipPoly* c2 = p2;
 
 		for (int x = x0; x <= x1; ++x)
 		{
 			// Clip polygon to column. store the remaining polygon as well
 			const float cx = bmin[0] + x*cs;
-			dividePoly(inrow, nv2, p1, &nv, p2, &nv2, cx+cs, 0);
-			rcSwap(inrow, p2);
-			if (nv < 3) continue;
+			rcClipPoly* span;
+			bool lastCol;
+			splitPoly(inrow, c1, c2, cx+cs, 0, span, lastCol);
+			if (!span || span->n < 3)
+			{
+				if (lastCol) break;
+				continue;
+			}
 			
 			// Calculate min and max of the span.
-			float smin = p1[1], smax = p1[1];
-			for (int i = 1; i < nv; ++i)
+			const float* sy = span->v[1];
+			float smin = sy[0], smax = sy[0];
+			for (int i = 1; i < span->n; ++i)
 			{
-				smin = rcMin(smin, p1[i*3+1]);
-				smax = rcMax(smax, p1[i*3+1]);
+				smin = rcMin(smin, sy[i]);
+				smax = rcMax(smax, sy[i]);
 			}
 			smin -= bmin[1];
 			smax -= bmin[1];
 			// Skip the span if it is outside the heightfield bbox
-			if (smax < 0.0f) continue;
-			if (smin > by) continue;
+			if (smax < 0.0f || smin > by)
+			{
+				if (lastCol) break;
+				continue;
+			}
 			// Clamp the span to the heightfield bbox.
 			if (smin < 0.0f) smin = 0;
 			if (smax > by) smax = by;
@@ -328,7 +433,11 @@ static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
 			
 			if (!addSpan(hf, x, y, ismin, ismax, area, flagMergeThr))
 				return false;
+
+			if (lastCol) break;
 		}
+
+		if (lastRow) break;
 	}
 
 	return true;
@@ -349,7 +458,11 @@ bool rcRasterizeTriangle(rcContext* ctx, const float* v0, const float* v1, const
 
 	const float ics = 1.0f/solid.cs;
 	const float ich = 1.0f/solid.ch;
-	if (!rasterizeTri(v0, v1, v2, area, solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr))
+	// Clip buffers shared by all triangles.  (Cleared so the unused vertex
+	// slots read by the vector path are always initialized.)
+	rcClipPoly buf[4];
+	memset(buf, 0, sizeof(buf));
+	if (!rasterizeTri(v0, v1, v2, area, solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr, buf))
 	{
 		ctx->log(RC_LOG_ERROR, "rcRasterizeTriangle: Out of memory.");
 		return false;
@@ -373,6 +486,10 @@ bool rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 	
 	const float ics = 1.0f/solid.cs;
 	const float ich = 1.0f/solid.ch;
+	// Clip buffers shared by all triangles.  (Cleared so the unused vertex
+	// slots read by the vector path are always initialized.)
+	rcClipPoly buf[4];
+	memset(buf, 0, sizeof(buf));
 	// Rasterize triangles.
 	for (int i = 0; i < nt; ++i)
 	{
@@ -380,7 +497,7 @@ bool rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 		const float* v1 = &verts[tris[i*3+1]*3];
 		const float* v2 = &verts[tris[i*3+2]*3];
 		// Rasterize.
-		if (!rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr))
+		if (!rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr, buf))
 		{
 			ctx->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
 			return false;
@@ -405,6 +522,10 @@ bool rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 	
 	const float ics = 1.0f/solid.cs;
 	const float ich = 1.0f/solid.ch;
+	// Clip buffers shared by all triangles.  (Cleared so the unused vertex
+	// slots read by the vector path are always initialized.)
+	rcClipPoly buf[4];
+	memset(buf, 0, sizeof(buf));
 	// Rasterize triangles.
 	for (int i = 0; i < nt; ++i)
 	{
@@ -412,7 +533,7 @@ bool rcRasterizeTriangles(rcContext* ctx, const float* verts, const int /*nv*/,
 		const float* v1 = &verts[tris[i*3+1]*3];
 		const float* v2 = &verts[tris[i*3+2]*3];
 		// Rasterize.
-		if (!rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr))
+		if (!rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr, buf))
 		{
 			ctx->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
 			return false;
@@ -436,6 +557,10 @@ bool rcRasterizeTriangles(rcContext* ctx, const float* verts, const unsigned cha
 	
 	const float ics = 1.0f/solid.cs;
 	const float ich = 1.0f/solid.ch;
+	// Clip buffers shared by all triangles.  (Cleared so the unused vertex
+	// slots read by the vector path are always initialized.)
+	rcClipPoly buf[4];
+	memset(buf, 0, sizeof(buf));
 	// Rasterize triangles.
 	for (int i = 0; i < nt; ++i)
 	{
@@ -443,7 +568,7 @@ bool rcRasterizeTriangles(rcContext* ctx, const float* verts, const unsigned cha
 		const float* v1 = &verts[(i*3+1)*3];
 		const float* v2 = &verts[(i*3+2)*3];
 		// Rasterize.
-		if (!rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr))
+		if (!rasterizeTri(v0, v1, v2, areas[i], solid, solid.bmin, solid.bmax, solid.cs, ics, ich, flagMergeThr, buf))
 		{
 			ctx->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
 			return false;
@@ -26,154 +26,247 @@
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
 #include <new>
+#include <atomic>
+#include <thread>
 
 
-static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist)
+// The columns processed between progress updates in the distance field passes.
+static const int RC_DIST_BLOCK = 64;
+
+struct rcDistanceFieldJob
+{
+	const rcCompactHeightfield* chf;
+	const unsigned int* cons;
+	unsigned short* src;
+	unsigned short* dst;
+	int thr;
+	std::atomic<int>* progress;	// Per row.  The columns finished by the running pass.
+};
+
+static void waitForProgress(const std::atomic<int>& progress, const int count)
+{
+	while (progress.load(std::memory_order_acquire) < count)
+		std::this_thread::yield();
+}
+
+// Resets the distance of the spans in row y, and marks the boundary spans.
+static void markBoundaryRow(const rcCompactHeightfield& chf, const unsigned int* cons,
+							unsigned short* src, const int y)
 {
 	const int w = chf.width;
-	const int h = chf.height;
-	
-	// Init distance and points.
-	for (int i = 0; i < chf.spanCount; ++i)
-		src[i] = 0xffff;
 	
-	// Mark boundary cells.
-	for (int y = 0; y < h; ++y)
+	for (int x = 0; x < w; ++x)
 	{
-		for (int x = 0; x < w; ++x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const unsigned int s = cons[i];
+			const unsigned char area = chf.areas[i];
+			
+			int nc = 0;
+			for (int dir = 0; dir < 4; ++dir)
 			{
-				const rcCompactSpan& s = chf.spans[i];
-				const unsigned char area = chf.areas[i];
-				
-				int nc = 0;
-				for (int dir = 0; dir < 4; ++dir)
+				if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
 				{
-					if (rcGetCon(s, dir) != RC_NOT_CONNECTED)
-					{
-						const int ax = x + rcGetDirOffsetX(dir);
-						const int ay = y + rcGetDirOffsetY(dir);
-						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
-						if (area == chf.areas[ai])
-							nc++;
-					}
+					const int ax = x + rcGetDirOffsetX(dir);
+					const int ay = y + rcGetDirOffsetY(dir);
+					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
+					if (area == chf.areas[ai])
+						nc++;
 				}
-				if (nc != 4)
-					src[i] = 0;
 			}
+			src[i] = nc != 4 ? 0 : 0xffff;
 		}
 	}
+}
+
+// Pass 1 over the columns [x0, x1) of row y.  Reads the row below up to column x1.
+static void distanceForwardRow(const rcCompactHeightfield& chf, const unsigned int* cons,
+							   unsigned short* src, const int y, const int x0, const int x1)
+{
+	const int w = chf.width;
 	
-			
-	// Pass 1
-	for (int y = 0; y < h; ++y)
+	for (int x = x0; x < x1; ++x)
 	{
-		for (int x = 0; x < w; ++x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const unsigned int s = cons[i];
+			
+			if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
+				// (-1,0)
+				const int ax = x + rcGetDirOffsetX(0);
+				const int ay = y + rcGetDirOffsetY(0);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
+				const unsigned int as = cons[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
 				
-				if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
+				// (-1,-1)
+				if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
 				{
-					// (-1,0)
-					const int ax = x + rcGetDirOffsetX(0);
-					const int ay = y + rcGetDirOffsetY(0);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (-1,-1)
-					if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(3);
-						const int aay = ay + rcGetDirOffsetY(3);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(3);
+					const int aay = ay + rcGetDirOffsetY(3);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
-				if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+			}
+			if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+			{
+				// (0,-1)
+				const int ax = x + rcGetDirOffsetX(3);
+				const int ay = y + rcGetDirOffsetY(3);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
+				const unsigned int as = cons[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
+				
+				// (1,-1)
+				if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
 				{
-					// (0,-1)
-					const int ax = x + rcGetDirOffsetX(3);
-					const int ay = y + rcGetDirOffsetY(3);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (1,-1)
-					if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(2);
-						const int aay = ay + rcGetDirOffsetY(2);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(2);
+					const int aay = ay + rcGetDirOffsetY(2);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
 			}
 		}
 	}
+}
+
+// Pass 2 over the columns [x0, x1) of row y, right to left.  Reads the row above
+// down to column x0-1.
+static void distanceBackwardRow(const rcCompactHeightfield& chf, const unsigned int* cons,
+								unsigned short* src, const int y, const int x0, const int x1)
+{
+	const int w = chf.width;
 	
-	// Pass 2
-	for (int y = h-1; y >= 0; --y)
+	for (int x = x1-1; x >= x0; --x)
 	{
-		for (int x = w-1; x >= 0; --x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const unsigned int s = cons[i];
+			
+			if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
+				// (1,0)
+				const int ax = x + rcGetDirOffsetX(2);
+				const int ay = y + rcGetDirOffsetY(2);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
+				const unsigned int as = cons[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
 				
-				if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
+				// (1,1)
+				if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
 				{
-					// (1,0)
-					const int ax = x + rcGetDirOffsetX(2);
-					const int ay = y + rcGetDirOffsetY(2);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (1,1)
-					if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(1);
-						const int aay = ay + rcGetDirOffsetY(1);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(1);
+					const int aay = ay + rcGetDirOffsetY(1);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
-				if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+			}
+			if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+			{
+				// (0,1)
+				const int ax = x + rcGetDirOffsetX(1);
+				const int ay = y + rcGetDirOffsetY(1);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
+				const unsigned int as = cons[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
+				
+				// (-1,1)
+				if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
 				{
-					// (0,1)
-					const int ax = x + rcGetDirOffsetX(1);
-					const int ay = y + rcGetDirOffsetY(1);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (-1,1)
-					if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(0);
-						const int aay = ay + rcGetDirOffsetY(0);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(0);
+					const int aay = ay + rcGetDirOffsetY(0);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
 			}
 		}
-	}	
+	}
+}
+
+static void markBoundaryJob(void* data, int begin, int end)
+{
+	const rcDistanceFieldJob& job = *(const rcDistanceFieldJob*)data;
+	for (int y = begin; y < end; ++y)
+		markBoundaryRow(*job.chf, job.cons, job.src, y);
+}
+
+// Each item is a row, bottom to top.  A row runs one block behind the row below
+// it, so every span sees the same neighbor distances as in a serial sweep.
+static void distanceForwardJob(void* data, int begin, int end)
+{
+	const rcDistanceFieldJob& job = *(const rcDistanceFieldJob*)data;
+	const int w = job.chf->width;
+	for (int y = begin; y < end; ++y)
+	{
+		for (int x0 = 0; x0 < w; x0 += RC_DIST_BLOCK)
+		{
+			const int x1 = rcMin(x0+RC_DIST_BLOCK, w);
+			if (y > 0)
+				waitForProgress(job.progress[y-1], rcMin(x1+1, w));
+			distanceForwardRow(*job.chf, job.cons, job.src, y, x0, x1);
+			job.progress[y].store(x1, std::memory_order_release);
+		}
+	}
+}
+
+// Each item is a row, top to bottom.  Progress counts the columns finished from
+// the right.
+static void distanceBackwardJob(void* data, int begin, int end)
+{
+	const rcDistanceFieldJob& job = *(const rcDistanceFieldJob*)data;
+	const int w = job.chf->width;
+	const int h = job.chf->height;
+	for (int item = begin; item < end; ++item)
+	{
+		const int y = h-1 - item;
+		for (int x1 = w; x1 > 0; x1 -= RC_DIST_BLOCK)
+		{
+			const int x0 = rcMax(x1-RC_DIST_BLOCK, 0);
+			if (y < h-1)
+				waitForProgress(job.progress[y+1], rcMin(w-x0+1, w));
+			distanceBackwardRow(*job.chf, job.cons, job.src, y, x0, x1);
+			job.progress[y].store(w-x0, std::memory_order_release);
+		}
+	}
+}
+
+static void calculateDistanceField(rcContext* ctx, rcCompactHeightfield& chf, const unsigned int* cons,
+								   unsigned short* src, std::atomic<int>* progress, unsigned short& maxDist)
+{
+	const int h = chf.height;
+	
+	rcDistanceFieldJob job;
+	job.chf = &chf;
+	job.cons = cons;
+	job.src = src;
+	job.dst = 0;
+	job.thr = 0;
+	job.progress = progress;
+	
+	// Init distance and mark boundary cells.
+	ctx->parallelFor(markBoundaryJob, &job, h);
+	
+	// Pass 1
+	for (int y = 0; y < h; ++y)
+		progress[y].store(0, std::memory_order_relaxed);
+	ctx->parallelFor(distanceForwardJob, &job, h);
+	
+	// Pass 2
+	for (int y = 0; y < h; ++y)
+		progress[y].store(0, std::memory_order_relaxed);
+	ctx->parallelFor(distanceBackwardJob, &job, h);
 	
 	maxDist = 0;
 	for (int i = 0; i < chf.spanCount; ++i)
@@ -181,22 +274,24 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 	
 }
 
-static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
-							   unsigned short* src, unsigned short* dst)
+static void boxBlurJob(void* data, int begin, int end)
 {
+	const rcDistanceFieldJob& job = *(const rcDistanceFieldJob*)data;
+	const rcCompactHeightfield& chf = *job.chf;
+	const unsigned int* cons = job.cons;
+	const unsigned short* src = job.src;
+	unsigned short* dst = job.dst;
+	const int thr = job.thr;
 	const int w = chf.width;
-	const int h = chf.height;
-	
-	thr *= 2;
 	
-	for (int y = 0; y < h; ++y)
+	for (int y = begin; y < end; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
 			const rcCompactCell& c = chf.cells[x+y*w];
 			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 			{
-				const rcCompactSpan& s = chf.spans[i];
+				const unsigned int s = cons[i];
 				const unsigned short cd = src[i];
 				if (cd <= thr)
 				{
@@ -214,7 +309,7 @@ static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
 						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
 						d += (int)src[ai];
 						
-						const rcCompactSpan& as = chf.spans[ai];
+						const unsigned int as = cons[ai];
 						const int dir2 = (dir+1) & 0x3;
 						if (rcGetCon(as, dir2) != RC_NOT_CONNECTED)
 						{
@@ -237,13 +332,28 @@ static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
 			}
 		}
 	}
+}
+
+static unsigned short* boxBlur(rcContext* ctx, rcCompactHeightfield& chf, const unsigned int* cons, int thr,
+							   unsigned short* src, unsigned short* dst)
+{
+	rcDistanceFieldJob job;
+	job.chf = &chf;
+	job.cons = cons;
+	job.src = src;
+	job.dst = dst;
+	job.thr = thr*2;
+	job.progress = 0;
+	
+	ctx->parallelFor(boxBlurJob, &job, chf.height);
+	
 	return dst;
 }
 
 
 static bool floodRegion(int x, int y, int i,
 						unsigned short level, unsigned short r,
-						rcCompactHeightfield& chf,
+						rcCompactHeightfield& chf, const unsigned int* cons,
 						unsigned short* srcReg, unsigned short* srcDist,
 						rcIntArray& stack)
 {
@@ -268,7 +378,7 @@ static bool floodRegion(int x, int y, int i,
 		int cy = stack.pop();
 		int cx = stack.pop();
 		
-		const rcCompactSpan& cs = chf.spans[ci];
+		const unsigned int cs = cons[ci];
 		
 		// Check if any of the neighbours already have a valid region set.
 		unsigned short ar = 0;
@@ -291,7 +401,7 @@ static bool floodRegion(int x, int y, int i,
 					break;
 				}
 				
-				const rcCompactSpan& as = chf.spans[ai];
+				const unsigned int as = cons[ai];
 				
 				const int dir2 = (dir+1) & 0x3;
 				if (rcGetCon(as, dir2) != RC_NOT_CONNECTED)
@@ -343,12 +453,71 @@ static bool floodRegion(int x, int y, int i,
 	return count > 0;
 }
 
-static unsigned short* expandRegions(int maxIter, unsigned short level,
-									 rcCompactHeightfield& chf,
-									 unsigned short* srcReg, unsigned short* srcDist,
-									 unsigned short* dstReg, unsigned short* dstDist, 
-									 rcIntArray& stack,
-									 bool fillStack)
+// The stack entries per item of the region expansion job.
+static const int RC_EXPAND_BLOCK = 1024;
+
+struct rcExpandJob
+{
+	const rcCompactHeightfield* chf;
+	const unsigned int* cons;
+	const unsigned short* srcReg;
+	const unsigned short* srcDist;
+	const int* stack;
+	int stackSize;
+	int* result;	// Per stack entry.  The region and distance found, packed, or zero.
+};
+
+// Finds the region each entry of the stack can join.  Only reads the regions, so
+// the entries can be processed in any order.
+static void expandJob(void* data, int begin, int end)
+{
+	const rcExpandJob& job = *(const rcExpandJob*)data;
+	const rcCompactHeightfield& chf = *job.chf;
+	const unsigned int* cons = job.cons;
+	const unsigned short* srcReg = job.srcReg;
+	const unsigned short* srcDist = job.srcDist;
+	const int w = chf.width;
+	
+	const int jend = rcMin(end*RC_EXPAND_BLOCK*3, job.stackSize);
+	for (int j = begin*RC_EXPAND_BLOCK*3; j < jend; j += 3)
+	{
+		int x = job.stack[j+0];
+		int y = job.stack[j+1];
+		int i = job.stack[j+2];
+		job.result[j/3] = 0;
+		if (i < 0)
+			continue;
+		
+		unsigned short r = srcReg[i];
+		unsigned short d2 = 0xffff;
+		const unsigned char area = chf.areas[i];
+		const unsigned int s = cons[i];
+		for (int dir = 0; dir < 4; ++dir)
+		{
+			if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
+			const int ax = x + rcGetDirOffsetX(dir);
+			const int ay = y + rcGetDirOffsetY(dir);
+			const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
+			if (chf.areas[ai] != area) continue;
+			if (srcReg[ai] > 0 && (srcReg[ai] & RC_BORDER_REG) == 0)
+			{
+				if ((int)srcDist[ai]+2 < (int)d2)
+				{
+					r = srcReg[ai];
+					d2 = srcDist[ai]+2;
+				}
+			}
+		}
+		if (r)
+			job.result[j/3] = (int)(((unsigned int)r << 16) | d2);
+	}
+}
+
+static void expandRegions(rcContext* ctx, int maxIter, unsigned short level,
+						  rcCompactHeightfield& chf, const unsigned int* cons,
+						  unsigned short* srcReg, unsigned short* srcDist,
+						  rcIntArray& stack, rcIntArray& result,
+						  bool fillStack)
 {
 	const int w = chf.width;
 	const int h = chf.height;
@@ -390,45 +559,29 @@ static unsigned short* expandRegions(int maxIter, unsigned short level,
 	{
 		int failed = 0;
 		
-		memcpy(dstReg, srcReg, sizeof(unsigned short)*chf.spanCount);
-		memcpy(dstDist, srcDist, sizeof(unsigned short)*chf.spanCount);
+		// Find the new regions against the current ones, then apply them.  (Instead
+		// of copying the whole field to a second buffer each time.)
+		result.resize(stack.size()/3);
+		
+		rcExpandJob job;
+		job.chf = &chf;
+		job.cons = cons;
+		job.srcReg = srcReg;
+		job.srcDist = srcDist;
+		job.stack = &stack[0];
+		job.stackSize = stack.size();
+		job.result = &result[0];
+		ctx->parallelFor(expandJob, &job, (stack.size()/3 + RC_EXPAND_BLOCK-1) / RC_EXPAND_BLOCK);
 		
 		for (int j = 0; j < stack.size(); j += 3)
 		{
-			int x = stack[j+0];
-			int y = stack[j+1];
-			int i = stack[j+2];
-			if (i < 0)
-			{
-				failed++;
-				continue;
-			}
-			
-			unsigned short r = srcReg[i];
-			unsigned short d2 = 0xffff;
-			const unsigned char area = chf.areas[i];
-			const rcCompactSpan& s = chf.spans[i];
-			for (int dir = 0; dir < 4; ++dir)
-			{
-				if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
-				const int ax = x + rcGetDirOffsetX(dir);
-				const int ay = y + rcGetDirOffsetY(dir);
-				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
-				if (chf.areas[ai] != area) continue;
-				if (srcReg[ai] > 0 && (srcReg[ai] & RC_BORDER_REG) == 0)
-				{
-					if ((int)srcDist[ai]+2 < (int)d2)
-					{
-						r = srcReg[ai];
-						d2 = srcDist[ai]+2;
-					}
-				}
-			}
+			const unsigned int r = (unsigned int)result[j/3];
 			if (r)
 			{
+				const int i = stack[j+2];
 				stack[j+2] = -1; // mark as used
-				dstReg[i] = r;
-				dstDist[i] = d2;
+				srcReg[i] = (unsigned short)(r >> 16);
+				srcDist[i] = (unsigned short)(r & 0xffff);
 			}
 			else
 			{
@@ -436,10 +589,6 @@ static unsigned short* expandRegions(int maxIter, unsigned short level,
 			}
 		}
 		
-		// rcSwap source and dest.
-		rcSwap(srcReg, dstReg);
-		rcSwap(srcDist, dstDist);
-		
 		if (failed*3 == stack.size())
 			break;
 		
@@ -450,27 +599,24 @@ static unsigned short* expandRegions(int maxIter, unsigned short level,
 				break;
 		}
 	}
-	
-	return srcReg;
 }
 
 
 
-static void sortCellsByLevel(unsigned short startLevel,
-							  rcCompactHeightfield& chf,
-							  unsigned short* srcReg,
-							  unsigned int nbStacks, rcIntArray* stacks,
-							  unsigned short loglevelsPerStack) // the levels per stack (2 in our case) as a bit shift
+// The most row bands the level sort splits the field into.
+static const int RC_MAX_SORT_BANDS = 64;
+
+// Puts the cells of rows [y0, y1) that are in the level range into the appropriate stacks.
+static void sortRowsByLevel(int startLevel,
+							const rcCompactHeightfield& chf,
+							const unsigned short* srcReg,
+							unsigned int nbStacks, rcIntArray* stacks,
+							unsigned short loglevelsPerStack,
+							const int y0, const int y1)
 {
 	const int w = chf.width;
-	const int h = chf.height;
-	startLevel = startLevel >> loglevelsPerStack;
 
-	for (unsigned int j=0; j<nbStacks; ++j)
-		stacks[j].resize(0);
-
-	// put all cells in the level range into the appropriate stacks
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -495,6 +641,76 @@ static void sortCellsByLevel(unsigned short startLevel,
 	}
 }
 
+struct rcLevelSortJob
+{
+	const rcCompactHeightfield* chf;
+	const unsigned short* srcReg;
+	int startLevel;
+	unsigned int nbStacks;
+	unsigned short loglevelsPerStack;
+	int bandHeight;
+	rcIntArray* bandStacks;	// nbStacks per band.
+};
+
+static void sortBandsByLevelJob(void* data, int begin, int end)
+{
+	const rcLevelSortJob& job = *(const rcLevelSortJob*)data;
+	for (int b = begin; b < end; ++b)
+	{
+		rcIntArray* stacks = &job.bandStacks[b*job.nbStacks];
+		for (unsigned int j=0; j<job.nbStacks; ++j)
+			stacks[j].resize(0);
+		const int y0 = b*job.bandHeight;
+		const int y1 = rcMin(y0+job.bandHeight, job.chf->height);
+		sortRowsByLevel(job.startLevel, *job.chf, job.srcReg, job.nbStacks, stacks, job.loglevelsPerStack, y0, y1);
+	}
+}
+
+static void sortCellsByLevel(rcContext* ctx, unsigned short startLevel,
+							  rcCompactHeightfield& chf,
+							  unsigned short* srcReg,
+							  unsigned int nbStacks, rcIntArray* stacks,
+							  unsigned short loglevelsPerStack, // the levels per stack (2 in our case) as a bit shift
+							  rcIntArray* bandStacks, int nbands)
+{
+	const int h = chf.height;
+	startLevel = startLevel >> loglevelsPerStack;
+
+	for (unsigned int j=0; j<nbStacks; ++j)
+		stacks[j].resize(0);
+
+	if (nbands <= 1)
+	{
+		sortRowsByLevel(startLevel, chf, srcReg, nbStacks, stacks, loglevelsPerStack, 0, h);
+		return;
+	}
+
+	rcLevelSortJob job;
+	job.chf = &chf;
+	job.srcReg = srcReg;
+	job.startLevel = startLevel;
+	job.nbStacks = nbStacks;
+	job.loglevelsPerStack = loglevelsPerStack;
+	job.bandHeight = (h + nbands-1) / nbands;
+	job.bandStacks = bandStacks;
+	nbands = (h + job.bandHeight-1) / job.bandHeight;
+	ctx->parallelFor(sortBandsByLevelJob, &job, nbands);
+
+	// Append the bands in row order, so the stacks are the same as from a single sweep.
+	for (int b = 0; b < nbands; ++b)
+	{
+		for (unsigned int j=0; j<nbStacks; ++j)
+		{
+			rcIntArray& src = bandStacks[b*nbStacks+j];
+			if (src.size() == 0)
+				continue;
+			const int n = stacks[j].size();
+			stacks[j].resize(n + src.size());
+			memcpy(&stacks[j][n], &src[0], sizeof(int)*src.size());
+		}
+	}
+}
+
 
 static void appendStacks(rcIntArray& srcStack, rcIntArray& dstStack,
 						 unsigned short* srcReg)
@@ -1252,6 +1468,9 @@ static bool mergeAndFilterLayerRegions(rcContext* ctx, int minRegionArea,
 /// After this step, the distance data is available via the rcCompactHeightfield::maxDistance
 /// and rcCompactHeightfield::dist fields.
 ///
+/// The passes run on the context's threads. (See: rcContext::parallelFor)  The result does
+/// not depend on the thread count.
+///
 /// @see rcCompactHeightfield, rcBuildRegions, rcBuildRegionsMonotone
 bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 {
@@ -1278,13 +1497,32 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 		rcFree(src);
 		return false;
 	}
+	rcScopedDelete<unsigned int> tempCons(chf.cons ? 0 : rcCopyCompactSpanCons(chf));
+	const unsigned int* cons = chf.cons ? chf.cons : (const unsigned int*)tempCons;
+	if (!cons)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'cons' (%d).", chf.spanCount);
+		rcFree(src);
+		rcFree(dst);
+		return false;
+	}
+	rcScopedDelete<std::atomic<int> > progress((std::atomic<int>*)rcAlloc(sizeof(std::atomic<int>)*chf.height, RC_ALLOC_TEMP));
+	if (!progress)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'progress' (%d).", chf.height);
+		rcFree(src);
+		rcFree(dst);
+		return false;
+	}
+	for (int y = 0; y < chf.height; ++y)
+		new (&progress[y]) std::atomic<int>(0);
 	
 	unsigned short maxDist = 0;
 
 	{
 		rcScopedTimer timerDist(ctx, RC_TIMER_BUILD_DISTANCEFIELD_DIST);
 
-		calculateDistanceField(chf, src, maxDist);
+		calculateDistanceField(ctx, chf, cons, src, progress, maxDist);
 		chf.maxDistance = maxDist;
 	}
 
@@ -1292,7 +1530,7 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 		rcScopedTimer timerBlur(ctx, RC_TIMER_BUILD_DISTANCEFIELD_BLUR);
 
 		// Blur
-		if (boxBlur(chf, 1, src, dst) != src)
+		if (boxBlur(ctx, chf, cons, 1, src, dst) != src)
 			rcSwap(src, dst);
 
 		// Store distance.
@@ -1522,6 +1760,10 @@ bool rcBuildRegionsMonotone(rcContext* ctx, rcCompactHeightfield& chf,
 /// The region data will be available via the rcCompactHeightfield::maxRegions
 /// and rcCompactSpan::reg fields.
 /// 
+/// The level sort and region expansion run on the context's threads. (See: rcContext::parallelFor)
+/// Region ids are assigned by the flood fill, which stays serial, so the result does not depend
+/// on the thread count.
+/// 
 /// @warning The distance field must be created using #rcBuildDistanceField before attempting to build regions.
 /// 
 /// @see rcCompactHeightfield, rcCompactSpan, rcBuildDistanceField, rcBuildRegionsMonotone, rcConfig
@@ -1535,10 +1777,17 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 	const int w = chf.width;
 	const int h = chf.height;
 	
-	rcScopedDelete<unsigned short> buf((unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount*4, RC_ALLOC_TEMP));
+	rcScopedDelete<unsigned short> buf((unsigned short*)rcAlloc(sizeof(unsigned short)*chf.spanCount*2, RC_ALLOC_TEMP));
 	if (!buf)
 	{
-		ctx->log(RC_LOG_ERROR, "rcBuildRegions: Out of memory 'tmp' (%d).", chf.spanCount*4);
+		ctx->log(RC_LOG_ERROR, "rcBuildRegions: Out of memory 'tmp' (%d).", chf.spanCount*2);
+		return false;
+	}
+	rcScopedDelete<unsigned int> tempCons(chf.cons ? 0 : rcCopyCompactSpanCons(chf));
+	const unsigned int* cons = chf.cons ? chf.cons : (const unsigned int*)tempCons;
+	if (!cons)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildRegions: Out of memory 'cons' (%d).", chf.spanCount);
 		return false;
 	}
 	
@@ -1552,11 +1801,14 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 
 	rcIntArray stack(1024);
 	rcIntArray visited(1024);
+	rcIntArray result(1024);
+	
+	// Per row band work stacks for the level sort, when it can run on several threads.
+	rcIntArray bandStacks[RC_MAX_SORT_BANDS*NB_STACKS];
+	const int nbands = ctx->getThreadCount() > 1 ? rcMin(ctx->getThreadCount()*4, RC_MAX_SORT_BANDS) : 1;
 	
 	unsigned short* srcReg = buf;
 	unsigned short* srcDist = buf+chf.spanCount;
-	unsigned short* dstReg = buf+chf.spanCount*2;
-	unsigned short* dstDist = buf+chf.spanCount*3;
 	
 	memset(srcReg, 0, sizeof(unsigned short)*chf.spanCount);
 	memset(srcDist, 0, sizeof(unsigned short)*chf.spanCount);
@@ -1594,7 +1846,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 //		ctx->startTimer(RC_TIMER_DIVIDE_TO_LEVELS);
 
 		if (sId == 0)
-			sortCellsByLevel(level, chf, srcReg, NB_STACKS, lvlStacks, 1);
+			sortCellsByLevel(ctx, level, chf, srcReg, NB_STACKS, lvlStacks, 1, bandStacks, nbands);
 		else 
 			appendStacks(lvlStacks[sId-1], lvlStacks[sId], srcReg); // copy left overs from last level
 
@@ -1604,11 +1856,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 			rcScopedTimer timerExpand(ctx, RC_TIMER_BUILD_REGIONS_EXPAND);
 
 			// Expand current regions until no empty connected cells found.
-			if (expandRegions(expandIters, level, chf, srcReg, srcDist, dstReg, dstDist, lvlStacks[sId], false) != srcReg)
-			{
-				rcSwap(srcReg, dstReg);
-				rcSwap(srcDist, dstDist);
-			}
+			expandRegions(ctx, expandIters, level, chf, cons, srcReg, srcDist, lvlStacks[sId], result, false);
 		}
 		
 		{
@@ -1622,7 +1870,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 				int i = lvlStacks[sId][j+2];
 				if (i >= 0 && srcReg[i] == 0)
 				{
-					if (floodRegion(x, y, i, level, regionId, chf, srcReg, srcDist, stack))
+					if (floodRegion(x, y, i, level, regionId, chf, cons, srcReg, srcDist, stack))
 					{
 						if (regionId == 0xFFFF)
 						{
@@ -1638,11 +1886,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 	}
 	
 	// Expand current regions until no empty connected cells found.
-	if (expandRegions(expandIters*8, 0, chf, srcReg, srcDist, dstReg, dstDist, stack, true) != srcReg)
-	{
-		rcSwap(srcReg, dstReg);
-		rcSwap(srcDist, dstDist);
-	}
+	expandRegions(ctx, expandIters*8, 0, chf, cons, srcReg, srcDist, stack, result, true);
 	
 	ctx->stopTimer(RC_TIMER_BUILD_REGIONS_WATERSHED);
 	